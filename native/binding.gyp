@@ -8,7 +8,19 @@
         "src/addon.cpp",
         "src/window_detector.cpp",
         "src/text_injector.cpp",
-        "src/hotkey_manager.cpp"
+        "src/hotkey_manager.cpp",
+        "src/display_pool.cpp",
+        "src/injection_queue.cpp",
+        "src/injection_strategy.cpp",
+        "src/aho_corasick.cpp",
+        "src/context_matcher.cpp",
+        "src/gesture_engine.cpp",
+        "src/latency_metrics.cpp",
+        "src/snippet_matcher.cpp",
+        "src/phrase_rewriter.cpp",
+        "src/script_detector.cpp",
+        "src/language_model.cpp",
+        "src/text_metrics.cpp"
       ],
       "include_dirs": [
         "<!@(node -p \"require('node-addon-api').include\")",
@@ -20,7 +32,8 @@
           "sources": [
             "src/window_detector_win.cpp",
             "src/text_injector_win.cpp",
-            "src/hotkey_manager_win.cpp"
+            "src/hotkey_manager_win.cpp",
+            "src/mapped_file_win.cpp"
           ],
           "libraries": [
             "-luser32.lib",
@@ -38,7 +51,8 @@
           "sources": [
             "src/window_detector_mac.mm",
             "src/text_injector_mac.mm",
-            "src/hotkey_manager_mac.mm"
+            "src/hotkey_manager_mac.mm",
+            "src/mapped_file_posix.cpp"
           ],
           "xcode_settings": {
             "GCC_ENABLE_CPP_EXCEPTIONS": "YES",
@@ -58,11 +72,22 @@
           "sources": [
             "src/window_detector_linux.cpp",
             "src/text_injector_linux.cpp",
-            "src/hotkey_manager_linux.cpp"
+            "src/hotkey_manager_linux.cpp",
+            "src/display_pool_linux.cpp",
+            "src/input_reactor_linux.cpp",
+            "src/clipboard_owner_linux.cpp",
+            "src/typing_engine_linux.cpp",
+            "src/keysym_unicode_linux.cpp",
+            "src/input_backend_linux.cpp",
+            "src/evdev_keys_linux.cpp",
+            "src/evdev_reactor_linux.cpp",
+            "src/uinput_keyboard_linux.cpp",
+            "src/mapped_file_posix.cpp"
           ],
           "libraries": [
             "-lX11",
-            "-lXtst"
+            "-lXtst",
+            "-lXi"
           ],
           "cflags_cc": ["-std=c++17"]
         }]
@@ -7,11 +7,73 @@ export interface ActiveWindowInfo {
   isValid: boolean;
 }
 
+export type AppContextRuleKind =
+  | 'process'
+  | 'bundle'
+  | 'web'
+  | 'browserProcess'
+  | 'browserBundle';
+
+export interface SnippetDefinition {
+  id: string;
+  triggers: string[];
+  value: string;
+}
+
+/** A trigger occurrence; start and end are JS string offsets. */
+export interface SnippetMatch {
+  id: string;
+  value: string;
+  start: number;
+  end: number;
+}
+
+export interface SnippetStreamResult {
+  /** Matches decided since the previous append; they never change again. */
+  committed: SnippetMatch[];
+  /** How the undecided tail resolves if the text ended here. */
+  pending: SnippetMatch[];
+  /** Total text length fed so far. */
+  length: number;
+}
+
+export interface AppContextRule {
+  kind: AppContextRuleKind;
+  context: string;
+  appName: string;
+  pattern: string;
+}
+
+export interface AppContextMatch {
+  ruleIndex: number;
+  context: string;
+  appName: string;
+  confidence: 'high' | 'medium' | 'low';
+}
+
+export interface WatchedWindowInfo extends ActiveWindowInfo {
+  context?: AppContextMatch;
+}
+
 export interface InjectionResult {
   success: boolean;
   error: string;
 }
 
+export interface InjectionPromise extends Promise<InjectionResult> {
+  injectionId: number;
+}
+
+export interface InjectionAppStats {
+  processName: string;
+  clipboardSamples: number;
+  clipboardLatencyMs: number;
+  clipboardSuccessRate: number;
+  directSamples: number;
+  directPerCharMs: number;
+  directSuccessRate: number;
+}
+
 export interface HotkeyInfo {
   modifiers: number;
   keyCode: number;
@@ -20,13 +82,20 @@ export interface HotkeyInfo {
 
 export type InjectionMethod = 'clipboard' | 'direct' | 'auto';
 
-export type WindowChangeCallback = (info: ActiveWindowInfo) => void;
+export type WindowChangeCallback = (info: WatchedWindowInfo) => void;
 
-export type HotkeyCallback = () => void;
+export type WindowTitleCallback = (title: string, context?: AppContextMatch) => void;
+
+// Event timestamps are milliseconds on the monotonic clock behind
+// process.hrtime(), taken from the OS input event rather than delivery time.
+export type HotkeyCallback = (timestamp: number) => void;
 
 export function getActiveWindow(): ActiveWindowInfo;
 
-export function startWindowWatcher(callback: WindowChangeCallback): boolean;
+export function startWindowWatcher(
+  callback: WindowChangeCallback,
+  onTitleChange?: WindowTitleCallback
+): boolean;
 
 export function stopWindowWatcher(): void;
 
@@ -34,6 +103,18 @@ export function injectText(text: string, method?: InjectionMethod): InjectionRes
 
 export function injectTextWithDelay(text: string, delayMs: number): InjectionResult;
 
+export function injectTextAsync(text: string, method?: InjectionMethod): InjectionPromise;
+
+export function injectTextWithDelayAsync(text: string, delayMs: number): InjectionPromise;
+
+export function cancelInjection(id: number): boolean;
+
+export function cancelAllInjections(): number;
+
+export function setInjectionStatsPath(path: string): boolean;
+
+export function getInjectionStats(): InjectionAppStats[];
+
 export function pasteFromClipboard(): InjectionResult;
 
 export function setClipboardText(text: string): boolean;
@@ -52,8 +133,8 @@ export function parseAccelerator(accelerator: string): HotkeyInfo;
 export type DoubleTapEvent = 'double-tap';
 export type HoldEvent = 'hold-start' | 'hold-end';
 
-export type DoubleTapCallback = (event: DoubleTapEvent) => void;
-export type HoldEventCallback = (event: HoldEvent, duration?: number) => void;
+export type DoubleTapCallback = (event: DoubleTapEvent, timestamp: number) => void;
+export type HoldEventCallback = (event: HoldEvent, duration: number, timestamp: number) => void;
 
 export function registerDoubleTapListener(
   key: string,
@@ -70,8 +151,198 @@ export function unregisterDoubleTapListener(id: number): boolean;
 
 export function unregisterHoldListener(id: number): boolean;
 
+// 'gesture' when a gesture ending in a tap completes; gestures ending in a
+// hold report 'hold-start' and 'hold-end' instead.
+export type GestureEvent = 'gesture' | 'hold-start' | 'hold-end';
+
+export type GestureCallback = (event: GestureEvent, duration: number, timestamp: number) => void;
+
+// Steps are separated by "," or "then", chord keys joined with "+", and a
+// step may end with a dash-joined tap/hold list; "within <n>ms" bounds the
+// gap between steps (default 300ms). Returns -1 for an invalid spec.
+//   "Ctrl,Ctrl"  "Alt+Shift hold"  "Ctrl tap-tap-hold"  "Ctrl then Space within 200ms"
+export function registerGestureListener(spec: string, callback: GestureCallback): number;
+
+export function unregisterGestureListener(id: number): boolean;
+
+export type NativeEvent =
+  | { type: 'hotkey'; id: number; timestamp: number }
+  | { type: 'double-tap'; id: number; event: DoubleTapEvent; timestamp: number }
+  | { type: 'hold'; id: number; event: HoldEvent; duration: number; timestamp: number }
+  | { type: 'gesture'; id: number; event: GestureEvent; duration: number; timestamp: number }
+  | { type: 'window-change'; info: WatchedWindowInfo }
+  | { type: 'window-title'; title: string; context?: AppContextMatch };
+
+export type NativeEventsCallback = (batch: NativeEvent[]) => void;
+
+export function onNativeEvents(callback: NativeEventsCallback | null): void;
+
+export function setAppContexts(rules: AppContextRule[]): number;
+
+export function matchAppContext(
+  info: Pick<ActiveWindowInfo, 'title' | 'processName' | 'bundleId'>
+): AppContextMatch | null;
+
+/**
+ * Compile every trigger into one case-insensitive automaton, replacing the
+ * previous set. Returns the number of triggers compiled.
+ */
+export function compileSnippets(snippets: SnippetDefinition[]): number;
+
+/** Leftmost-longest, non-overlapping trigger matches in text. */
+export function matchSnippets(text: string): SnippetMatch[];
+
+/**
+ * Incremental matching for text that grows, such as interim speech results.
+ * Feed only the appended part; pass final = true with the last piece.
+ * Matches are the same as matchSnippets on the whole text.
+ */
+export function createSnippetStream(): number;
+export function snippetStreamAppend(stream: number, delta: string, final?: boolean): SnippetStreamResult;
+/** Start over from an empty text against the latest compiled snippets. */
+export function snippetStreamReset(stream: number): boolean;
+export function closeSnippetStream(stream: number): boolean;
+
+/**
+ * Compile one context's phrase replacements (context-dictionaries.json),
+ * replacing any previous dictionary for that context. Phrases match whole
+ * words, ignoring case and accents. Returns the number of phrases compiled.
+ */
+export function setContextDictionary(contextId: string, replacements: Record<string, string>): number;
+
+/**
+ * Apply a compiled context dictionary in one pass, longest phrase first.
+ * Returns null if no dictionary was compiled for contextId.
+ */
+export function rewriteWithDictionary(contextId: string, text: string): string | null;
+
+export interface LanguageHint {
+  language: string;
+  /** Stop words, matched as whole words ignoring case. */
+  words: string[];
+  weight: number;
+}
+
+export interface ScriptHistogram {
+  /** Characters per script, indexed like getScriptNames(). */
+  scripts: number[];
+  /** Summed weight of each hint's words, indexed like the hints last set. */
+  hintScores: number[];
+}
+
+/** Replace the Latin-language hints; returns the number of distinct words. */
+export function setLanguageHints(hints: LanguageHint[]): number;
+
+/** Count characters per script and score the language hints in one pass. */
+export function detectScripts(text: string): ScriptHistogram;
+
+export function getScriptNames(): string[];
+
+export interface LanguageModelStatus {
+  loaded: boolean;
+  /** Languages in the loaded model, which may be an earlier one if this load failed. */
+  languages: number;
+  error?: string;
+}
+
+export interface LanguageGuess {
+  language: string;
+  /** Calibrated probability across every language in the model. */
+  confidence: number;
+}
+
+/**
+ * Map a trigram profile file built by scripts/build-language-profiles.js.
+ * A failed load keeps the previously loaded model.
+ */
+export function loadLanguageModel(path: string): LanguageModelStatus;
+
+/** Most likely languages, best first; empty without a model or letters. */
+export function identifyLanguage(text: string, maxResults?: number): LanguageGuess[];
+
+/**
+ * How a group's phrases match: 'start' is the phrase the text begins with,
+ * 'first' the leftmost occurrence anywhere, 'words' every whole-word
+ * occurrence. Alternatives at the same position are tried in order.
+ */
+export interface TextPatternGroup {
+  mode: 'start' | 'first' | 'words';
+  phrases: string[];
+}
+
+export interface TextMetricsResult {
+  sentenceCount: number;
+  wordCount: number;
+  averageSentenceLength: number;
+  /** Distinct lowercased words of three or more letters. */
+  uniqueWordCount: number;
+  /** Occurrences per word. */
+  punctuationUsage: {
+    semicolonUsage: number;
+    exclamationUsage: number;
+    ellipsisUsage: number;
+  };
+  /** The text each group matched, as written, indexed like the groups last set. */
+  patternMatches: string[][];
+}
+
+/** Replace the pattern groups; returns the number of phrases compiled. */
+export function setTextPatterns(groups: TextPatternGroup[]): number;
+
+/** Count sentences, words and punctuation and match every pattern group in one pass. */
+export function analyzeTextMetrics(text: string): TextMetricsResult;
+
 export function getPlatform(): 'win32' | 'darwin' | 'linux' | 'unknown';
 
+export type InputBackendName = 'x11' | 'evdev' | 'auto';
+
+/**
+ * Choose how key capture and injection reach the system on Linux. Must be
+ * called before the first hotkey or key listener is registered; returns
+ * false afterwards, for unknown names and on other platforms.
+ */
+export function setInputBackend(name: InputBackendName): boolean;
+
+/** The Linux backend in effect, or 'native' on other platforms. */
+export function getInputBackend(): 'x11' | 'evdev' | 'native';
+
+export interface DisplayPoolStats {
+  opened: number;
+  acquired: number;
+  avoidedOpens: number;
+  live: number;
+}
+
+export function getDisplayPoolStats(): DisplayPoolStats;
+
+export type NativeLatencyStage =
+  | 'eventReceipt'
+  | 'detectorDecision'
+  | 'tsfEnqueue'
+  | 'injectionEnqueue'
+  | 'jsDispatch'
+  | 'clipboardWrite'
+  | 'pasteSimulate'
+  | 'windowInfo';
+
+/** Percentiles and max are in microseconds. */
+export interface LatencySummary {
+  count: number;
+  p50: number;
+  p95: number;
+  p99: number;
+  max: number;
+}
+
+export interface NativeMetrics {
+  stages: Record<NativeLatencyStage, LatencySummary>;
+  droppedEvents: number;
+}
+
+/** Latency histograms for each native stage since start or the last reset. */
+export function getNativeMetrics(): NativeMetrics;
+export function resetNativeMetrics(): void;
+
 export const Modifiers: {
   None: 0;
   Ctrl: 1;
@@ -0,0 +1,104 @@
+// Exercises the evdev backend end to end against its own uinput keyboard:
+// the addon types through /dev/uinput and must see the keys come back
+// through /dev/input as a hotkey.
+//
+//   node native/scripts/evdev-loopback.js [path/to/speechly_native.node]
+//
+// Needs Linux with write access to /dev/uinput and read access to
+// /dev/input/event*. The keys really are typed: a capital Q lands in
+// whichever window has focus, normally the terminal running this.
+//
+// Two runs, each in its own process since the backend and the capture flag
+// are fixed once the listeners start:
+//   capture  SPEECHLY_CAPTURE_VIRTUAL_KEYBOARD=1, the hotkey must fire
+//   skip     flag unset, the reactor must ignore the virtual keyboard
+
+const { spawnSync } = require('child_process');
+const path = require('path');
+
+const HOTKEY = 'Shift+Q';
+const TEXT = 'Q';
+const SETTLE_MS = 500;
+const TIMEOUT_MS = 2000;
+
+function fail(message) {
+  console.error(`FAIL ${message}`);
+  process.exit(1);
+}
+
+function sleep(ms) {
+  return new Promise((resolve) => setTimeout(resolve, ms));
+}
+
+async function runCase(mode, modulePath) {
+  const native = require(modulePath);
+
+  if (!native.setInputBackend('evdev') || native.getInputBackend() !== 'evdev') {
+    fail(`${mode}: evdev backend unavailable (check access to /dev/input and /dev/uinput)`);
+  }
+
+  // Creates the virtual keyboard before capture starts, so the reactor
+  // finds it in its first scan rather than through inotify.
+  const warmup = native.injectText(' ', 'direct');
+  if (!warmup.success) {
+    fail(`${mode}: could not type through uinput: ${warmup.error}`);
+  }
+
+  let fired = 0;
+  const id = native.registerHotkey(HOTKEY, () => {
+    fired++;
+  });
+  if (id < 0) {
+    fail(`${mode}: could not register ${HOTKEY}`);
+  }
+
+  await sleep(SETTLE_MS);
+  const result = native.injectText(TEXT, 'direct');
+  if (!result.success) {
+    fail(`${mode}: typing failed: ${result.error}`);
+  }
+
+  const deadline = Date.now() + TIMEOUT_MS;
+  while (fired === 0 && Date.now() < deadline) {
+    await sleep(20);
+  }
+  native.unregisterHotkey(id);
+
+  if (mode === 'capture' && fired !== 1) {
+    fail(`capture: expected ${HOTKEY} once, got ${fired}`);
+  }
+  if (mode === 'skip' && fired !== 0) {
+    fail(`skip: the virtual keyboard was captured ${fired} time(s)`);
+  }
+  console.log(`ok ${mode}`);
+  process.exit(0);
+}
+
+function main() {
+  const [mode, modulePath] = process.argv.slice(2);
+  if (mode === 'capture' || mode === 'skip') {
+    runCase(mode, modulePath).catch((error) => fail(`${mode}: ${error.stack || error}`));
+    return;
+  }
+
+  if (process.platform !== 'linux') {
+    console.log('skipped: the evdev backend is Linux only');
+    return;
+  }
+
+  const target = path.resolve(mode || path.join(__dirname, '../build/Release/speechly_native.node'));
+  for (const run of ['capture', 'skip']) {
+    const env = { ...process.env, SPEECHLY_INPUT_BACKEND: 'evdev', SPEECHLY_KEYBOARD_LAYOUT: 'us' };
+    delete env.SPEECHLY_CAPTURE_VIRTUAL_KEYBOARD;
+    if (run === 'capture') {
+      env.SPEECHLY_CAPTURE_VIRTUAL_KEYBOARD = '1';
+    }
+
+    const child = spawnSync(process.execPath, [__filename, run, target], { env, stdio: 'inherit' });
+    if (child.status !== 0) {
+      process.exit(child.status || 1);
+    }
+  }
+}
+
+main();
@@ -2,23 +2,504 @@
 #include "window_detector.h"
 #include "text_injector.h"
 #include "hotkey_manager.h"
+#include "injection_queue.h"
+#include "injection_strategy.h"
+#include "display_pool.h"
+#include "input_backend.h"
+#include "latency_metrics.h"
+#include "context_matcher.h"
+#include "snippet_matcher.h"
+#include "phrase_rewriter.h"
+#include "script_detector.h"
+#include "language_model.h"
+#include "text_metrics.h"
+#include "mpsc_queue.h"
 #include <memory>
 #include <thread>
 #include <atomic>
+#include <unordered_map>
+#include <vector>
 
 namespace speechly {
 
+enum class NativeEventKind : uint8_t {
+    Hotkey,
+    DoubleTap,
+    Hold,
+    Gesture,
+    WindowChange,
+    WindowTitle
+};
+
+// One record type for every event the native threads hand to JS. Window
+// fields are only meaningful for the window kinds; records live in the bus's
+// ring and are refilled in place, so their strings keep their capacity.
+struct NativeEvent {
+    NativeEventKind kind{NativeEventKind::Hotkey};
+    int32_t id{0};
+    const char* name{""};
+    int32_t durationMs{0};
+    double timestampMs{0};
+    EventTime pushedAt;
+    bool hasContext{false};
+    ActiveWindowInfo window;
+    ContextMatch context;
+};
+
+// Carries every native event to JS without ever blocking the producing
+// thread. Hotkey, key listener and window watcher threads all push into one
+// bounded MPSC ring, drained on the JS thread behind a single
+// ThreadSafeFunction used only as a coalesced wakeup. When several events
+// arrive together they are delivered in one drain, and as one array to the
+// batch callback if JS installed one. When JS falls behind, the ring fills
+// and new events are counted as dropped rather than stalling input capture.
+class EventBus {
+public:
+    static constexpr size_t kCapacity = 1024;
+
+    // Runs the per-listener callbacks for an event; when describe is set it
+    // also returns a plain object describing it for the batch callback.
+    using Deliver = Napi::Value (*)(Napi::Env, NativeEvent&, bool describe);
+
+    explicit EventBus(Deliver deliver)
+        : deliver_(deliver), started_(false), listeners_(0), scheduled_(false), dropped_(0) {}
+
+    // Call before registering the native listener, so its first event finds
+    // the bus started, and remove it again if registration fails.
+    void addListener(Napi::Env env) {
+        if (!started_.load(std::memory_order_relaxed)) {
+            wakeup_ = Napi::ThreadSafeFunction::New(
+                env,
+                Napi::Function::New(env, [](const Napi::CallbackInfo&) {}),
+                "NativeEventBus",
+                0,
+                1
+            );
+            // Publishes wakeup_ to the producer threads.
+            started_.store(true, std::memory_order_release);
+        } else if (listeners_ == 0) {
+            wakeup_.Ref(env);
+        }
+        
+        listeners_++;
+    }
+
+    void removeListener(Napi::Env env) {
+        if (listeners_ > 0 && --listeners_ == 0) {
+            wakeup_.Unref(env);
+        }
+    }
+
+    void setBatchCallback(Napi::Function callback) {
+        batchCallback_ = Napi::Persistent(callback);
+    }
+
+    void clearBatchCallback() {
+        batchCallback_.Reset();
+    }
+
+    template <typename Fill>
+    void push(Fill&& fill) {
+        if (!started_.load(std::memory_order_acquire)) {
+            return;
+        }
+        
+        auto enqueueStart = std::chrono::steady_clock::now();
+        bool pushed = queue_.tryPushWith([&fill](NativeEvent& event) {
+            fill(event);
+            event.pushedAt = std::chrono::steady_clock::now();
+        });
+        if (!pushed) {
+            dropped_++;
+        }
+        
+        if (!scheduled_.exchange(true)) {
+            napi_status status = wakeup_.NonBlockingCall([this](Napi::Env env, Napi::Function) {
+                drain(env);
+            });
+            if (status != napi_ok) {
+                scheduled_ = false;
+            }
+        }
+        RecordLatencySince(LatencyStage::TsfEnqueue, enqueueStart);
+    }
+
+    uint64_t dropped() const {
+        return dropped_;
+    }
+
+private:
+    void drain(Napi::Env env) {
+        scheduled_ = false;
+        
+        bool describe = !batchCallback_.IsEmpty();
+        Napi::Array batch = describe ? Napi::Array::New(env) : Napi::Array();
+        uint32_t count = 0;
+        bool failed = false;
+        
+        while (!failed && queue_.tryConsume([&](NativeEvent& event) {
+            RecordLatencySince(LatencyStage::JsDispatch, event.pushedAt);
+            Napi::Value record = deliver_(env, event, describe);
+            failed = env.IsExceptionPending();
+            if (describe && !failed) {
+                batch.Set(count++, record);
+            }
+        })) {
+        }
+        
+        if (!failed && count > 0 && !batchCallback_.IsEmpty()) {
+            batchCallback_.Call({batch});
+            failed = env.IsExceptionPending();
+        }
+        
+        if (failed && !queue_.empty() && !scheduled_.exchange(true)) {
+            wakeup_.NonBlockingCall([this](Napi::Env env, Napi::Function) {
+                drain(env);
+            });
+        }
+    }
+
+    Napi::ThreadSafeFunction wakeup_;
+    Napi::FunctionReference batchCallback_;
+    Deliver deliver_;
+    std::atomic<bool> started_;
+    int listeners_;
+    MpscQueue<NativeEvent, kCapacity> queue_;
+    std::atomic<bool> scheduled_;
+    std::atomic<uint64_t> dropped_;
+};
+
+// JS callbacks of one listener type, addressed by generation-tagged handles.
+// A handle packs a slot index (low 16 bits) with the slot's generation, so
+// freed slots are reused without a stale handle, or an event still queued
+// for it, ever reaching the new occupant. JS thread only.
+class CallbackRegistry {
+public:
+    static constexpr uint32_t kMaxSlots = 1u << 16;
+
+    int32_t add(Napi::Function callback) {
+        uint32_t slot;
+        if (!free_.empty()) {
+            slot = free_.back();
+            free_.pop_back();
+        } else if (entries_.size() < kMaxSlots) {
+            slot = static_cast<uint32_t>(entries_.size());
+            entries_.emplace_back();
+        } else {
+            return -1;
+        }
+        
+        Entry& entry = entries_[slot];
+        entry.callback = Napi::Persistent(callback);
+        entry.nativeId = -1;
+        entry.live = true;
+        return handleFor(slot);
+    }
+
+    Napi::FunctionReference* find(int32_t handle) {
+        Entry* entry = lookup(handle);
+        return entry ? &entry->callback : nullptr;
+    }
+
+    void setNativeId(int32_t handle, int32_t nativeId) {
+        if (Entry* entry = lookup(handle)) {
+            entry->nativeId = nativeId;
+        }
+    }
+
+    int32_t nativeId(int32_t handle) {
+        Entry* entry = lookup(handle);
+        return entry ? entry->nativeId : -1;
+    }
+
+    bool remove(int32_t handle) {
+        Entry* entry = lookup(handle);
+        if (!entry) {
+            return false;
+        }
+        
+        release(static_cast<uint32_t>(handle) & 0xffff);
+        return true;
+    }
+
+    size_t clear() {
+        size_t removed = 0;
+        for (uint32_t slot = 0; slot < entries_.size(); slot++) {
+            if (entries_[slot].live) {
+                release(slot);
+                removed++;
+            }
+        }
+        return removed;
+    }
+
+private:
+    struct Entry {
+        Napi::FunctionReference callback;
+        int32_t nativeId{-1};
+        uint16_t generation{1};
+        bool live{false};
+    };
+
+    int32_t handleFor(uint32_t slot) const {
+        return static_cast<int32_t>((static_cast<uint32_t>(entries_[slot].generation) << 16) | slot);
+    }
+
+    Entry* lookup(int32_t handle) {
+        if (handle <= 0) {
+            return nullptr;
+        }
+        
+        uint32_t slot = static_cast<uint32_t>(handle) & 0xffff;
+        uint32_t generation = static_cast<uint32_t>(handle) >> 16;
+        if (slot >= entries_.size() || !entries_[slot].live || entries_[slot].generation != generation) {
+            return nullptr;
+        }
+        return &entries_[slot];
+    }
+
+    void release(uint32_t slot) {
+        Entry& entry = entries_[slot];
+        entry.callback.Reset();
+        entry.live = false;
+        // Generations stay in 1..0x7fff so handles are positive int32s.
+        entry.generation = entry.generation == 0x7fff ? 1 : entry.generation + 1;
+        free_.push_back(slot);
+    }
+
+    std::vector<Entry> entries_;
+    std::vector<uint32_t> free_;
+};
+
 static std::unique_ptr<WindowDetector> g_windowDetector;
 static std::unique_ptr<TextInjector> g_textInjector;
+static std::unique_ptr<InjectionQueue> g_injectionQueue;
+static Napi::ThreadSafeFunction g_injectionCompletion;
+static std::unordered_map<uint32_t, Napi::Promise::Deferred> g_pendingInjections;
 static std::unique_ptr<HotkeyManager> g_hotkeyManager;
 static std::unique_ptr<KeyListener> g_keyListener;
-static Napi::ThreadSafeFunction g_windowChangeCallback;
-static Napi::ThreadSafeFunction g_hotkeyCallbacks[256];
-static Napi::ThreadSafeFunction g_doubleTapCallbacks[256];
-static Napi::ThreadSafeFunction g_holdCallbacks[256];
-static std::atomic<int> g_nextHotkeyId{1};
-static std::atomic<int> g_nextDoubleTapId{1};
-static std::atomic<int> g_nextHoldId{1};
+static Napi::FunctionReference g_windowChangeCallback;
+static Napi::FunctionReference g_windowTitleCallback;
+static CallbackRegistry g_hotkeyCallbacks;
+static CallbackRegistry g_doubleTapCallbacks;
+static CallbackRegistry g_holdCallbacks;
+static CallbackRegistry g_gestureCallbacks;
+
+static Napi::Value DeliverNativeEvent(Napi::Env env, NativeEvent& event, bool describe);
+static EventBus g_eventBus(DeliverNativeEvent);
+
+// Hands out one JS string per distinct value for fields that repeat across
+// window events (process names, paths, bundle ids, context names), so a focus
+// change does not decode and allocate them again. The strings are kept in a
+// persistent array because Node-API references cannot hold primitives before
+// version 10. JS thread only; the table starts over once it reaches its bound.
+class StringInterner {
+public:
+    static constexpr size_t kMaxEntries = 128;
+
+    Napi::Value get(Napi::Env env, const std::string& value) {
+        auto it = index_.find(value);
+        if (it != index_.end()) {
+            return table_.Value().Get(it->second);
+        }
+        
+        if (table_.IsEmpty() || index_.size() >= kMaxEntries) {
+            index_.clear();
+            table_ = Napi::Persistent(Napi::Array::New(env));
+        }
+        
+        uint32_t slot = static_cast<uint32_t>(index_.size());
+        Napi::String string = Napi::String::New(env, value);
+        table_.Value().Set(slot, string);
+        index_.emplace(value, slot);
+        return string;
+    }
+
+private:
+    Napi::Reference<Napi::Array> table_;
+    std::unordered_map<std::string, uint32_t> index_;
+};
+
+// Window info objects are plain data properties, not lazy accessors: the main
+// process forwards them over IPC, and structured clone only copies own
+// enumerable properties. Defining them in one call avoids a key lookup and
+// boundary crossing per field.
+static const napi_property_attributes kDataProperty = static_cast<napi_property_attributes>(
+    napi_writable | napi_enumerable | napi_configurable);
+
+static StringInterner g_windowStrings;
+
+// Last focused window, as seen by the watcher thread. Title-only events
+// resolve their context against it; only the watcher thread touches it.
+static ActiveWindowInfo g_watchedWindow;
+
+static Napi::Object ContextMatchToObject(Napi::Env env, const ContextMatch& match) {
+    Napi::Object result = Napi::Object::New(env);
+    result.DefineProperties({
+        Napi::PropertyDescriptor::Value("ruleIndex", Napi::Number::New(env, match.ruleIndex), kDataProperty),
+        Napi::PropertyDescriptor::Value("context", g_windowStrings.get(env, match.contextType), kDataProperty),
+        Napi::PropertyDescriptor::Value("appName", g_windowStrings.get(env, match.appName), kDataProperty),
+        Napi::PropertyDescriptor::Value("confidence",
+            g_windowStrings.get(env, ContextConfidenceName(match.confidence)), kDataProperty)
+    });
+    return result;
+}
+
+static Napi::Object WindowInfoToObject(Napi::Env env, const ActiveWindowInfo& windowInfo) {
+    Napi::Object result = Napi::Object::New(env);
+    result.DefineProperties({
+        Napi::PropertyDescriptor::Value("title", Napi::String::New(env, windowInfo.title), kDataProperty),
+        Napi::PropertyDescriptor::Value("processName", g_windowStrings.get(env, windowInfo.processName), kDataProperty),
+        Napi::PropertyDescriptor::Value("bundleId", g_windowStrings.get(env, windowInfo.bundleId), kDataProperty),
+        Napi::PropertyDescriptor::Value("executablePath",
+            g_windowStrings.get(env, windowInfo.executablePath), kDataProperty),
+        Napi::PropertyDescriptor::Value("pid", Napi::Number::New(env, static_cast<double>(windowInfo.pid)), kDataProperty),
+        Napi::PropertyDescriptor::Value("isValid", Napi::Boolean::New(env, windowInfo.isValid), kDataProperty)
+    });
+    return result;
+}
+
+static const char* NativeEventTypeName(NativeEventKind kind) {
+    switch (kind) {
+        case NativeEventKind::Hotkey:
+            return "hotkey";
+        case NativeEventKind::DoubleTap:
+            return "double-tap";
+        case NativeEventKind::Hold:
+            return "hold";
+        case NativeEventKind::Gesture:
+            return "gesture";
+        case NativeEventKind::WindowChange:
+            return "window-change";
+        default:
+            return "window-title";
+    }
+}
+
+static Napi::Value DeliverNativeEvent(Napi::Env env, NativeEvent& event, bool describe) {
+    Napi::Object record;
+    if (describe) {
+        record = Napi::Object::New(env);
+        record.Set("type", Napi::String::New(env, NativeEventTypeName(event.kind)));
+    }
+    
+    switch (event.kind) {
+        case NativeEventKind::Hotkey: {
+            Napi::Number timestamp = Napi::Number::New(env, event.timestampMs);
+            if (describe) {
+                record.Set("id", Napi::Number::New(env, event.id));
+                record.Set("timestamp", timestamp);
+            }
+            if (Napi::FunctionReference* callback = g_hotkeyCallbacks.find(event.id)) {
+                callback->Call({timestamp});
+            }
+            break;
+        }
+        case NativeEventKind::DoubleTap: {
+            Napi::String name = Napi::String::New(env, event.name);
+            Napi::Number timestamp = Napi::Number::New(env, event.timestampMs);
+            if (describe) {
+                record.Set("id", Napi::Number::New(env, event.id));
+                record.Set("event", name);
+                record.Set("timestamp", timestamp);
+            }
+            if (Napi::FunctionReference* callback = g_doubleTapCallbacks.find(event.id)) {
+                callback->Call({name, timestamp});
+            }
+            break;
+        }
+        case NativeEventKind::Hold: {
+            Napi::String name = Napi::String::New(env, event.name);
+            Napi::Number duration = Napi::Number::New(env, event.durationMs);
+            Napi::Number timestamp = Napi::Number::New(env, event.timestampMs);
+            if (describe) {
+                record.Set("id", Napi::Number::New(env, event.id));
+                record.Set("event", name);
+                record.Set("duration", duration);
+                record.Set("timestamp", timestamp);
+            }
+            if (Napi::FunctionReference* callback = g_holdCallbacks.find(event.id)) {
+                callback->Call({name, duration, timestamp});
+            }
+            break;
+        }
+        case NativeEventKind::Gesture: {
+            Napi::String name = Napi::String::New(env, event.name);
+            Napi::Number duration = Napi::Number::New(env, event.durationMs);
+            Napi::Number timestamp = Napi::Number::New(env, event.timestampMs);
+            if (describe) {
+                record.Set("id", Napi::Number::New(env, event.id));
+                record.Set("event", name);
+                record.Set("duration", duration);
+                record.Set("timestamp", timestamp);
+            }
+            if (Napi::FunctionReference* callback = g_gestureCallbacks.find(event.id)) {
+                callback->Call({name, duration, timestamp});
+            }
+            break;
+        }
+        case NativeEventKind::WindowChange: {
+            Napi::Object windowInfo = WindowInfoToObject(env, event.window);
+            if (event.hasContext) {
+                windowInfo.Set("context", ContextMatchToObject(env, event.context));
+            }
+            if (describe) {
+                record.Set("info", windowInfo);
+            }
+            if (!g_windowChangeCallback.IsEmpty()) {
+                g_windowChangeCallback.Call({windowInfo});
+            }
+            break;
+        }
+        case NativeEventKind::WindowTitle: {
+            Napi::String title = Napi::String::New(env, event.window.title);
+            Napi::Value context = event.hasContext ? ContextMatchToObject(env, event.context) : env.Undefined();
+            if (describe) {
+                record.Set("title", title);
+                if (event.hasContext) {
+                    record.Set("context", context);
+                }
+            }
+            if (!g_windowTitleCallback.IsEmpty()) {
+                if (event.hasContext) {
+                    g_windowTitleCallback.Call({title, context});
+                } else {
+                    g_windowTitleCallback.Call({title});
+                }
+            }
+            break;
+        }
+    }
+    
+    return record;
+}
+
+static const char* InternListenerEventName(const std::string& name) {
+    if (name == "double-tap") return "double-tap";
+    if (name == "hold-start") return "hold-start";
+    if (name == "hold-end") return "hold-end";
+    if (name == "gesture") return "gesture";
+    return "unknown";
+}
+
+// Event times reach JS as milliseconds on steady_clock, which is the clock
+// behind process.hrtime() on every platform, so JS can compare them with
+// Number(process.hrtime.bigint()) / 1e6.
+static double EventTimeToMs(EventTime at) {
+    return std::chrono::duration<double, std::milli>(at.time_since_epoch()).count();
+}
+
+static void PushListenerEvent(NativeEventKind kind, int32_t id, const char* name, int32_t durationMs, EventTime at) {
+    RecordLatencySince(LatencyStage::EventReceipt, at);
+    double timestampMs = EventTimeToMs(at);
+    g_eventBus.push([=](NativeEvent& event) {
+        event.kind = kind;
+        event.id = id;
+        event.name = name;
+        event.durationMs = durationMs;
+        event.timestampMs = timestampMs;
+    });
+}
 
 Napi::Object GetActiveWindow(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
@@ -28,16 +509,7 @@ Napi::Object GetActiveWindow(const Napi::CallbackInfo& info) {
     }
     
     ActiveWindowInfo windowInfo = g_windowDetector->getActiveWindow();
-    
-    Napi::Object result = Napi::Object::New(env);
-    result.Set("title", Napi::String::New(env, windowInfo.title));
-    result.Set("processName", Napi::String::New(env, windowInfo.processName));
-    result.Set("bundleId", Napi::String::New(env, windowInfo.bundleId));
-    result.Set("executablePath", Napi::String::New(env, windowInfo.executablePath));
-    result.Set("pid", Napi::Number::New(env, static_cast<double>(windowInfo.pid)));
-    result.Set("isValid", Napi::Boolean::New(env, windowInfo.isValid));
-    
-    return result;
+    return WindowInfoToObject(env, windowInfo);
 }
 
 Napi::Value StartWindowWatcher(const Napi::CallbackInfo& info) {
@@ -52,30 +524,46 @@ Napi::Value StartWindowWatcher(const Napi::CallbackInfo& info) {
         g_windowDetector = std::make_unique<WindowDetector>();
     }
     
-    g_windowChangeCallback = Napi::ThreadSafeFunction::New(
-        env,
-        info[0].As<Napi::Function>(),
-        "WindowChangeCallback",
-        0,
-        1
-    );
+    if (g_windowDetector->isWatching()) {
+        return Napi::Boolean::New(env, false);
+    }
+    
+    g_windowChangeCallback = Napi::Persistent(info[0].As<Napi::Function>());
+    g_eventBus.addListener(env);
+    
+    TitleChangeCallback titleCallback;
+    if (info.Length() > 1 && info[1].IsFunction()) {
+        g_windowTitleCallback = Napi::Persistent(info[1].As<Napi::Function>());
+        titleCallback = [](const std::string& title) {
+            // A browser tab switch only changes the title, so the context
+            // is re-resolved against the focused window with the new title.
+            g_watchedWindow.title = title;
+            
+            g_eventBus.push([&title](NativeEvent& event) {
+                event.kind = NativeEventKind::WindowTitle;
+                event.window.title = title;
+                event.hasContext = ContextMatcher::instance().match(g_watchedWindow, event.context);
+            });
+        };
+    }
     
+    // Events are written into the bus's slots in place, so their strings
+    // reuse the capacity left by earlier events instead of allocating.
     bool success = g_windowDetector->startWatching([](const ActiveWindowInfo& windowInfo) {
-        auto callback = [](Napi::Env env, Napi::Function jsCallback, ActiveWindowInfo* info) {
-            Napi::Object result = Napi::Object::New(env);
-            result.Set("title", Napi::String::New(env, info->title));
-            result.Set("processName", Napi::String::New(env, info->processName));
-            result.Set("bundleId", Napi::String::New(env, info->bundleId));
-            result.Set("executablePath", Napi::String::New(env, info->executablePath));
-            result.Set("pid", Napi::Number::New(env, static_cast<double>(info->pid)));
-            result.Set("isValid", Napi::Boolean::New(env, info->isValid));
-            jsCallback.Call({result});
-            delete info;
-        };
+        g_watchedWindow = windowInfo;
         
-        ActiveWindowInfo* infoCopy = new ActiveWindowInfo(windowInfo);
-        g_windowChangeCallback.BlockingCall(infoCopy, callback);
-    });
+        g_eventBus.push([&windowInfo](NativeEvent& event) {
+            event.kind = NativeEventKind::WindowChange;
+            event.window = windowInfo;
+            event.hasContext = ContextMatcher::instance().match(windowInfo, event.context);
+        });
+    }, titleCallback);
+    
+    if (!success) {
+        g_windowChangeCallback.Reset();
+        g_windowTitleCallback.Reset();
+        g_eventBus.removeListener(env);
+    }
     
     return Napi::Boolean::New(env, success);
 }
@@ -83,17 +571,164 @@ Napi::Value StartWindowWatcher(const Napi::CallbackInfo& info) {
 Napi::Value StopWindowWatcher(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
-    if (g_windowDetector) {
+    if (g_windowDetector && g_windowDetector->isWatching()) {
         g_windowDetector->stopWatching();
+        g_eventBus.removeListener(env);
     }
     
-    if (g_windowChangeCallback) {
-        g_windowChangeCallback.Release();
-    }
+    g_windowChangeCallback.Reset();
+    g_windowTitleCallback.Reset();
     
     return env.Undefined();
 }
 
+static InjectionMethod ParseInjectionMethod(const Napi::CallbackInfo& info, size_t index) {
+    if (info.Length() > index && info[index].IsString()) {
+        std::string methodStr = info[index].As<Napi::String>().Utf8Value();
+        if (methodStr == "clipboard") {
+            return InjectionMethod::Clipboard;
+        } else if (methodStr == "direct") {
+            return InjectionMethod::Direct;
+        }
+    }
+    return InjectionMethod::Auto;
+}
+
+static Napi::Object InjectionResultToObject(Napi::Env env, const InjectionResult& result) {
+    Napi::Object resultObj = Napi::Object::New(env);
+    resultObj.Set("success", Napi::Boolean::New(env, result.success));
+    resultObj.Set("error", Napi::String::New(env, result.error));
+    return resultObj;
+}
+
+struct InjectionCompletionData {
+    uint32_t jobId;
+    InjectionResult result;
+};
+
+static void ResolveInjection(Napi::Env env, Napi::Function, InjectionCompletionData* data) {
+    auto it = g_pendingInjections.find(data->jobId);
+    if (it != g_pendingInjections.end()) {
+        it->second.Resolve(InjectionResultToObject(env, data->result));
+        g_pendingInjections.erase(it);
+        
+        if (g_pendingInjections.empty()) {
+            g_injectionCompletion.Unref(env);
+        }
+    }
+    delete data;
+}
+
+// Runs while the environment is being torn down, before static destructors:
+// the worker is cancelled and joined while its completion function can still
+// accept calls, then the function is released. Promises still pending die
+// with the environment.
+static void ShutdownInjectionQueue(void*) {
+    g_injectionQueue.reset();
+    g_injectionCompletion.Release();
+    g_pendingInjections.clear();
+}
+
+// Registered first, so it runs after the queue has stopped recording.
+static void FlushInjectionStrategy(void*) {
+    InjectionStrategy::instance().flush();
+}
+
+static Napi::Value EnqueueInjection(Napi::Env env, InjectionJob job) {
+    if (!g_textInjector) {
+        g_textInjector = std::make_unique<TextInjector>();
+    }
+    
+    if (!g_injectionQueue) {
+        g_injectionCompletion = Napi::ThreadSafeFunction::New(
+            env,
+            Napi::Function::New(env, [](const Napi::CallbackInfo&) {}),
+            "InjectionCompletion",
+            0,
+            1
+        );
+        g_injectionCompletion.Unref(env);
+        
+        g_injectionQueue = std::make_unique<InjectionQueue>(*g_textInjector,
+            [](uint32_t jobId, const InjectionResult& result) {
+                auto* data = new InjectionCompletionData{jobId, result};
+                if (g_injectionCompletion.BlockingCall(data, ResolveInjection) != napi_ok) {
+                    delete data;
+                }
+            });
+        
+        // Hooks run in reverse order of registration, so this one runs
+        // before the completion function's own teardown.
+        napi_add_env_cleanup_hook(env, ShutdownInjectionQueue, nullptr);
+    }
+    
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    Napi::Promise promise = deferred.Promise();
+    
+    if (g_pendingInjections.empty()) {
+        g_injectionCompletion.Ref(env);
+    }
+    
+    uint32_t jobId = g_injectionQueue->enqueue(std::move(job));
+    g_pendingInjections.emplace(jobId, deferred);
+    
+    promise.Set("injectionId", Napi::Number::New(env, jobId));
+    return promise;
+}
+
+Napi::Value InjectTextAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "String expected").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    
+    InjectionJob job;
+    job.text = info[0].As<Napi::String>().Utf8Value();
+    job.method = ParseInjectionMethod(info, 1);
+    
+    return EnqueueInjection(env, std::move(job));
+}
+
+Napi::Value InjectTextWithDelayAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "String and number expected").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    
+    InjectionJob job;
+    job.text = info[0].As<Napi::String>().Utf8Value();
+    job.method = InjectionMethod::Clipboard;
+    job.delayMs = info[1].As<Napi::Number>().Uint32Value();
+    
+    return EnqueueInjection(env, std::move(job));
+}
+
+Napi::Value CancelInjection(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Number expected").ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
+    }
+    
+    uint32_t jobId = info[0].As<Napi::Number>().Uint32Value();
+    bool cancelled = g_injectionQueue && g_injectionQueue->cancel(jobId);
+    
+    return Napi::Boolean::New(env, cancelled);
+}
+
+Napi::Value CancelAllInjections(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    size_t cancelled = g_injectionQueue ? g_injectionQueue->cancelAll() : 0;
+    
+    return Napi::Number::New(env, static_cast<double>(cancelled));
+}
+
 Napi::Value InjectText(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
@@ -107,24 +742,11 @@ Napi::Value InjectText(const Napi::CallbackInfo& info) {
     }
     
     std::string text = info[0].As<Napi::String>().Utf8Value();
-    
-    InjectionMethod method = InjectionMethod::Auto;
-    if (info.Length() > 1 && info[1].IsString()) {
-        std::string methodStr = info[1].As<Napi::String>().Utf8Value();
-        if (methodStr == "clipboard") {
-            method = InjectionMethod::Clipboard;
-        } else if (methodStr == "direct") {
-            method = InjectionMethod::Direct;
-        }
-    }
+    InjectionMethod method = ParseInjectionMethod(info, 1);
     
     InjectionResult result = g_textInjector->injectText(text, method);
     
-    Napi::Object resultObj = Napi::Object::New(env);
-    resultObj.Set("success", Napi::Boolean::New(env, result.success));
-    resultObj.Set("error", Napi::String::New(env, result.error));
-    
-    return resultObj;
+    return InjectionResultToObject(env, result);
 }
 
 Napi::Value InjectTextWithDelay(const Napi::CallbackInfo& info) {
@@ -151,6 +773,41 @@ Napi::Value InjectTextWithDelay(const Napi::CallbackInfo& info) {
     return resultObj;
 }
 
+Napi::Value SetInjectionStatsPath(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "String expected").ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
+    }
+    
+    std::string path = info[0].As<Napi::String>().Utf8Value();
+    bool success = InjectionStrategy::instance().setStoragePath(path);
+    
+    return Napi::Boolean::New(env, success);
+}
+
+Napi::Value GetInjectionStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    std::vector<InjectionAppStats> stats = InjectionStrategy::instance().snapshot();
+    
+    Napi::Array result = Napi::Array::New(env, stats.size());
+    for (size_t i = 0; i < stats.size(); i++) {
+        Napi::Object entry = Napi::Object::New(env);
+        entry.Set("processName", Napi::String::New(env, stats[i].processName));
+        entry.Set("clipboardSamples", Napi::Number::New(env, stats[i].clipboardSamples));
+        entry.Set("clipboardLatencyMs", Napi::Number::New(env, stats[i].clipboardLatencyUs / 1000.0));
+        entry.Set("clipboardSuccessRate", Napi::Number::New(env, stats[i].clipboardSuccessRate));
+        entry.Set("directSamples", Napi::Number::New(env, stats[i].directSamples));
+        entry.Set("directPerCharMs", Napi::Number::New(env, stats[i].directPerCharUs / 1000.0));
+        entry.Set("directSuccessRate", Napi::Number::New(env, stats[i].directSuccessRate));
+        result.Set(static_cast<uint32_t>(i), entry);
+    }
+    
+    return result;
+}
+
 Napi::Value PasteFromClipboard(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
@@ -227,31 +884,25 @@ Napi::Value RegisterHotkey(const Napi::CallbackInfo& info) {
     }
     
     Napi::Function callback = info[info.Length() - 1].As<Napi::Function>();
-    int hotkeyId = g_nextHotkeyId++;
+    int32_t handle = g_hotkeyCallbacks.add(callback);
     
-    if (hotkeyId < 256) {
-        g_hotkeyCallbacks[hotkeyId] = Napi::ThreadSafeFunction::New(
-            env,
-            callback,
-            "HotkeyCallback" + std::to_string(hotkeyId),
-            0,
-            1
-        );
-        
-        int32_t result = g_hotkeyManager->registerHotkey(modifiers, keyCode, [hotkeyId]() {
-            if (g_hotkeyCallbacks[hotkeyId]) {
-                g_hotkeyCallbacks[hotkeyId].BlockingCall([](Napi::Env env, Napi::Function jsCallback) {
-                    jsCallback.Call({});
-                });
-            }
-        });
-        
-        if (result >= 0) {
-            return Napi::Number::New(env, hotkeyId);
-        }
+    if (handle < 0) {
+        return Napi::Number::New(env, -1);
+    }
+    
+    g_eventBus.addListener(env);
+    int32_t nativeId = g_hotkeyManager->registerHotkey(modifiers, keyCode, [handle](EventTime at) {
+        PushListenerEvent(NativeEventKind::Hotkey, handle, "hotkey", 0, at);
+    });
+    
+    if (nativeId < 0) {
+        g_hotkeyCallbacks.remove(handle);
+        g_eventBus.removeListener(env);
+        return Napi::Number::New(env, -1);
     }
     
-    return Napi::Number::New(env, -1);
+    g_hotkeyCallbacks.setNativeId(handle, nativeId);
+    return Napi::Number::New(env, handle);
 }
 
 Napi::Value UnregisterHotkey(const Napi::CallbackInfo& info) {
@@ -268,10 +919,12 @@ Napi::Value UnregisterHotkey(const Napi::CallbackInfo& info) {
         return Napi::Boolean::New(env, false);
     }
     
-    bool success = g_hotkeyManager->unregisterHotkey(id);
+    int32_t nativeId = g_hotkeyCallbacks.nativeId(id);
+    bool success = nativeId >= 0 && g_hotkeyManager->unregisterHotkey(nativeId);
     
-    if (success && id >= 0 && id < 256 && g_hotkeyCallbacks[id]) {
-        g_hotkeyCallbacks[id].Release();
+    if (success) {
+        g_hotkeyCallbacks.remove(id);
+        g_eventBus.removeListener(env);
     }
     
     return Napi::Boolean::New(env, success);
@@ -284,10 +937,8 @@ Napi::Value UnregisterAllHotkeys(const Napi::CallbackInfo& info) {
         g_hotkeyManager->unregisterAll();
     }
     
-    for (int i = 0; i < 256; i++) {
-        if (g_hotkeyCallbacks[i]) {
-            g_hotkeyCallbacks[i].Release();
-        }
+    for (size_t removed = g_hotkeyCallbacks.clear(); removed > 0; removed--) {
+        g_eventBus.removeListener(env);
     }
     
     return env.Undefined();
@@ -326,6 +977,37 @@ Napi::Value GetPlatform(const Napi::CallbackInfo& info) {
 #endif
 }
 
+// Only meaningful before the first hotkey or key listener is registered,
+// since those bind to a backend when they are created.
+Napi::Value SetInputBackend(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Backend name expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+#ifdef __linux__
+    if (g_hotkeyManager || g_keyListener) {
+        return Napi::Boolean::New(env, false);
+    }
+    
+    return Napi::Boolean::New(env, SelectInputBackend(info[0].As<Napi::String>().Utf8Value()));
+#else
+    return Napi::Boolean::New(env, false);
+#endif
+}
+
+Napi::Value GetInputBackendJs(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+#ifdef __linux__
+    return Napi::String::New(env, InputBackendName(GetInputBackend()));
+#else
+    return Napi::String::New(env, "native");
+#endif
+}
+
 Napi::Value RegisterDoubleTapListener(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
@@ -343,33 +1025,26 @@ Napi::Value RegisterDoubleTapListener(const Napi::CallbackInfo& info) {
     int threshold = info[1].As<Napi::Number>().Int32Value();
     Napi::Function callback = info[2].As<Napi::Function>();
     
-    int listenerId = g_nextDoubleTapId++;
+    int32_t handle = g_doubleTapCallbacks.add(callback);
     
-    if (listenerId < 256) {
-        g_doubleTapCallbacks[listenerId] = Napi::ThreadSafeFunction::New(
-            env,
-            callback,
-            "DoubleTapCallback" + std::to_string(listenerId),
-            0,
-            1
-        );
-        
-        int32_t result = g_keyListener->registerDoubleTapListener(key, threshold, [listenerId](const std::string& event) {
-            if (g_doubleTapCallbacks[listenerId]) {
-                std::string* eventCopy = new std::string(event);
-                g_doubleTapCallbacks[listenerId].BlockingCall(eventCopy, [](Napi::Env env, Napi::Function jsCallback, std::string* event) {
-                    jsCallback.Call({Napi::String::New(env, *event)});
-                    delete event;
-                });
-            }
+    if (handle < 0) {
+        return Napi::Number::New(env, -1);
+    }
+    
+    g_eventBus.addListener(env);
+    int32_t nativeId = g_keyListener->registerDoubleTapListener(key, threshold,
+        [handle](const std::string& event, EventTime at) {
+            PushListenerEvent(NativeEventKind::DoubleTap, handle, InternListenerEventName(event), 0, at);
         });
-        
-        if (result >= 0) {
-            return Napi::Number::New(env, listenerId);
-        }
+    
+    if (nativeId < 0) {
+        g_doubleTapCallbacks.remove(handle);
+        g_eventBus.removeListener(env);
+        return Napi::Number::New(env, -1);
     }
     
-    return Napi::Number::New(env, -1);
+    g_doubleTapCallbacks.setNativeId(handle, nativeId);
+    return Napi::Number::New(env, handle);
 }
 
 Napi::Value RegisterHoldListener(const Napi::CallbackInfo& info) {
@@ -388,38 +1063,64 @@ Napi::Value RegisterHoldListener(const Napi::CallbackInfo& info) {
     std::string key = info[0].As<Napi::String>().Utf8Value();
     Napi::Function callback = info[1].As<Napi::Function>();
     
-    int listenerId = g_nextHoldId++;
+    int32_t handle = g_holdCallbacks.add(callback);
     
-    if (listenerId < 256) {
-        g_holdCallbacks[listenerId] = Napi::ThreadSafeFunction::New(
-            env,
-            callback,
-            "HoldCallback" + std::to_string(listenerId),
-            0,
-            1
-        );
-        
-        int32_t result = g_keyListener->registerHoldListener(key, [listenerId](const std::string& event, int duration) {
-            if (g_holdCallbacks[listenerId]) {
-                std::string* eventCopy = new std::string(event);
-                int* durationCopy = new int(duration);
-                g_holdCallbacks[listenerId].BlockingCall(eventCopy, [durationCopy](Napi::Env env, Napi::Function jsCallback, std::string* event) {
-                    jsCallback.Call({
-                        Napi::String::New(env, *event),
-                        Napi::Number::New(env, *durationCopy)
-                    });
-                    delete event;
-                    delete durationCopy;
-                });
-            }
+    if (handle < 0) {
+        return Napi::Number::New(env, -1);
+    }
+    
+    g_eventBus.addListener(env);
+    int32_t nativeId = g_keyListener->registerHoldListener(key,
+        [handle](const std::string& event, int duration, EventTime at) {
+            PushListenerEvent(NativeEventKind::Hold, handle, InternListenerEventName(event), duration, at);
         });
-        
-        if (result >= 0) {
-            return Napi::Number::New(env, listenerId);
-        }
+    
+    if (nativeId < 0) {
+        g_holdCallbacks.remove(handle);
+        g_eventBus.removeListener(env);
+        return Napi::Number::New(env, -1);
     }
     
-    return Napi::Number::New(env, -1);
+    g_holdCallbacks.setNativeId(handle, nativeId);
+    return Napi::Number::New(env, handle);
+}
+
+Napi::Value RegisterGestureListener(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsFunction()) {
+        Napi::TypeError::New(env, "Gesture spec string and callback expected").ThrowAsJavaScriptException();
+        return Napi::Number::New(env, -1);
+    }
+    
+    if (!g_keyListener) {
+        g_keyListener = std::make_unique<KeyListener>();
+        g_keyListener->start();
+    }
+    
+    std::string spec = info[0].As<Napi::String>().Utf8Value();
+    Napi::Function callback = info[1].As<Napi::Function>();
+    
+    int32_t handle = g_gestureCallbacks.add(callback);
+    
+    if (handle < 0) {
+        return Napi::Number::New(env, -1);
+    }
+    
+    g_eventBus.addListener(env);
+    int32_t nativeId = g_keyListener->registerGestureListener(spec,
+        [handle](const std::string& event, int duration, EventTime at) {
+            PushListenerEvent(NativeEventKind::Gesture, handle, InternListenerEventName(event), duration, at);
+        });
+    
+    if (nativeId < 0) {
+        g_gestureCallbacks.remove(handle);
+        g_eventBus.removeListener(env);
+        return Napi::Number::New(env, -1);
+    }
+    
+    g_gestureCallbacks.setNativeId(handle, nativeId);
+    return Napi::Number::New(env, handle);
 }
 
 Napi::Value UnregisterDoubleTapListener(const Napi::CallbackInfo& info) {
@@ -436,10 +1137,12 @@ Napi::Value UnregisterDoubleTapListener(const Napi::CallbackInfo& info) {
         return Napi::Boolean::New(env, false);
     }
     
-    bool success = g_keyListener->unregisterDoubleTapListener(id);
+    int32_t nativeId = g_doubleTapCallbacks.nativeId(id);
+    bool success = nativeId >= 0 && g_keyListener->unregisterDoubleTapListener(nativeId);
     
-    if (success && id >= 0 && id < 256 && g_doubleTapCallbacks[id]) {
-        g_doubleTapCallbacks[id].Release();
+    if (success) {
+        g_doubleTapCallbacks.remove(id);
+        g_eventBus.removeListener(env);
     }
     
     return Napi::Boolean::New(env, success);
@@ -459,22 +1162,601 @@ Napi::Value UnregisterHoldListener(const Napi::CallbackInfo& info) {
         return Napi::Boolean::New(env, false);
     }
     
-    bool success = g_keyListener->unregisterHoldListener(id);
+    int32_t nativeId = g_holdCallbacks.nativeId(id);
+    bool success = nativeId >= 0 && g_keyListener->unregisterHoldListener(nativeId);
     
-    if (success && id >= 0 && id < 256 && g_holdCallbacks[id]) {
-        g_holdCallbacks[id].Release();
+    if (success) {
+        g_holdCallbacks.remove(id);
+        g_eventBus.removeListener(env);
     }
     
     return Napi::Boolean::New(env, success);
 }
 
+Napi::Value UnregisterGestureListener(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Listener ID expected").ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
+    }
+    
+    int32_t id = info[0].As<Napi::Number>().Int32Value();
+    
+    if (!g_keyListener) {
+        return Napi::Boolean::New(env, false);
+    }
+    
+    int32_t nativeId = g_gestureCallbacks.nativeId(id);
+    bool success = nativeId >= 0 && g_keyListener->unregisterGestureListener(nativeId);
+    
+    if (success) {
+        g_gestureCallbacks.remove(id);
+        g_eventBus.removeListener(env);
+    }
+    
+    return Napi::Boolean::New(env, success);
+}
+
+static bool ParseContextRuleKind(const std::string& kind, ContextRuleKind& result) {
+    if (kind == "process") {
+        result = ContextRuleKind::Process;
+    } else if (kind == "bundle") {
+        result = ContextRuleKind::Bundle;
+    } else if (kind == "web") {
+        result = ContextRuleKind::Web;
+    } else if (kind == "browserProcess") {
+        result = ContextRuleKind::BrowserProcess;
+    } else if (kind == "browserBundle") {
+        result = ContextRuleKind::BrowserBundle;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static std::string GetStringProperty(Napi::Object object, const char* name) {
+    Napi::Value value = object.Get(name);
+    return value.IsString() ? value.As<Napi::String>().Utf8Value() : std::string();
+}
+
+Napi::Value SetAppContexts(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Array of context rules expected").ThrowAsJavaScriptException();
+        return Napi::Number::New(env, -1);
+    }
+    
+    Napi::Array array = info[0].As<Napi::Array>();
+    std::vector<ContextRule> rules;
+    rules.reserve(array.Length());
+    
+    for (uint32_t i = 0; i < array.Length(); i++) {
+        Napi::Value entry = array.Get(i);
+        if (!entry.IsObject()) {
+            Napi::TypeError::New(env, "Context rule object expected").ThrowAsJavaScriptException();
+            return Napi::Number::New(env, -1);
+        }
+        
+        Napi::Object object = entry.As<Napi::Object>();
+        ContextRule rule;
+        if (!ParseContextRuleKind(GetStringProperty(object, "kind"), rule.kind)) {
+            Napi::TypeError::New(env, "Unknown context rule kind").ThrowAsJavaScriptException();
+            return Napi::Number::New(env, -1);
+        }
+        rule.contextType = GetStringProperty(object, "context");
+        rule.appName = GetStringProperty(object, "appName");
+        rule.pattern = GetStringProperty(object, "pattern");
+        rules.push_back(std::move(rule));
+    }
+    
+    ContextMatcher::instance().compile(rules);
+    
+    return Napi::Number::New(env, static_cast<double>(rules.size()));
+}
+
+Napi::Value MatchAppContext(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Window info object expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Napi::Object object = info[0].As<Napi::Object>();
+    ActiveWindowInfo windowInfo;
+    windowInfo.title = GetStringProperty(object, "title");
+    windowInfo.processName = GetStringProperty(object, "processName");
+    windowInfo.bundleId = GetStringProperty(object, "bundleId");
+    
+    ContextMatch match;
+    if (!ContextMatcher::instance().match(windowInfo, match)) {
+        return env.Null();
+    }
+    
+    return ContextMatchToObject(env, match);
+}
+
+static Napi::Array SnippetMatchesToArray(Napi::Env env, const SnippetSet& set, const std::vector<SnippetMatch>& matches) {
+    Napi::Array result = Napi::Array::New(env, matches.size());
+    for (size_t i = 0; i < matches.size(); i++) {
+        const SnippetMatch& match = matches[i];
+        const SnippetEntry& entry = set.entries[match.entry];
+        
+        Napi::Object object = Napi::Object::New(env);
+        object.Set("id", Napi::String::New(env, entry.id));
+        object.Set("value", Napi::String::New(env, entry.value));
+        object.Set("start", Napi::Number::New(env, static_cast<double>(match.start)));
+        object.Set("end", Napi::Number::New(env, static_cast<double>(match.end)));
+        result.Set(static_cast<uint32_t>(i), object);
+    }
+    return result;
+}
+
+Napi::Value CompileSnippets(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Array of snippets expected").ThrowAsJavaScriptException();
+        return Napi::Number::New(env, -1);
+    }
+    
+    Napi::Array array = info[0].As<Napi::Array>();
+    std::vector<SnippetEntry> entries;
+    entries.reserve(array.Length());
+    
+    for (uint32_t i = 0; i < array.Length(); i++) {
+        Napi::Value value = array.Get(i);
+        if (!value.IsObject()) {
+            Napi::TypeError::New(env, "Snippet object expected").ThrowAsJavaScriptException();
+            return Napi::Number::New(env, -1);
+        }
+        
+        Napi::Object object = value.As<Napi::Object>();
+        SnippetEntry entry;
+        entry.id = GetStringProperty(object, "id");
+        entry.value = GetStringProperty(object, "value");
+        
+        Napi::Value triggers = object.Get("triggers");
+        if (triggers.IsArray()) {
+            Napi::Array triggerArray = triggers.As<Napi::Array>();
+            for (uint32_t j = 0; j < triggerArray.Length(); j++) {
+                Napi::Value trigger = triggerArray.Get(j);
+                if (trigger.IsString()) {
+                    entry.triggers.push_back(trigger.As<Napi::String>().Utf8Value());
+                }
+            }
+        }
+        entries.push_back(std::move(entry));
+    }
+    
+    size_t patterns = SnippetMatcher::instance().compile(std::move(entries));
+    return Napi::Number::New(env, static_cast<double>(patterns));
+}
+
+Napi::Value MatchSnippets(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Text string expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::vector<SnippetMatch> matches;
+    SnippetStream stream(SnippetMatcher::instance().current());
+    stream.append(info[0].As<Napi::String>().Utf8Value(), matches);
+    stream.finish(matches);
+    
+    return SnippetMatchesToArray(env, stream.set(), matches);
+}
+
+// Streams stay bound to the snippet set they were created or last reset
+// with, so a recompile mid-utterance never invalidates their state.
+static std::unordered_map<uint32_t, std::unique_ptr<SnippetStream>> g_snippetStreams;
+static uint32_t g_nextSnippetStream = 1;
+
+static SnippetStream* FindSnippetStream(const Napi::CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        return nullptr;
+    }
+    
+    auto it = g_snippetStreams.find(info[0].As<Napi::Number>().Uint32Value());
+    return it == g_snippetStreams.end() ? nullptr : it->second.get();
+}
+
+Napi::Value CreateSnippetStream(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    uint32_t handle = g_nextSnippetStream++;
+    g_snippetStreams.emplace(handle, std::make_unique<SnippetStream>(SnippetMatcher::instance().current()));
+    
+    return Napi::Number::New(env, handle);
+}
+
+Napi::Value SnippetStreamAppend(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    SnippetStream* stream = FindSnippetStream(info);
+    if (!stream || info.Length() < 2 || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Stream handle and text delta expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    bool finished = info.Length() > 2 && info[2].IsBoolean() && info[2].As<Napi::Boolean>().Value();
+    
+    std::vector<SnippetMatch> committed;
+    std::vector<SnippetMatch> pending;
+    stream->append(info[1].As<Napi::String>().Utf8Value(), committed);
+    if (finished) {
+        stream->finish(committed);
+    } else {
+        stream->pending(pending);
+    }
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("committed", SnippetMatchesToArray(env, stream->set(), committed));
+    result.Set("pending", SnippetMatchesToArray(env, stream->set(), pending));
+    result.Set("length", Napi::Number::New(env, static_cast<double>(stream->length())));
+    
+    return result;
+}
+
+Napi::Value SnippetStreamReset(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    SnippetStream* stream = FindSnippetStream(info);
+    if (stream) {
+        stream->reset(SnippetMatcher::instance().current());
+    }
+    
+    return Napi::Boolean::New(env, stream != nullptr);
+}
+
+Napi::Value CloseSnippetStream(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        return Napi::Boolean::New(env, false);
+    }
+    
+    return Napi::Boolean::New(env, g_snippetStreams.erase(info[0].As<Napi::Number>().Uint32Value()) > 0);
+}
+
+Napi::Value SetContextDictionary(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsObject()) {
+        Napi::TypeError::New(env, "Context id and replacements object expected").ThrowAsJavaScriptException();
+        return Napi::Number::New(env, -1);
+    }
+    
+    Napi::Object object = info[1].As<Napi::Object>();
+    Napi::Array keys = object.GetPropertyNames();
+    std::vector<std::pair<std::string, std::string>> replacements;
+    replacements.reserve(keys.Length());
+    
+    for (uint32_t i = 0; i < keys.Length(); i++) {
+        Napi::Value key = keys.Get(i);
+        Napi::Value value = object.Get(key);
+        if (key.IsString() && value.IsString()) {
+            replacements.emplace_back(key.As<Napi::String>().Utf8Value(), value.As<Napi::String>().Utf8Value());
+        }
+    }
+    
+    std::string contextId = info[0].As<Napi::String>().Utf8Value();
+    size_t phrases = PhraseRewriter::instance().compile(contextId, replacements);
+    return Napi::Number::New(env, static_cast<double>(phrases));
+}
+
+Napi::Value RewriteWithDictionary(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Context id and text expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    auto dictionary = PhraseRewriter::instance().find(info[0].As<Napi::String>().Utf8Value());
+    if (!dictionary) {
+        return env.Null();
+    }
+    
+    return Napi::String::New(env, dictionary->rewrite(info[1].As<Napi::String>().Utf8Value()));
+}
+
+Napi::Value SetLanguageHints(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Array of language hints expected").ThrowAsJavaScriptException();
+        return Napi::Number::New(env, -1);
+    }
+    
+    Napi::Array array = info[0].As<Napi::Array>();
+    std::vector<LanguageHint> hints;
+    hints.reserve(array.Length());
+    
+    for (uint32_t i = 0; i < array.Length(); i++) {
+        Napi::Value value = array.Get(i);
+        if (!value.IsObject()) {
+            Napi::TypeError::New(env, "Language hint object expected").ThrowAsJavaScriptException();
+            return Napi::Number::New(env, -1);
+        }
+        
+        Napi::Object object = value.As<Napi::Object>();
+        LanguageHint hint;
+        hint.language = GetStringProperty(object, "language");
+        Napi::Value weight = object.Get("weight");
+        hint.weight = weight.IsNumber() ? weight.As<Napi::Number>().DoubleValue() : 1.0;
+        
+        Napi::Value words = object.Get("words");
+        if (words.IsArray()) {
+            Napi::Array wordArray = words.As<Napi::Array>();
+            for (uint32_t j = 0; j < wordArray.Length(); j++) {
+                Napi::Value word = wordArray.Get(j);
+                if (word.IsString()) {
+                    hint.words.push_back(word.As<Napi::String>().Utf8Value());
+                }
+            }
+        }
+        hints.push_back(std::move(hint));
+    }
+    
+    size_t words = ScriptDetector::instance().setHints(std::move(hints));
+    return Napi::Number::New(env, static_cast<double>(words));
+}
+
+Napi::Value DetectScripts(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Text string expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    ScriptProfile profile;
+    ScriptDetector::instance().analyze(info[0].As<Napi::String>().Utf8Value(), profile);
+    
+    const uint32_t scriptCount = static_cast<uint32_t>(Script::Count);
+    Napi::Array scripts = Napi::Array::New(env, scriptCount);
+    for (uint32_t i = 0; i < scriptCount; i++) {
+        scripts.Set(i, Napi::Number::New(env, profile.scripts[i]));
+    }
+    
+    Napi::Array hintScores = Napi::Array::New(env, profile.hintScores.size());
+    for (size_t i = 0; i < profile.hintScores.size(); i++) {
+        hintScores.Set(static_cast<uint32_t>(i), Napi::Number::New(env, profile.hintScores[i]));
+    }
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("scripts", scripts);
+    result.Set("hintScores", hintScores);
+    return result;
+}
+
+Napi::Value GetScriptNames(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    const uint32_t scriptCount = static_cast<uint32_t>(Script::Count);
+    Napi::Array names = Napi::Array::New(env, scriptCount);
+    for (uint32_t i = 0; i < scriptCount; i++) {
+        names.Set(i, Napi::String::New(env, ScriptName(static_cast<Script>(i))));
+    }
+    return names;
+}
+
+Napi::Value LoadLanguageModel(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Profile path expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string error;
+    bool loaded = LanguageModel::instance().load(info[0].As<Napi::String>().Utf8Value(), error);
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("loaded", Napi::Boolean::New(env, loaded));
+    result.Set("languages", Napi::Number::New(env, static_cast<double>(LanguageModel::instance().languages().size())));
+    if (!loaded) {
+        result.Set("error", Napi::String::New(env, error));
+    }
+    return result;
+}
+
+Napi::Value IdentifyLanguage(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Text string expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    size_t maxResults = 3;
+    if (info.Length() > 1 && info[1].IsNumber()) {
+        maxResults = info[1].As<Napi::Number>().Uint32Value();
+    }
+    
+    std::vector<LanguageGuess> guesses =
+        LanguageModel::instance().identify(info[0].As<Napi::String>().Utf8Value(), maxResults);
+    
+    Napi::Array result = Napi::Array::New(env, guesses.size());
+    for (size_t i = 0; i < guesses.size(); i++) {
+        Napi::Object guess = Napi::Object::New(env);
+        guess.Set("language", Napi::String::New(env, guesses[i].language));
+        guess.Set("confidence", Napi::Number::New(env, guesses[i].confidence));
+        result.Set(static_cast<uint32_t>(i), guess);
+    }
+    return result;
+}
+
+Napi::Value SetTextPatterns(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Array of pattern groups expected").ThrowAsJavaScriptException();
+        return Napi::Number::New(env, -1);
+    }
+    
+    Napi::Array array = info[0].As<Napi::Array>();
+    std::vector<PatternGroup> groups;
+    groups.reserve(array.Length());
+    
+    for (uint32_t i = 0; i < array.Length(); i++) {
+        Napi::Value value = array.Get(i);
+        if (!value.IsObject()) {
+            Napi::TypeError::New(env, "Pattern group object expected").ThrowAsJavaScriptException();
+            return Napi::Number::New(env, -1);
+        }
+        
+        Napi::Object object = value.As<Napi::Object>();
+        PatternGroup group;
+        std::string mode = GetStringProperty(object, "mode");
+        if (mode == "start") {
+            group.mode = PatternMode::Start;
+        } else if (mode == "first") {
+            group.mode = PatternMode::First;
+        } else if (mode == "words") {
+            group.mode = PatternMode::Words;
+        } else {
+            Napi::TypeError::New(env, "Pattern mode must be start, first or words").ThrowAsJavaScriptException();
+            return Napi::Number::New(env, -1);
+        }
+        
+        Napi::Value phrases = object.Get("phrases");
+        if (phrases.IsArray()) {
+            Napi::Array phraseArray = phrases.As<Napi::Array>();
+            for (uint32_t j = 0; j < phraseArray.Length(); j++) {
+                Napi::Value phrase = phraseArray.Get(j);
+                if (phrase.IsString()) {
+                    group.phrases.push_back(phrase.As<Napi::String>().Utf8Value());
+                }
+            }
+        }
+        groups.push_back(std::move(group));
+    }
+    
+    size_t phrases = TextMetricsAnalyzer::instance().setPatterns(std::move(groups));
+    return Napi::Number::New(env, static_cast<double>(phrases));
+}
+
+Napi::Value AnalyzeTextMetrics(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Text string expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    TextMetrics metrics;
+    TextMetricsAnalyzer::instance().analyze(info[0].As<Napi::String>().Utf8Value(), metrics);
+    
+    double words = metrics.wordCount > 0 ? metrics.wordCount : 1;
+    Napi::Object punctuation = Napi::Object::New(env);
+    punctuation.Set("semicolonUsage", Napi::Number::New(env, metrics.semicolons / words));
+    punctuation.Set("exclamationUsage", Napi::Number::New(env, metrics.exclamations / words));
+    punctuation.Set("ellipsisUsage", Napi::Number::New(env, metrics.ellipses / words));
+    
+    Napi::Array patternMatches = Napi::Array::New(env, metrics.groupMatches.size());
+    for (size_t i = 0; i < metrics.groupMatches.size(); i++) {
+        const auto& matches = metrics.groupMatches[i];
+        Napi::Array group = Napi::Array::New(env, matches.size());
+        for (size_t j = 0; j < matches.size(); j++) {
+            group.Set(static_cast<uint32_t>(j), Napi::String::New(env, matches[j]));
+        }
+        patternMatches.Set(static_cast<uint32_t>(i), group);
+    }
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("sentenceCount", Napi::Number::New(env, metrics.sentenceCount));
+    result.Set("wordCount", Napi::Number::New(env, metrics.wordCount));
+    result.Set("averageSentenceLength", Napi::Number::New(env, metrics.averageSentenceLength));
+    result.Set("uniqueWordCount", Napi::Number::New(env, metrics.uniqueWordCount));
+    result.Set("punctuationUsage", punctuation);
+    result.Set("patternMatches", patternMatches);
+    return result;
+}
+
+Napi::Value OnNativeEvents(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !(info[0].IsFunction() || info[0].IsNull() || info[0].IsUndefined())) {
+        Napi::TypeError::New(env, "Callback function or null expected").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    
+    if (info[0].IsFunction()) {
+        g_eventBus.setBatchCallback(info[0].As<Napi::Function>());
+    } else {
+        g_eventBus.clearBatchCallback();
+    }
+    
+    return env.Undefined();
+}
+
+Napi::Value GetDisplayPoolStatsJs(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    DisplayPoolStats stats = GetDisplayPoolStats();
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("opened", Napi::Number::New(env, static_cast<double>(stats.opened)));
+    result.Set("acquired", Napi::Number::New(env, static_cast<double>(stats.acquired)));
+    result.Set("avoidedOpens", Napi::Number::New(env, static_cast<double>(stats.avoidedOpens)));
+    result.Set("live", Napi::Number::New(env, stats.live));
+    
+    return result;
+}
+
+// Per-stage latency percentiles in microseconds, keyed by stage name, plus
+// the events the bus had to drop because JS fell behind.
+Napi::Value GetNativeMetrics(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    Napi::Object stages = Napi::Object::New(env);
+    for (size_t i = 0; i < static_cast<size_t>(LatencyStage::Count); i++) {
+        LatencyStage stage = static_cast<LatencyStage>(i);
+        LatencySummary summary = GetLatencySummary(stage);
+        
+        Napi::Object entry = Napi::Object::New(env);
+        entry.Set("count", Napi::Number::New(env, static_cast<double>(summary.count)));
+        entry.Set("p50", Napi::Number::New(env, static_cast<double>(summary.p50Us)));
+        entry.Set("p95", Napi::Number::New(env, static_cast<double>(summary.p95Us)));
+        entry.Set("p99", Napi::Number::New(env, static_cast<double>(summary.p99Us)));
+        entry.Set("max", Napi::Number::New(env, static_cast<double>(summary.maxUs)));
+        stages.Set(LatencyStageName(stage), entry);
+    }
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("stages", stages);
+    result.Set("droppedEvents", Napi::Number::New(env, static_cast<double>(g_eventBus.dropped())));
+    
+    return result;
+}
+
+Napi::Value ResetNativeMetrics(const Napi::CallbackInfo& info) {
+    ResetLatencyMetrics();
+    return info.Env().Undefined();
+}
+
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
+    InitializeDisplayThreads();
+    napi_add_env_cleanup_hook(env, FlushInjectionStrategy, nullptr);
+    
     exports.Set("getActiveWindow", Napi::Function::New(env, GetActiveWindow));
     exports.Set("startWindowWatcher", Napi::Function::New(env, StartWindowWatcher));
     exports.Set("stopWindowWatcher", Napi::Function::New(env, StopWindowWatcher));
     
     exports.Set("injectText", Napi::Function::New(env, InjectText));
     exports.Set("injectTextWithDelay", Napi::Function::New(env, InjectTextWithDelay));
+    exports.Set("injectTextAsync", Napi::Function::New(env, InjectTextAsync));
+    exports.Set("injectTextWithDelayAsync", Napi::Function::New(env, InjectTextWithDelayAsync));
+    exports.Set("cancelInjection", Napi::Function::New(env, CancelInjection));
+    exports.Set("cancelAllInjections", Napi::Function::New(env, CancelAllInjections));
+    exports.Set("setInjectionStatsPath", Napi::Function::New(env, SetInjectionStatsPath));
+    exports.Set("getInjectionStats", Napi::Function::New(env, GetInjectionStats));
     exports.Set("pasteFromClipboard", Napi::Function::New(env, PasteFromClipboard));
     exports.Set("setClipboardText", Napi::Function::New(env, SetClipboardText));
     exports.Set("getClipboardText", Napi::Function::New(env, GetClipboardText));
@@ -488,8 +1770,36 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
     exports.Set("registerHoldListener", Napi::Function::New(env, RegisterHoldListener));
     exports.Set("unregisterDoubleTapListener", Napi::Function::New(env, UnregisterDoubleTapListener));
     exports.Set("unregisterHoldListener", Napi::Function::New(env, UnregisterHoldListener));
+    exports.Set("registerGestureListener", Napi::Function::New(env, RegisterGestureListener));
+    exports.Set("unregisterGestureListener", Napi::Function::New(env, UnregisterGestureListener));
+    
+    exports.Set("setAppContexts", Napi::Function::New(env, SetAppContexts));
+    exports.Set("matchAppContext", Napi::Function::New(env, MatchAppContext));
+    
+    exports.Set("compileSnippets", Napi::Function::New(env, CompileSnippets));
+    exports.Set("matchSnippets", Napi::Function::New(env, MatchSnippets));
+    exports.Set("createSnippetStream", Napi::Function::New(env, CreateSnippetStream));
+    exports.Set("snippetStreamAppend", Napi::Function::New(env, SnippetStreamAppend));
+    exports.Set("snippetStreamReset", Napi::Function::New(env, SnippetStreamReset));
+    exports.Set("closeSnippetStream", Napi::Function::New(env, CloseSnippetStream));
+    exports.Set("setContextDictionary", Napi::Function::New(env, SetContextDictionary));
+    exports.Set("rewriteWithDictionary", Napi::Function::New(env, RewriteWithDictionary));
+    exports.Set("setLanguageHints", Napi::Function::New(env, SetLanguageHints));
+    exports.Set("detectScripts", Napi::Function::New(env, DetectScripts));
+    exports.Set("getScriptNames", Napi::Function::New(env, GetScriptNames));
+    exports.Set("loadLanguageModel", Napi::Function::New(env, LoadLanguageModel));
+    exports.Set("identifyLanguage", Napi::Function::New(env, IdentifyLanguage));
+    exports.Set("setTextPatterns", Napi::Function::New(env, SetTextPatterns));
+    exports.Set("analyzeTextMetrics", Napi::Function::New(env, AnalyzeTextMetrics));
+    
+    exports.Set("onNativeEvents", Napi::Function::New(env, OnNativeEvents));
     
     exports.Set("getPlatform", Napi::Function::New(env, GetPlatform));
+    exports.Set("setInputBackend", Napi::Function::New(env, SetInputBackend));
+    exports.Set("getInputBackend", Napi::Function::New(env, GetInputBackendJs));
+    exports.Set("getDisplayPoolStats", Napi::Function::New(env, GetDisplayPoolStatsJs));
+    exports.Set("getNativeMetrics", Napi::Function::New(env, GetNativeMetrics));
+    exports.Set("resetNativeMetrics", Napi::Function::New(env, ResetNativeMetrics));
     
     return exports;
 }
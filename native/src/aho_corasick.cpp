@@ -0,0 +1,103 @@
+#include "aho_corasick.h"
+#include <deque>
+
+namespace speechly {
+
+namespace {
+
+unsigned char FoldAscii(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c - 'A' + 'a') : c;
+}
+
+}
+
+AhoCorasick::AhoCorasick() : classCount_(1) {
+    classes_.fill(0);
+}
+
+int32_t AhoCorasick::addPattern(const std::string& pattern) {
+    std::string folded(pattern);
+    for (auto& c : folded) {
+        c = static_cast<char>(FoldAscii(static_cast<unsigned char>(c)));
+    }
+    patterns_.push_back(std::move(folded));
+    return static_cast<int32_t>(patterns_.size() - 1);
+}
+
+void AhoCorasick::build() {
+    classes_.fill(0);
+    classCount_ = 1;
+    for (const auto& pattern : patterns_) {
+        for (unsigned char c : pattern) {
+            if (classes_[c] == 0) {
+                classes_[c] = static_cast<uint16_t>(classCount_++);
+            }
+        }
+    }
+    for (int c = 'A'; c <= 'Z'; c++) {
+        classes_[c] = classes_[FoldAscii(static_cast<unsigned char>(c))];
+    }
+
+    transitions_.assign(classCount_, -1);
+    firstOutput_.assign(1, -1);
+    depths_.assign(1, 0);
+    nextOutput_.assign(patterns_.size(), -1);
+
+    for (size_t id = 0; id < patterns_.size(); id++) {
+        int32_t state = kRootState;
+        for (unsigned char c : patterns_[id]) {
+            size_t slot = static_cast<size_t>(state) * classCount_ + classes_[c];
+            if (transitions_[slot] < 0) {
+                int32_t next = static_cast<int32_t>(firstOutput_.size());
+                transitions_[slot] = next;
+                transitions_.resize(transitions_.size() + classCount_, -1);
+                firstOutput_.push_back(-1);
+                depths_.push_back(depths_[state] + 1);
+            }
+            state = transitions_[static_cast<size_t>(state) * classCount_ + classes_[c]];
+        }
+
+        // Empty patterns would match everywhere; they are kept for stable
+        // ids but never reported.
+        if (state != kRootState) {
+            nextOutput_[id] = firstOutput_[state];
+            firstOutput_[state] = static_cast<int32_t>(id);
+        }
+    }
+
+    size_t stateCount = firstOutput_.size();
+    std::vector<int32_t> failure(stateCount, kRootState);
+    dictionaryLinks_.assign(stateCount, kRootState);
+
+    std::deque<int32_t> queue;
+    for (size_t cls = 0; cls < classCount_; cls++) {
+        int32_t& next = transitions_[cls];
+        if (next < 0) {
+            next = kRootState;
+        } else {
+            queue.push_back(next);
+        }
+    }
+
+    while (!queue.empty()) {
+        int32_t state = queue.front();
+        queue.pop_front();
+
+        int32_t fail = failure[state];
+        dictionaryLinks_[state] = firstOutput_[fail] >= 0 ? fail : dictionaryLinks_[fail];
+
+        for (size_t cls = 0; cls < classCount_; cls++) {
+            size_t slot = static_cast<size_t>(state) * classCount_ + cls;
+            int32_t fallback = transitions_[static_cast<size_t>(fail) * classCount_ + cls];
+
+            if (transitions_[slot] < 0) {
+                transitions_[slot] = fallback;
+            } else {
+                failure[transitions_[slot]] = fallback;
+                queue.push_back(transitions_[slot]);
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,82 @@
+#ifndef AHO_CORASICK_H
+#define AHO_CORASICK_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace speechly {
+
+// Byte-level Aho-Corasick automaton compiled to a dense DFA, so matching is
+// one table lookup per input byte with no failure-link walking. Bytes that
+// never occur in a pattern share one input class to keep the table small.
+// ASCII letters are matched case-insensitively; other bytes, including
+// UTF-8 sequences, must match exactly.
+//
+// step()/forEachMatch() let callers carry the state across chunks of a
+// stream; scan() is the one-shot form. depth() is the length of the longest
+// pattern prefix a state stands for, so no match reported later can start
+// more than depth() bytes before the current position.
+class AhoCorasick {
+public:
+    static constexpr int32_t kRootState = 0;
+
+    AhoCorasick();
+
+    int32_t addPattern(const std::string& pattern);
+    void build();
+
+    bool empty() const { return patterns_.empty(); }
+    size_t patternCount() const { return patterns_.size(); }
+    size_t patternLength(int32_t id) const { return patterns_[id].size(); }
+    size_t depth(int32_t state) const { return depths_[state]; }
+
+    int32_t step(int32_t state, unsigned char byte) const {
+        return transitions_[static_cast<size_t>(state) * classCount_ + classes_[byte]];
+    }
+
+    template <typename F>
+    void forEachMatch(int32_t state, F&& onMatch) const {
+        for (int32_t s = state; s > kRootState; s = dictionaryLinks_[s]) {
+            for (int32_t id = firstOutput_[s]; id >= 0; id = nextOutput_[id]) {
+                onMatch(id);
+            }
+        }
+    }
+
+    // Calls onMatch(patternId, endOffset) for every occurrence, where
+    // endOffset is one past the last matched byte.
+    template <typename F>
+    void scan(const char* text, size_t length, F&& onMatch) const {
+        if (transitions_.empty()) {
+            return;
+        }
+
+        int32_t state = kRootState;
+        for (size_t i = 0; i < length; i++) {
+            state = step(state, static_cast<unsigned char>(text[i]));
+            forEachMatch(state, [&](int32_t id) { onMatch(id, i + 1); });
+        }
+    }
+
+    template <typename F>
+    void scan(const std::string& text, F&& onMatch) const {
+        scan(text.data(), text.size(), onMatch);
+    }
+
+private:
+    std::vector<std::string> patterns_;
+    std::array<uint16_t, 256> classes_;
+    size_t classCount_;
+    std::vector<int32_t> transitions_;
+    std::vector<int32_t> firstOutput_;
+    std::vector<int32_t> nextOutput_;
+    std::vector<int32_t> dictionaryLinks_;
+    std::vector<uint32_t> depths_;
+};
+
+}
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef CASE_FOLD_H
+#define CASE_FOLD_H
+
+#include "utf8.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace speechly {
+
+// Simple lowercase folding for Latin-1, Latin Extended-A, Greek and
+// Cyrillic capitals. Every mapping keeps the UTF-8 and UTF-16 length of the
+// character, so offsets into folded text are offsets into the original.
+// Characters whose lowercase form has a different length (U+0130) are left
+// as they are.
+inline uint32_t FoldCase(uint32_t codepoint) {
+    if (codepoint < 0x80) {
+        return (codepoint >= 'A' && codepoint <= 'Z') ? codepoint + 0x20 : codepoint;
+    }
+    if (codepoint >= 0xC0 && codepoint <= 0xDE && codepoint != 0xD7) {
+        return codepoint + 0x20;
+    }
+    if ((codepoint >= 0x100 && codepoint <= 0x137 && codepoint != 0x130) ||
+        (codepoint >= 0x14A && codepoint <= 0x177)) {
+        return codepoint | 1;
+    }
+    if ((codepoint >= 0x139 && codepoint <= 0x148) || (codepoint >= 0x179 && codepoint <= 0x17E)) {
+        return (codepoint & 1) ? codepoint + 1 : codepoint;
+    }
+    if (codepoint == 0x178) {
+        return 0xFF;
+    }
+    if (codepoint >= 0x391 && codepoint <= 0x3AB && codepoint != 0x3A2) {
+        return codepoint + 0x20;
+    }
+    if (codepoint >= 0x400 && codepoint <= 0x40F) {
+        return codepoint + 0x50;
+    }
+    if (codepoint >= 0x410 && codepoint <= 0x42F) {
+        return codepoint + 0x20;
+    }
+    return codepoint;
+}
+
+// Appends the folded form of text to out. Bytes that do not decode are
+// copied through untouched, so a sequence split across two calls survives.
+inline void AppendFoldedUtf8(std::string& out, const char* text, size_t length) {
+    size_t pos = 0;
+    while (pos < length) {
+        size_t start = pos;
+        uint32_t codepoint = DecodeUtf8(text, length, pos);
+        uint32_t folded = FoldCase(codepoint);
+        if (folded != codepoint) {
+            AppendUtf8(out, folded);
+        } else {
+            out.append(text + start, pos - start);
+        }
+    }
+}
+
+inline std::string FoldUtf8(const std::string& text) {
+    std::string folded;
+    folded.reserve(text.size());
+    AppendFoldedUtf8(folded, text.data(), text.size());
+    return folded;
+}
+
+// Appends codepoint case-folded and without diacritics, for matching that
+// ignores accents ("égal" and "EGAL" both give "egal"). Unlike FoldCase this
+// changes lengths, and a few letters expand ("œ" gives "oe").
+inline void AppendAccentFolded(std::string& out, uint32_t codepoint) {
+    // Base letters for U+00E0..U+017F after case folding; '*' marks the
+    // letters that expand and '_' the one character that is not a letter.
+    static const char kBaseLetters[] =
+        "aaaaaa*ceeeeiiiidnooooo_ouuuuy*y"
+        "aaaaaaccccccccddddeeeeeeeeeegggggggghhhhiiiiiiiiii**jjkkklllllll"
+        "lllnnnnnnnnnoooooo**rrrrrrssssssssttttttuuuuuuuuuuuuwwyyyzzzzzzs";
+
+    codepoint = FoldCase(codepoint);
+    if (codepoint < 0x80) {
+        out += static_cast<char>(codepoint);
+        return;
+    }
+
+    char base = (codepoint >= 0xE0 && codepoint < 0x180) ? kBaseLetters[codepoint - 0xE0] : '_';
+    if (base != '*' && base != '_') {
+        out += base;
+        return;
+    }
+
+    switch (codepoint) {
+        case 0xDF: out += "ss"; return;
+        case 0xE6: out += "ae"; return;
+        case 0xFE: out += "th"; return;
+        case 0x133: out += "ij"; return;
+        case 0x153: out += "oe"; return;
+        default: AppendUtf8(out, codepoint); return;
+    }
+}
+
+// Number of UTF-16 code units the byte adds when it starts a character,
+// which is how JS string offsets count.
+inline size_t Utf16UnitsForByte(unsigned char byte) {
+    if ((byte & 0xC0) == 0x80) {
+        return 0;
+    }
+    return byte >= 0xF0 ? 2 : 1;
+}
+
+}
+
+#endif
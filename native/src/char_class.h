@@ -0,0 +1,37 @@
+#ifndef CHAR_CLASS_H
+#define CHAR_CLASS_H
+
+#include "utf8.h"
+#include <cstdint>
+
+namespace speechly {
+
+// The characters JS matches with \s.
+inline bool IsSpaceCodepoint(uint32_t codepoint) {
+    if (codepoint < 0x80) {
+        return codepoint == ' ' || (codepoint >= '\t' && codepoint <= '\r');
+    }
+    return codepoint == 0xA0 || codepoint == 0x1680 || (codepoint >= 0x2000 && codepoint <= 0x200A) ||
+           codepoint == 0x2028 || codepoint == 0x2029 || codepoint == 0x202F || codepoint == 0x205F ||
+           codepoint == 0x3000 || codepoint == 0xFEFF;
+}
+
+// Letters and digits in any script. Punctuation, symbols and emoji outside
+// ASCII count as separators, like ASCII punctuation.
+inline bool IsWordCodepoint(uint32_t codepoint) {
+    if (codepoint < 0x80) {
+        return (codepoint >= 'a' && codepoint <= 'z') || (codepoint >= 'A' && codepoint <= 'Z') ||
+               (codepoint >= '0' && codepoint <= '9') || codepoint == '_';
+    }
+    if (codepoint < 0xC0 || codepoint == 0xD7 || codepoint == 0xF7) {
+        return false;
+    }
+    if ((codepoint >= 0x2000 && codepoint <= 0x2BFF) || (codepoint >= 0x3000 && codepoint <= 0x303F)) {
+        return false;
+    }
+    return codepoint < 0x1F000 && codepoint != kReplacementCodepoint;
+}
+
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef CLIPBOARD_OWNER_H
+#define CLIPBOARD_OWNER_H
+
+#ifdef __linux__
+
+#include <string>
+
+namespace speechly {
+
+enum class ClipboardSelection {
+    Clipboard,
+    Primary
+};
+
+// Owns the X11 CLIPBOARD and PRIMARY selections from a hidden window on the
+// input reactor connection and answers SelectionRequest events itself
+// (TARGETS, TIMESTAMP, UTF8_STRING, STRING, INCR for large payloads), so
+// copying never spawns xclip/xsel. Reading text we own is served from memory.
+//
+// Must not be called from the reactor thread: reads from other owners wait
+// for the reactor to deliver SelectionNotify.
+class ClipboardOwner {
+public:
+    static ClipboardOwner& instance();
+
+    bool setText(const std::string& text, ClipboardSelection selection = ClipboardSelection::Clipboard);
+    bool getText(std::string& text, ClipboardSelection selection = ClipboardSelection::Clipboard);
+    bool ownsSelection(ClipboardSelection selection) const;
+
+private:
+    ClipboardOwner();
+    ~ClipboardOwner();
+
+    class Impl;
+    Impl* impl_;
+};
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,521 @@
+#ifdef __linux__
+
+#include "clipboard_owner.h"
+#include "display_pool.h"
+#include "input_reactor.h"
+#include "utf8.h"
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace speechly {
+
+namespace {
+
+const int kReadTimeoutMs = 1000;
+// An INCR transfer whose requestor has not taken a chunk for this long is
+// dropped; the requestor has most likely gone away.
+const int kTransferTimeoutMs = 5000;
+
+struct OwnedSelection {
+    std::shared_ptr<const std::string> text;
+    Time time{CurrentTime};
+};
+
+struct OutgoingTransfer {
+    Window requestor;
+    Atom property;
+    Atom type;
+    std::shared_ptr<const std::string> data;
+    size_t offset;
+    std::chrono::steady_clock::time_point lastActivity;
+};
+
+struct IncomingRead {
+    bool active{false};
+    bool incremental{false};
+    bool done{false};
+    bool success{false};
+    Atom type{None};
+    std::string data;
+};
+
+// ICCCM STRING is ISO-8859-1, not UTF-8. Characters it cannot hold are
+// sent as '?'.
+std::string Utf8ToLatin1(const std::string& text) {
+    std::string latin1;
+    latin1.reserve(text.size());
+    for (size_t pos = 0; pos < text.size();) {
+        uint32_t codepoint = DecodeUtf8(text, pos);
+        latin1.push_back(codepoint <= 0xFF ? static_cast<char>(codepoint) : '?');
+    }
+    return latin1;
+}
+
+std::string Latin1ToUtf8(const std::string& text) {
+    std::string utf8;
+    utf8.reserve(text.size());
+    for (unsigned char byte : text) {
+        AppendUtf8(utf8, byte);
+    }
+    return utf8;
+}
+
+bool IsAscii(const std::string& text) {
+    return std::all_of(text.begin(), text.end(), [](char c) { return static_cast<unsigned char>(c) < 0x80; });
+}
+
+Bool IsPropertyEvent(Display*, XEvent* event, XPointer arg) {
+    const XPropertyEvent* wanted = reinterpret_cast<const XPropertyEvent*>(arg);
+    return event->type == PropertyNotify &&
+           event->xproperty.window == wanted->window &&
+           event->xproperty.atom == wanted->atom;
+}
+
+}
+
+class ClipboardOwner::Impl {
+public:
+    bool initialize(Display* display);
+    Atom selectionAtom(ClipboardSelection selection) const;
+    int selectionIndex(Atom atom) const;
+    Time fetchServerTime(Display* display);
+    bool requestConversion(ClipboardSelection selection, Atom target, std::string& text);
+
+    void onEvent(Display* display, XEvent& event);
+    void serveRequest(Display* display, const XSelectionRequestEvent& request);
+    void continueTransfer(Display* display, const XPropertyEvent& event);
+    void expireTransfers(Display* display);
+    void readProperty(Display* display);
+
+    bool initialized{false};
+    Window window{None};
+    size_t maxChunk{0};
+    int32_t transferTimer{-1};
+
+    Atom clipboardAtom{None};
+    Atom utf8Atom{None};
+    Atom textAtom{None};
+    Atom mimeTextAtom{None};
+    Atom plainTextAtom{None};
+    Atom targetsAtom{None};
+    Atom timestampAtom{None};
+    Atom incrAtom{None};
+    Atom propertyAtom{None};
+    Atom timeProbeAtom{None};
+
+    mutable std::mutex mutex;
+    std::condition_variable readChanged;
+    std::mutex readMutex;
+    OwnedSelection owned[2];
+    std::vector<OutgoingTransfer> transfers;
+    IncomingRead read;
+};
+
+bool ClipboardOwner::Impl::initialize(Display* display) {
+    if (initialized) {
+        return true;
+    }
+
+    InputReactor& reactor = InputReactor::instance();
+    if (!reactor.retain()) {
+        return false;
+    }
+
+    Window root = DefaultRootWindow(display);
+    window = XCreateSimpleWindow(display, root, -10, -10, 1, 1, 0, 0, 0);
+    XSelectInput(display, window, PropertyChangeMask);
+
+    clipboardAtom = XInternAtom(display, "CLIPBOARD", False);
+    utf8Atom = XInternAtom(display, "UTF8_STRING", False);
+    textAtom = XInternAtom(display, "TEXT", False);
+    mimeTextAtom = XInternAtom(display, "text/plain;charset=utf-8", False);
+    plainTextAtom = XInternAtom(display, "text/plain", False);
+    targetsAtom = XInternAtom(display, "TARGETS", False);
+    timestampAtom = XInternAtom(display, "TIMESTAMP", False);
+    incrAtom = XInternAtom(display, "INCR", False);
+    propertyAtom = XInternAtom(display, "SPEECHLY_SELECTION", False);
+    timeProbeAtom = XInternAtom(display, "SPEECHLY_TIMESTAMP", False);
+
+    long maxRequest = XExtendedMaxRequestSize(display);
+    if (maxRequest == 0) {
+        maxRequest = XMaxRequestSize(display);
+    }
+    maxChunk = std::min<size_t>(static_cast<size_t>(maxRequest) * 4 - 256, 256 * 1024);
+
+    int32_t handlerId = reactor.addXEventHandler(NoEventMask, [this](Display* dpy, XEvent& event) {
+        onEvent(dpy, event);
+    });
+    if (handlerId < 0) {
+        XDestroyWindow(display, window);
+        window = None;
+        reactor.release();
+        return false;
+    }
+
+    transferTimer = reactor.addTimer([this](Display* dpy) {
+        expireTransfers(dpy);
+    });
+
+    initialized = true;
+    return true;
+}
+
+Atom ClipboardOwner::Impl::selectionAtom(ClipboardSelection selection) const {
+    return selection == ClipboardSelection::Primary ? XA_PRIMARY : clipboardAtom;
+}
+
+int ClipboardOwner::Impl::selectionIndex(Atom atom) const {
+    if (atom == clipboardAtom) {
+        return 0;
+    }
+    return atom == XA_PRIMARY ? 1 : -1;
+}
+
+Time ClipboardOwner::Impl::fetchServerTime(Display* display) {
+    XChangeProperty(display, window, timeProbeAtom, XA_STRING, 8, PropModeAppend, nullptr, 0);
+
+    XPropertyEvent wanted{};
+    wanted.window = window;
+    wanted.atom = timeProbeAtom;
+
+    XEvent event;
+    XIfEvent(display, &event, IsPropertyEvent, reinterpret_cast<XPointer>(&wanted));
+    return event.xproperty.time;
+}
+
+void ClipboardOwner::Impl::onEvent(Display* display, XEvent& event) {
+    switch (event.type) {
+        case SelectionRequest:
+            if (event.xselectionrequest.owner == window) {
+                serveRequest(display, event.xselectionrequest);
+            }
+            break;
+
+        case SelectionClear:
+            if (event.xselectionclear.window == window) {
+                int index = selectionIndex(event.xselectionclear.selection);
+                if (index >= 0) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    owned[index].text.reset();
+                }
+            }
+            break;
+
+        case SelectionNotify:
+            if (event.xselection.requestor == window) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!read.active || read.done) {
+                    break;
+                }
+                if (event.xselection.property == None) {
+                    read.done = true;
+                    readChanged.notify_all();
+                } else {
+                    readProperty(display);
+                }
+            }
+            break;
+
+        case PropertyNotify:
+            if (event.xproperty.window == window) {
+                if (event.xproperty.atom == propertyAtom && event.xproperty.state == PropertyNewValue) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (read.active && read.incremental && !read.done) {
+                        readProperty(display);
+                    }
+                }
+            } else if (event.xproperty.state == PropertyDelete) {
+                continueTransfer(display, event.xproperty);
+            }
+            break;
+    }
+}
+
+void ClipboardOwner::Impl::readProperty(Display* display) {
+    Atom type;
+    int format;
+    unsigned long count;
+    unsigned long remaining;
+    unsigned char* data = nullptr;
+
+    int status = XGetWindowProperty(display, window, propertyAtom, 0, 0x1fffffff, True,
+                                    AnyPropertyType, &type, &format, &count, &remaining, &data);
+    if (status != Success) {
+        read.done = true;
+        readChanged.notify_all();
+        return;
+    }
+
+    if (type == incrAtom) {
+        read.incremental = true;
+    } else if (read.incremental && count == 0) {
+        read.success = true;
+        read.done = true;
+    } else {
+        if (data && format == 8) {
+            read.type = type;
+            read.data.append(reinterpret_cast<const char*>(data), count);
+        }
+        if (!read.incremental) {
+            read.success = format == 8;
+            read.done = true;
+        }
+    }
+
+    if (data) {
+        XFree(data);
+    }
+
+    if (read.done) {
+        readChanged.notify_all();
+    }
+}
+
+void ClipboardOwner::Impl::serveRequest(Display* display, const XSelectionRequestEvent& request) {
+    XEvent reply{};
+    reply.xselection.type = SelectionNotify;
+    reply.xselection.display = display;
+    reply.xselection.requestor = request.requestor;
+    reply.xselection.selection = request.selection;
+    reply.xselection.target = request.target;
+    reply.xselection.time = request.time;
+    reply.xselection.property = None;
+
+    Atom property = request.property == None ? request.target : request.property;
+
+    std::shared_ptr<const std::string> text;
+    Time ownedSince = CurrentTime;
+    int index = selectionIndex(request.selection);
+    if (index >= 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        text = owned[index].text;
+        ownedSince = owned[index].time;
+    }
+
+    bool tooEarly = request.time != CurrentTime && ownedSince != CurrentTime && request.time < ownedSince;
+
+    if (text && !tooEarly) {
+        // Plain text/plain has no charset, so it is only offered for ASCII.
+        bool plainAllowed = IsAscii(*text);
+
+        if (request.target == targetsAtom) {
+            std::vector<Atom> targets = {targetsAtom, timestampAtom, utf8Atom, mimeTextAtom, textAtom, XA_STRING};
+            if (plainAllowed) {
+                targets.push_back(plainTextAtom);
+            }
+            XChangeProperty(display, request.requestor, property, XA_ATOM, 32, PropModeReplace,
+                            reinterpret_cast<unsigned char*>(targets.data()), static_cast<int>(targets.size()));
+            reply.xselection.property = property;
+        } else if (request.target == timestampAtom) {
+            long time = static_cast<long>(ownedSince);
+            XChangeProperty(display, request.requestor, property, XA_INTEGER, 32, PropModeReplace,
+                            reinterpret_cast<unsigned char*>(&time), 1);
+            reply.xselection.property = property;
+        } else if (request.target == utf8Atom || request.target == mimeTextAtom ||
+                   request.target == textAtom || request.target == XA_STRING ||
+                   (request.target == plainTextAtom && plainAllowed)) {
+            Atom type = request.target == textAtom ? utf8Atom : request.target;
+            std::shared_ptr<const std::string> data = text;
+            if (type == XA_STRING) {
+                data = std::make_shared<const std::string>(Utf8ToLatin1(*text));
+            }
+
+            if (data->size() > maxChunk) {
+                InputReactor& reactor = InputReactor::instance();
+                reactor.selectPropertyChanges(display, request.requestor);
+
+                long size = static_cast<long>(data->size());
+                XChangeProperty(display, request.requestor, property, incrAtom, 32, PropModeReplace,
+                                reinterpret_cast<unsigned char*>(&size), 1);
+
+                bool first;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    first = transfers.empty();
+                    transfers.push_back({request.requestor, property, type, data, 0,
+                                         std::chrono::steady_clock::now()});
+                }
+                if (first && transferTimer >= 0) {
+                    reactor.armTimer(transferTimer, kTransferTimeoutMs);
+                }
+            } else {
+                XChangeProperty(display, request.requestor, property, type, 8, PropModeReplace,
+                                reinterpret_cast<const unsigned char*>(data->data()),
+                                static_cast<int>(data->size()));
+            }
+            reply.xselection.property = property;
+        }
+    }
+
+    XSendEvent(display, request.requestor, False, NoEventMask, &reply);
+    XFlush(display);
+}
+
+void ClipboardOwner::Impl::continueTransfer(Display* display, const XPropertyEvent& event) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (auto it = transfers.begin(); it != transfers.end(); ++it) {
+        if (it->requestor != event.window || it->property != event.atom) {
+            continue;
+        }
+
+        size_t length = std::min(maxChunk, it->data->size() - it->offset);
+        XChangeProperty(display, it->requestor, it->property, it->type, 8, PropModeReplace,
+                        reinterpret_cast<const unsigned char*>(it->data->data() + it->offset),
+                        static_cast<int>(length));
+        it->offset += length;
+        it->lastActivity = std::chrono::steady_clock::now();
+
+        if (length == 0) {
+            InputReactor::instance().releasePropertyChanges(display, it->requestor);
+            transfers.erase(it);
+        }
+
+        XFlush(display);
+        return;
+    }
+}
+
+// Runs from the reactor timer. Each pass drops the transfers that have
+// stalled and re-arms for the oldest one left.
+void ClipboardOwner::Impl::expireTransfers(Display* display) {
+    using namespace std::chrono;
+
+    const auto timeout = milliseconds(kTransferTimeoutMs);
+    const auto now = steady_clock::now();
+    steady_clock::time_point oldest = steady_clock::time_point::max();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = transfers.begin(); it != transfers.end();) {
+            if (now - it->lastActivity >= timeout) {
+                InputReactor::instance().releasePropertyChanges(display, it->requestor);
+                it = transfers.erase(it);
+            } else {
+                oldest = std::min(oldest, it->lastActivity);
+                ++it;
+            }
+        }
+    }
+    XFlush(display);
+
+    if (oldest != steady_clock::time_point::max()) {
+        auto delay = duration_cast<milliseconds>(oldest + timeout - now).count() + 1;
+        InputReactor::instance().armTimer(transferTimer, static_cast<uint32_t>(delay));
+    }
+}
+
+bool ClipboardOwner::Impl::requestConversion(ClipboardSelection selection, Atom target, std::string& text) {
+    {
+        DisplayLease dpy = AcquireDisplay(DisplayAffinity::Reactor);
+        if (!dpy) {
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            read = IncomingRead();
+            read.active = true;
+        }
+
+        XDeleteProperty(dpy.get(), window, propertyAtom);
+        XConvertSelection(dpy.get(), selectionAtom(selection), target, propertyAtom, window, CurrentTime);
+        XFlush(dpy.get());
+    }
+    InputReactor::instance().wake();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    readChanged.wait_for(lock, std::chrono::milliseconds(kReadTimeoutMs), [this] { return read.done; });
+
+    bool success = read.done && read.success;
+    if (success) {
+        text = read.type == XA_STRING ? Latin1ToUtf8(read.data) : std::move(read.data);
+    }
+    read = IncomingRead();
+    return success;
+}
+
+ClipboardOwner& ClipboardOwner::instance() {
+    static ClipboardOwner* owner = new ClipboardOwner();
+    return *owner;
+}
+
+ClipboardOwner::ClipboardOwner() : impl_(new Impl()) {}
+
+ClipboardOwner::~ClipboardOwner() {
+    delete impl_;
+}
+
+bool ClipboardOwner::setText(const std::string& text, ClipboardSelection selection) {
+    bool owns;
+    {
+        DisplayLease dpy = AcquireDisplay(DisplayAffinity::Reactor);
+        if (!dpy || !impl_->initialize(dpy.get())) {
+            return false;
+        }
+
+        Time time = impl_->fetchServerTime(dpy.get());
+        Atom atom = impl_->selectionAtom(selection);
+        int index = selection == ClipboardSelection::Primary ? 1 : 0;
+
+        {
+            std::lock_guard<std::mutex> lock(impl_->mutex);
+            impl_->owned[index].text = std::make_shared<const std::string>(text);
+            impl_->owned[index].time = time;
+        }
+
+        XSetSelectionOwner(dpy.get(), atom, impl_->window, time);
+        owns = XGetSelectionOwner(dpy.get(), atom) == impl_->window;
+
+        if (!owns) {
+            std::lock_guard<std::mutex> lock(impl_->mutex);
+            impl_->owned[index].text.reset();
+        }
+    }
+    InputReactor::instance().wake();
+
+    return owns;
+}
+
+bool ClipboardOwner::getText(std::string& text, ClipboardSelection selection) {
+    if (InputReactor::instance().isReactorThread()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> readLock(impl_->readMutex);
+
+    {
+        DisplayLease dpy = AcquireDisplay(DisplayAffinity::Reactor);
+        if (!dpy || !impl_->initialize(dpy.get())) {
+            return false;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        int index = selection == ClipboardSelection::Primary ? 1 : 0;
+        if (impl_->owned[index].text) {
+            text = *impl_->owned[index].text;
+            return true;
+        }
+    }
+
+    if (impl_->requestConversion(selection, impl_->utf8Atom, text)) {
+        return true;
+    }
+    return impl_->requestConversion(selection, XA_STRING, text);
+}
+
+bool ClipboardOwner::ownsSelection(ClipboardSelection selection) const {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    return impl_->owned[selection == ClipboardSelection::Primary ? 1 : 0].text != nullptr;
+}
+
+}
+
+#endif
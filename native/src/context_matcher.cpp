@@ -0,0 +1,184 @@
+#include "context_matcher.h"
+#include "aho_corasick.h"
+#include "snapshot_cell.h"
+#include <unordered_map>
+
+namespace speechly {
+
+namespace {
+
+#if defined(__APPLE__)
+const bool kMatchBundleIds = true;
+#else
+const bool kMatchBundleIds = false;
+#endif
+
+std::string ToLowerAscii(const std::string& value) {
+    std::string lower(value);
+    for (auto& c : lower) {
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+    }
+    return lower;
+}
+
+void KeepFirst(std::unordered_map<std::string, int32_t>& map, const std::string& key, int32_t index) {
+    if (!key.empty()) {
+        map.emplace(key, index);
+    }
+}
+
+int32_t Find(const std::unordered_map<std::string, int32_t>& map, const std::string& key) {
+    auto it = map.find(key);
+    return it == map.end() ? -1 : it->second;
+}
+
+struct CompiledContexts {
+    std::vector<ContextRule> rules;
+    std::unordered_map<std::string, int32_t> processes;
+    std::unordered_map<std::string, int32_t> bundles;
+    std::unordered_map<std::string, int32_t> browserProcesses;
+    std::unordered_map<std::string, int32_t> browserBundles;
+    AhoCorasick webPatterns;
+    std::vector<int32_t> webPatternRules;
+    bool loaded{false};
+};
+
+}
+
+class ContextMatcher::Impl {
+public:
+    SnapshotCell<CompiledContexts> compiled;
+};
+
+ContextMatcher& ContextMatcher::instance() {
+    static ContextMatcher* matcher = new ContextMatcher();
+    return *matcher;
+}
+
+ContextMatcher::ContextMatcher() : impl_(new Impl()) {}
+
+ContextMatcher::~ContextMatcher() {
+    delete impl_;
+}
+
+void ContextMatcher::compile(const std::vector<ContextRule>& rules) {
+    auto compiled = std::make_shared<CompiledContexts>();
+    compiled->rules = rules;
+
+    for (size_t i = 0; i < rules.size(); i++) {
+        const ContextRule& rule = rules[i];
+        int32_t index = static_cast<int32_t>(i);
+
+        switch (rule.kind) {
+            case ContextRuleKind::Process:
+                KeepFirst(compiled->processes, ToLowerAscii(rule.pattern), index);
+                break;
+            case ContextRuleKind::Bundle:
+                KeepFirst(compiled->bundles, rule.pattern, index);
+                break;
+            case ContextRuleKind::BrowserProcess:
+                KeepFirst(compiled->browserProcesses, ToLowerAscii(rule.pattern), index);
+                break;
+            case ContextRuleKind::BrowserBundle:
+                KeepFirst(compiled->browserBundles, rule.pattern, index);
+                break;
+            case ContextRuleKind::Web:
+                // A title matches a web app by its URL pattern or its name;
+                // entries without a URL pattern are ignored, as in the JS
+                // detector.
+                if (rule.pattern.empty()) {
+                    break;
+                }
+                compiled->webPatterns.addPattern(rule.pattern);
+                compiled->webPatternRules.push_back(index);
+                if (!rule.appName.empty()) {
+                    compiled->webPatterns.addPattern(rule.appName);
+                    compiled->webPatternRules.push_back(index);
+                }
+                break;
+        }
+    }
+
+    compiled->webPatterns.build();
+    compiled->loaded = true;
+
+    impl_->compiled.publish(std::move(compiled));
+}
+
+bool ContextMatcher::isLoaded() const {
+    return impl_->compiled.load()->loaded;
+}
+
+bool ContextMatcher::match(const ActiveWindowInfo& info, ContextMatch& result) const {
+    std::shared_ptr<const CompiledContexts> compiled = impl_->compiled.load();
+    if (!compiled->loaded) {
+        return false;
+    }
+
+    std::string processName = ToLowerAscii(info.processName);
+    bool useBundle = kMatchBundleIds && !info.bundleId.empty();
+
+    int32_t browserRule = useBundle
+        ? Find(compiled->browserBundles, info.bundleId)
+        : Find(compiled->browserProcesses, processName);
+
+    if (browserRule >= 0) {
+        int32_t webRule = -1;
+        compiled->webPatterns.scan(info.title, [&](int32_t patternId, size_t) {
+            int32_t rule = compiled->webPatternRules[patternId];
+            if (webRule < 0 || rule < webRule) {
+                webRule = rule;
+            }
+        });
+
+        if (webRule >= 0) {
+            result.ruleIndex = webRule;
+            result.contextType = compiled->rules[webRule].contextType;
+            result.appName = compiled->rules[webRule].appName;
+            result.confidence = ContextConfidence::Medium;
+        } else {
+            result.ruleIndex = browserRule;
+            result.contextType = "browser";
+            result.appName = compiled->rules[browserRule].appName;
+            result.confidence = ContextConfidence::Low;
+        }
+        return true;
+    }
+
+    int32_t appRule = -1;
+    if (useBundle) {
+        appRule = Find(compiled->bundles, info.bundleId);
+    }
+    int32_t processRule = processName.empty() ? -1 : Find(compiled->processes, processName);
+    if (processRule >= 0 && (appRule < 0 || processRule < appRule)) {
+        appRule = processRule;
+    }
+
+    if (appRule >= 0) {
+        result.ruleIndex = appRule;
+        result.contextType = compiled->rules[appRule].contextType;
+        result.appName = compiled->rules[appRule].appName;
+        result.confidence = ContextConfidence::High;
+    } else {
+        result.ruleIndex = -1;
+        result.contextType = "general";
+        result.appName = info.processName.empty() ? "Unknown" : info.processName;
+        result.confidence = ContextConfidence::Low;
+    }
+    return true;
+}
+
+const char* ContextConfidenceName(ContextConfidence confidence) {
+    switch (confidence) {
+        case ContextConfidence::High:
+            return "high";
+        case ContextConfidence::Medium:
+            return "medium";
+        default:
+            return "low";
+    }
+}
+
+}
@@ -0,0 +1,67 @@
+#ifndef CONTEXT_MATCHER_H
+#define CONTEXT_MATCHER_H
+
+#include "window_detector.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace speechly {
+
+enum class ContextRuleKind {
+    Process,
+    Bundle,
+    Web,
+    BrowserProcess,
+    BrowserBundle
+};
+
+// One entry of app-contexts.json, flattened. Rules are matched in the order
+// given, so the first matching rule of a kind wins, as in the JS detector.
+struct ContextRule {
+    ContextRuleKind kind;
+    std::string contextType;
+    std::string appName;
+    std::string pattern;
+};
+
+enum class ContextConfidence {
+    Low,
+    Medium,
+    High
+};
+
+struct ContextMatch {
+    int32_t ruleIndex;
+    std::string contextType;
+    std::string appName;
+    ContextConfidence confidence;
+
+    ContextMatch() : ruleIndex(-1), confidence(ContextConfidence::Low) {}
+};
+
+// Compiled form of the app/context rules: hash lookups for process names and
+// bundle ids, and one Aho-Corasick automaton over every web pattern and web
+// app name for browser titles. Recompiling publishes a new snapshot, so
+// matching from the watcher thread never waits on a reload.
+class ContextMatcher {
+public:
+    static ContextMatcher& instance();
+
+    void compile(const std::vector<ContextRule>& rules);
+    bool isLoaded() const;
+    bool match(const ActiveWindowInfo& info, ContextMatch& result) const;
+
+private:
+    ContextMatcher();
+    ~ContextMatcher();
+
+    class Impl;
+    Impl* impl_;
+};
+
+const char* ContextConfidenceName(ContextConfidence confidence);
+
+}
+
+#endif
@@ -0,0 +1,16 @@
+#include "display_pool.h"
+
+namespace speechly {
+
+#if defined(__linux__)
+#else
+
+DisplayPoolStats GetDisplayPoolStats() {
+    return DisplayPoolStats();
+}
+
+void InitializeDisplayThreads() {}
+
+#endif
+
+}
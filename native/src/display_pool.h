@@ -0,0 +1,63 @@
+#ifndef DISPLAY_POOL_H
+#define DISPLAY_POOL_H
+
+#include <cstdint>
+#include <mutex>
+
+#ifdef __linux__
+typedef struct _XDisplay Display;
+#endif
+
+namespace speechly {
+
+// Each affinity group owns one long-lived X connection. Groups map to the
+// threads that use them so the input reactor never contends with injection.
+enum class DisplayAffinity {
+    Shared,
+    Injector,
+    Reactor,
+    Count
+};
+
+struct DisplayPoolStats {
+    uint64_t opened;
+    uint64_t acquired;
+    uint64_t avoidedOpens;
+    uint32_t live;
+
+    DisplayPoolStats() : opened(0), acquired(0), avoidedOpens(0), live(0) {}
+};
+
+DisplayPoolStats GetDisplayPoolStats();
+
+// Puts Xlib into thread-safe mode, which must happen before any other Xlib
+// call in the process. Called once from addon init; a no-op off Linux.
+void InitializeDisplayThreads();
+
+#ifdef __linux__
+
+// Holds the group's connection lock for its lifetime. Xlib connections are
+// not thread safe, so keep leases short on threads that share a group.
+class DisplayLease {
+public:
+    DisplayLease(Display* display, std::unique_lock<std::recursive_mutex>&& lock);
+    DisplayLease(DisplayLease&& other) noexcept;
+    DisplayLease(const DisplayLease&) = delete;
+    DisplayLease& operator=(const DisplayLease&) = delete;
+    ~DisplayLease();
+
+    Display* get() const { return display_; }
+    explicit operator bool() const { return display_ != nullptr; }
+
+private:
+    Display* display_;
+    std::unique_lock<std::recursive_mutex> lock_;
+};
+
+DisplayLease AcquireDisplay(DisplayAffinity affinity = DisplayAffinity::Shared);
+
+#endif
+
+}
+
+#endif
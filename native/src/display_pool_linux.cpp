@@ -0,0 +1,112 @@
+#ifdef __linux__
+
+#include "display_pool.h"
+#include <X11/Xlib.h>
+#include <atomic>
+#include <utility>
+
+namespace speechly {
+
+namespace {
+
+struct PooledDisplay {
+    // Atomic because the error handler reads it from whichever thread hit
+    // the error, without the slot lock.
+    std::atomic<Display*> display{nullptr};
+    std::recursive_mutex mutex;
+};
+
+struct DisplayPool {
+    PooledDisplay slots[static_cast<int>(DisplayAffinity::Count)];
+    std::atomic<uint64_t> opened{0};
+    std::atomic<uint64_t> acquired{0};
+    std::atomic<uint32_t> live{0};
+    std::atomic<XErrorHandler> previousHandler{nullptr};
+    std::once_flag errorHandlerInit;
+};
+
+DisplayPool& Pool() {
+    // Leaked on purpose: watcher threads may still hold leases while static
+    // destructors run at process exit.
+    static DisplayPool* pool = new DisplayPool();
+    return *pool;
+}
+
+bool IsPooledDisplay(Display* display) {
+    for (const PooledDisplay& slot : Pool().slots) {
+        if (slot.display.load() == display) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The Xlib error handler is process-wide. The default one exits the process,
+// and pooled connections outlive the windows they touch (focused apps,
+// selection requestors), so BadWindow and friends are ignored on them.
+// Errors on every other connection, such as Chromium's or GDK's, go to the
+// handler that was installed before ours.
+int HandleXError(Display* display, XErrorEvent* event) {
+    if (display && IsPooledDisplay(display)) {
+        return 0;
+    }
+
+    XErrorHandler previous = Pool().previousHandler.load();
+    return previous ? previous(display, event) : 0;
+}
+
+}
+
+DisplayLease::DisplayLease(Display* display, std::unique_lock<std::recursive_mutex>&& lock)
+    : display_(display), lock_(std::move(lock)) {}
+
+DisplayLease::DisplayLease(DisplayLease&& other) noexcept
+    : display_(other.display_), lock_(std::move(other.lock_)) {
+    other.display_ = nullptr;
+}
+
+DisplayLease::~DisplayLease() {}
+
+DisplayLease AcquireDisplay(DisplayAffinity affinity) {
+    DisplayPool& pool = Pool();
+    PooledDisplay& slot = pool.slots[static_cast<int>(affinity)];
+
+    std::unique_lock<std::recursive_mutex> lock(slot.mutex);
+
+    if (!slot.display) {
+        std::call_once(pool.errorHandlerInit, []() {
+            Pool().previousHandler = XSetErrorHandler(HandleXError);
+        });
+
+        slot.display = XOpenDisplay(nullptr);
+        if (!slot.display.load()) {
+            return DisplayLease(nullptr, std::unique_lock<std::recursive_mutex>());
+        }
+
+        pool.opened++;
+        pool.live++;
+    }
+
+    pool.acquired++;
+    return DisplayLease(slot.display.load(), std::move(lock));
+}
+
+void InitializeDisplayThreads() {
+    static const Status initialized = XInitThreads();
+    (void)initialized;
+}
+
+DisplayPoolStats GetDisplayPoolStats() {
+    DisplayPool& pool = Pool();
+
+    DisplayPoolStats stats;
+    stats.opened = pool.opened.load();
+    stats.acquired = pool.acquired.load();
+    stats.avoidedOpens = stats.acquired > stats.opened ? stats.acquired - stats.opened : 0;
+    stats.live = pool.live.load();
+    return stats;
+}
+
+}
+
+#endif
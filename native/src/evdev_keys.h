@@ -0,0 +1,41 @@
+#ifndef EVDEV_KEYS_H
+#define EVDEV_KEYS_H
+
+#ifdef __linux__
+
+#include <cstdint>
+
+namespace speechly {
+
+// Key tables for the evdev backend. Kernel key codes name physical keys, so
+// these assume a US layout for characters, as XTest does for keycodes it
+// cannot look up; modifiers and named keys are layout independent.
+
+// Accelerator key code (HotkeyManager::parseAccelerator) -> KEY_*, 0 if none.
+uint16_t EvdevKeyForAccelerator(uint32_t keyCode);
+
+// KEY_* -> gesture key (gesture_engine.h), kGestureKeyNone if none.
+uint8_t GestureKeyForEvdevKey(uint16_t code);
+
+// Bit in a Modifier mask for a modifier KEY_*, 0 for other keys.
+uint32_t ModifierForEvdevKey(uint16_t code);
+
+// KEY_* and shift state producing an ASCII character, false if none.
+bool EvdevKeyForCharacter(uint32_t codepoint, uint16_t& code, bool& shift);
+
+// Whether the keyboard layout is known to be plain US, the only layout the
+// character table is right for. Decided once, from SPEECHLY_KEYBOARD_LAYOUT,
+// then XKB_DEFAULT_LAYOUT, then XKBLAYOUT in /etc/default/keyboard or
+// /etc/vconsole.conf; a layout that cannot be found is not assumed US.
+bool EvdevLayoutIsUs();
+
+// The KEY_* that sends "v" for Ctrl+V on the same configured layout, for
+// the known layouts that place it. False for a layout that cannot be found
+// or is not known, where any guess could send some other shortcut.
+bool EvdevPasteKey(uint16_t& code);
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,267 @@
+#ifdef __linux__
+
+#include "evdev_keys.h"
+#include "gesture_engine.h"
+#include "hotkey_manager.h"
+#include <linux/input-event-codes.h>
+#include <array>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+namespace speechly {
+
+namespace {
+
+struct CharacterKey {
+    uint16_t code;
+    bool shift;
+};
+
+const uint16_t kLetterKeys[26] = {
+    KEY_A, KEY_B, KEY_C, KEY_D, KEY_E, KEY_F, KEY_G, KEY_H, KEY_I, KEY_J, KEY_K, KEY_L, KEY_M,
+    KEY_N, KEY_O, KEY_P, KEY_Q, KEY_R, KEY_S, KEY_T, KEY_U, KEY_V, KEY_W, KEY_X, KEY_Y, KEY_Z
+};
+
+const uint16_t kDigitKeys[10] = {
+    KEY_0, KEY_1, KEY_2, KEY_3, KEY_4, KEY_5, KEY_6, KEY_7, KEY_8, KEY_9
+};
+
+const uint16_t kFunctionKeys[24] = {
+    KEY_F1, KEY_F2, KEY_F3, KEY_F4, KEY_F5, KEY_F6, KEY_F7, KEY_F8, KEY_F9, KEY_F10, KEY_F11, KEY_F12,
+    KEY_F13, KEY_F14, KEY_F15, KEY_F16, KEY_F17, KEY_F18, KEY_F19, KEY_F20, KEY_F21, KEY_F22, KEY_F23, KEY_F24
+};
+
+std::array<CharacterKey, 128> BuildCharacterTable() {
+    std::array<CharacterKey, 128> table{};
+
+    for (int i = 0; i < 26; i++) {
+        table['a' + i] = {kLetterKeys[i], false};
+        table['A' + i] = {kLetterKeys[i], true};
+    }
+    for (int i = 0; i < 10; i++) {
+        table['0' + i] = {kDigitKeys[i], false};
+    }
+
+    const char shiftedDigits[] = ")!@#$%^&*(";
+    for (int i = 0; i < 10; i++) {
+        table[static_cast<unsigned char>(shiftedDigits[i])] = {kDigitKeys[i], true};
+    }
+
+    const struct {
+        char plain;
+        char shifted;
+        uint16_t code;
+    } punctuation[] = {
+        {'-', '_', KEY_MINUS}, {'=', '+', KEY_EQUAL}, {'[', '{', KEY_LEFTBRACE},
+        {']', '}', KEY_RIGHTBRACE}, {'\\', '|', KEY_BACKSLASH}, {';', ':', KEY_SEMICOLON},
+        {'\'', '"', KEY_APOSTROPHE}, {'`', '~', KEY_GRAVE}, {',', '<', KEY_COMMA},
+        {'.', '>', KEY_DOT}, {'/', '?', KEY_SLASH}
+    };
+    for (const auto& entry : punctuation) {
+        table[static_cast<unsigned char>(entry.plain)] = {entry.code, false};
+        table[static_cast<unsigned char>(entry.shifted)] = {entry.code, true};
+    }
+
+    table[' '] = {KEY_SPACE, false};
+    table['\t'] = {KEY_TAB, false};
+    table['\n'] = {KEY_ENTER, false};
+    return table;
+}
+
+// The value of KEY=value or KEY="value" in a shell-style config file.
+std::string ReadConfigValue(const char* path, const std::string& key) {
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.compare(0, key.size() + 1, key + "=") != 0) {
+            continue;
+        }
+        std::string value = line.substr(key.size() + 1);
+        if (value.size() >= 2 && (value.front() == '"' || value.front() == '\'') && value.back() == value.front()) {
+            value = value.substr(1, value.size() - 2);
+        }
+        return value;
+    }
+    return "";
+}
+
+// "us" alone, without variants such as dvorak or a second group to switch to.
+bool IsPlainUsLayout(const std::string& layout, const std::string& variant) {
+    return layout == "us" && (variant.empty() || variant == "basic");
+}
+
+struct LayoutSetting {
+    std::string layout;
+    std::string variant;
+};
+
+LayoutSetting DetectLayout() {
+    if (const char* layout = std::getenv("SPEECHLY_KEYBOARD_LAYOUT")) {
+        return {layout, ""};
+    }
+    if (const char* layout = std::getenv("XKB_DEFAULT_LAYOUT")) {
+        const char* variant = std::getenv("XKB_DEFAULT_VARIANT");
+        return {layout, variant ? variant : ""};
+    }
+
+    for (const char* path : {"/etc/default/keyboard", "/etc/vconsole.conf"}) {
+        std::string layout = ReadConfigValue(path, "XKBLAYOUT");
+        if (!layout.empty()) {
+            return {layout, ReadConfigValue(path, "XKBVARIANT")};
+        }
+    }
+    return {};
+}
+
+const LayoutSetting& ConfiguredLayout() {
+    static const LayoutSetting setting = DetectLayout();
+    return setting;
+}
+
+std::string FirstGroup(const std::string& list) {
+    return list.substr(0, list.find(','));
+}
+
+// Where the key that types "v" sits on the first group of a layout, 0 if
+// unknown. The QWERTY, QWERTZ and AZERTY families leave it in place; the
+// alternative Latin layouts listed here move it.
+uint16_t PasteKeyForLayout(const std::string& layout, const std::string& variant) {
+    static const struct {
+        const char* layout;
+        const char* variant;
+        uint16_t code;
+    } kMoved[] = {
+        {"us", "dvorak", KEY_DOT}, {"us", "dvorak-intl", KEY_DOT}, {"us", "dvp", KEY_DOT},
+        {"gb", "dvorak", KEY_DOT}, {"us", "colemak", KEY_V}, {"us", "workman", KEY_B},
+        {"fr", "bepo", KEY_U}, {"de", "neo", KEY_W}
+    };
+    static const char* const kInPlace[] = {
+        "us", "gb", "ie", "de", "at", "ch", "fr", "be", "ca", "es", "latam", "pt", "br", "it",
+        "nl", "dk", "no", "se", "fi", "is", "ee", "lt", "lv", "pl", "cz", "sk", "hu", "si",
+        "hr", "ro", "tr"
+    };
+
+    for (const auto& entry : kMoved) {
+        if (layout == entry.layout && variant == entry.variant) {
+            return entry.code;
+        }
+    }
+    if (!variant.empty() && variant != "basic" && variant != "nodeadkeys" && variant != "intl" &&
+        variant != "altgr-intl" && variant != "mac") {
+        return 0;
+    }
+    for (const char* name : kInPlace) {
+        if (layout == name) {
+            return KEY_V;
+        }
+    }
+    return 0;
+}
+
+std::array<uint8_t, 256> BuildGestureTable() {
+    std::array<uint8_t, 256> table{};
+
+    for (uint32_t keyCode = 1; keyCode < 256; keyCode++) {
+        uint16_t code = EvdevKeyForAccelerator(keyCode);
+        if (code != 0 && code < table.size()) {
+            table[code] = static_cast<uint8_t>(keyCode);
+        }
+    }
+
+    table[KEY_LEFTCTRL] = kGestureKeyCtrl;
+    table[KEY_RIGHTCTRL] = kGestureKeyCtrl;
+    table[KEY_LEFTALT] = kGestureKeyAlt;
+    table[KEY_RIGHTALT] = kGestureKeyAlt;
+    table[KEY_LEFTSHIFT] = kGestureKeyShift;
+    table[KEY_RIGHTSHIFT] = kGestureKeyShift;
+    table[KEY_LEFTMETA] = kGestureKeyMeta;
+    table[KEY_RIGHTMETA] = kGestureKeyMeta;
+    table[KEY_CAPSLOCK] = kGestureKeyCapsLock;
+    return table;
+}
+
+}
+
+uint16_t EvdevKeyForAccelerator(uint32_t keyCode) {
+    if (keyCode >= 'A' && keyCode <= 'Z') {
+        return kLetterKeys[keyCode - 'A'];
+    }
+    if (keyCode >= '0' && keyCode <= '9') {
+        return kDigitKeys[keyCode - '0'];
+    }
+    if (keyCode >= 0x70 && keyCode <= 0x87) {
+        return kFunctionKeys[keyCode - 0x70];
+    }
+
+    switch (keyCode) {
+        case 0x20: return KEY_SPACE;
+        case 0x0D: return KEY_ENTER;
+        case 0x09: return KEY_TAB;
+        case 0x08: return KEY_BACKSPACE;
+        case 0x2E: return KEY_DELETE;
+        case 0x1B: return KEY_ESC;
+        case 0x26: return KEY_UP;
+        case 0x28: return KEY_DOWN;
+        case 0x25: return KEY_LEFT;
+        case 0x27: return KEY_RIGHT;
+        case 0x24: return KEY_HOME;
+        case 0x23: return KEY_END;
+        case 0x21: return KEY_PAGEUP;
+        case 0x22: return KEY_PAGEDOWN;
+        case 0x2D: return KEY_INSERT;
+        default: return 0;
+    }
+}
+
+uint8_t GestureKeyForEvdevKey(uint16_t code) {
+    static const std::array<uint8_t, 256> table = BuildGestureTable();
+    return code < table.size() ? table[code] : kGestureKeyNone;
+}
+
+uint32_t ModifierForEvdevKey(uint16_t code) {
+    switch (code) {
+        case KEY_LEFTCTRL:
+        case KEY_RIGHTCTRL:
+            return static_cast<uint32_t>(Modifier::Ctrl);
+        case KEY_LEFTALT:
+        case KEY_RIGHTALT:
+            return static_cast<uint32_t>(Modifier::Alt);
+        case KEY_LEFTSHIFT:
+        case KEY_RIGHTSHIFT:
+            return static_cast<uint32_t>(Modifier::Shift);
+        case KEY_LEFTMETA:
+        case KEY_RIGHTMETA:
+            return static_cast<uint32_t>(Modifier::Meta);
+        default:
+            return 0;
+    }
+}
+
+bool EvdevKeyForCharacter(uint32_t codepoint, uint16_t& code, bool& shift) {
+    static const std::array<CharacterKey, 128> table = BuildCharacterTable();
+    if (codepoint >= table.size() || table[codepoint].code == 0) {
+        return false;
+    }
+
+    code = table[codepoint].code;
+    shift = table[codepoint].shift;
+    return true;
+}
+
+bool EvdevLayoutIsUs() {
+    const LayoutSetting& setting = ConfiguredLayout();
+    return IsPlainUsLayout(setting.layout, setting.variant);
+}
+
+bool EvdevPasteKey(uint16_t& code) {
+    // Shortcuts follow the first group, so "us,ru" pastes as "us" does.
+    const LayoutSetting& setting = ConfiguredLayout();
+    static const uint16_t pasteKey = PasteKeyForLayout(FirstGroup(setting.layout), FirstGroup(setting.variant));
+    code = pasteKey;
+    return code != 0;
+}
+
+}
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef EVDEV_REACTOR_H
+#define EVDEV_REACTOR_H
+
+#ifdef __linux__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace speechly {
+
+// The evdev counterpart of InputReactor: one thread and one epoll set over
+// every keyboard under /dev/input, for sessions where X cannot see global
+// input. Devices are switched to CLOCK_MONOTONIC, so kernel event times are
+// steady_clock times as they are. An inotify watch on /dev/input adds
+// keyboards that appear later, uinput devices included. UinputKeyboard's own
+// device is skipped, since injected keys and paste chords would otherwise
+// trigger hotkeys and hold listeners; SPEECHLY_CAPTURE_VIRTUAL_KEYBOARD=1
+// captures it too, which is how native/scripts/evdev-loopback.js tests
+// capture end to end.
+//
+// Handlers run on the reactor thread with the KEY_* code and the evdev value
+// (0 release, 1 press, 2 auto-repeat). Once removeKeyHandler() returns the
+// handler is not running and never runs again, unless it was called from a
+// handler, where waiting would deadlock. When a device's buffer overflows
+// (SYN_DROPPED) its key state is read back and the missed presses and
+// releases are delivered, so no key stays down.
+class EvdevReactor {
+public:
+    using KeyHandler = std::function<void(uint16_t code, int32_t value, std::chrono::steady_clock::time_point at)>;
+
+    static EvdevReactor& instance();
+
+    bool retain();
+    void release();
+    bool isRunning() const;
+    size_t deviceCount() const;
+
+    int32_t addKeyHandler(KeyHandler handler);
+    void removeKeyHandler(int32_t id);
+
+private:
+    EvdevReactor();
+    ~EvdevReactor();
+
+    struct HandlerEntry {
+        int32_t id;
+        KeyHandler handler;
+    };
+    using HandlerList = std::vector<HandlerEntry>;
+
+    struct Device {
+        int fd;
+        std::string path;
+    };
+
+    struct KeyState {
+        std::vector<unsigned long> down;
+        bool dropped;
+    };
+
+    void run(std::shared_ptr<std::atomic<bool>> active);
+    void scanDevices();
+    void openDevice(const std::string& path);
+    void closeDevice(int fd);
+    void readDevice(int fd);
+    void resyncKeys(int fd, KeyState& state, const HandlerList& handlers, std::chrono::steady_clock::time_point at);
+    void readInotify();
+    void closeAllDevices();
+    void wake();
+
+    mutable std::mutex mutex_;
+    // Held while handlers run, so removal can wait out a dispatch.
+    std::mutex dispatchMutex_;
+    std::shared_ptr<const HandlerList> handlers_;
+    // Reactor thread only.
+    std::unordered_map<int, KeyState> keyStates_;
+    std::vector<Device> devices_;
+    int32_t nextHandlerId_;
+    int refCount_;
+    std::atomic<bool> running_;
+    std::atomic<std::thread::id> reactorThread_;
+    std::shared_ptr<std::atomic<bool>> active_;
+    std::thread thread_;
+    int epollFd_;
+    int wakeFd_;
+    int inotifyFd_;
+};
+
+}
+
+#endif
+
+#endif
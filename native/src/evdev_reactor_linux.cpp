@@ -0,0 +1,441 @@
+#ifdef __linux__
+
+#include "evdev_reactor.h"
+#include "uinput_keyboard.h"
+#include <linux/input.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+namespace speechly {
+
+static const char* kInputDirectory = "/dev/input";
+
+static bool TestBit(const unsigned long* bits, unsigned int bit) {
+    const unsigned int width = sizeof(unsigned long) * CHAR_BIT;
+    return (bits[bit / width] >> (bit % width)) & 1UL;
+}
+
+// Anything reporting key events has EV_KEY, mice and power buttons
+// included; a keyboard is something with letters and a Ctrl key.
+static bool IsKeyboard(int fd) {
+    const unsigned int width = sizeof(unsigned long) * CHAR_BIT;
+    unsigned long eventBits[EV_MAX / width + 1] = {0};
+    unsigned long keyBits[KEY_MAX / width + 1] = {0};
+
+    if (ioctl(fd, EVIOCGBIT(0, sizeof(eventBits)), eventBits) < 0 || !TestBit(eventBits, EV_KEY)) {
+        return false;
+    }
+    if (ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keyBits)), keyBits) < 0) {
+        return false;
+    }
+    return TestBit(keyBits, KEY_A) && TestBit(keyBits, KEY_LEFTCTRL);
+}
+
+static bool IsSkippedVirtualKeyboard(int fd) {
+    static const bool capture = [] {
+        const char* flag = std::getenv("SPEECHLY_CAPTURE_VIRTUAL_KEYBOARD");
+        return flag && std::strcmp(flag, "1") == 0;
+    }();
+
+    input_id id;
+    std::memset(&id, 0, sizeof(id));
+    return !capture && ioctl(fd, EVIOCGID, &id) == 0 &&
+           id.vendor == kUinputVendorId && id.product == kUinputProductId;
+}
+
+static const size_t kKeyWords = KEY_MAX / (sizeof(unsigned long) * CHAR_BIT) + 1;
+
+static void SetBit(std::vector<unsigned long>& bits, unsigned int bit, bool set) {
+    const unsigned int width = sizeof(unsigned long) * CHAR_BIT;
+    if (set) {
+        bits[bit / width] |= 1UL << (bit % width);
+    } else {
+        bits[bit / width] &= ~(1UL << (bit % width));
+    }
+}
+
+static bool IsEventNode(const char* name) {
+    return std::strncmp(name, "event", 5) == 0;
+}
+
+EvdevReactor& EvdevReactor::instance() {
+    static EvdevReactor* reactor = new EvdevReactor();
+    return *reactor;
+}
+
+EvdevReactor::EvdevReactor()
+    : handlers_(std::make_shared<HandlerList>()),
+      nextHandlerId_(1),
+      refCount_(0),
+      running_(false),
+      reactorThread_(std::thread::id()),
+      epollFd_(epoll_create1(EPOLL_CLOEXEC)),
+      wakeFd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      inotifyFd_(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {
+    if (epollFd_ < 0) {
+        return;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    if (wakeFd_ >= 0) {
+        ev.data.fd = wakeFd_;
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &ev);
+    }
+    if (inotifyFd_ >= 0) {
+        ev.data.fd = inotifyFd_;
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, inotifyFd_, &ev);
+    }
+}
+
+EvdevReactor::~EvdevReactor() {
+    closeAllDevices();
+    if (inotifyFd_ >= 0) {
+        close(inotifyFd_);
+    }
+    if (wakeFd_ >= 0) {
+        close(wakeFd_);
+    }
+    if (epollFd_ >= 0) {
+        close(epollFd_);
+    }
+}
+
+bool EvdevReactor::retain() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (epollFd_ < 0 || wakeFd_ < 0 || inotifyFd_ < 0 || access(kInputDirectory, R_OK | X_OK) != 0) {
+        return false;
+    }
+
+    refCount_++;
+    if (running_) {
+        return true;
+    }
+
+    // Nodes appear with root-only permissions and udev fixes them up
+    // afterwards, so attribute changes count as arrivals too.
+    inotify_add_watch(inotifyFd_, kInputDirectory, IN_CREATE | IN_ATTRIB);
+
+    if (thread_.joinable()) {
+        thread_.detach();
+    }
+
+    auto active = std::make_shared<std::atomic<bool>>(true);
+    active_ = active;
+    running_ = true;
+    thread_ = std::thread(&EvdevReactor::run, this, active);
+
+    return true;
+}
+
+void EvdevReactor::release() {
+    std::thread finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (refCount_ == 0 || --refCount_ > 0) {
+            return;
+        }
+
+        if (std::this_thread::get_id() == thread_.get_id()) {
+            return;
+        }
+
+        running_ = false;
+        if (active_) {
+            *active_ = false;
+        }
+        finished = std::move(thread_);
+    }
+
+    wake();
+
+    if (finished.joinable()) {
+        finished.join();
+    }
+}
+
+bool EvdevReactor::isRunning() const {
+    return running_;
+}
+
+size_t EvdevReactor::deviceCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return devices_.size();
+}
+
+int32_t EvdevReactor::addKeyHandler(KeyHandler handler) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    int32_t id = nextHandlerId_++;
+    auto handlers = std::make_shared<HandlerList>(*handlers_);
+    handlers->push_back({id, std::move(handler)});
+    handlers_ = std::move(handlers);
+    return id;
+}
+
+void EvdevReactor::removeKeyHandler(int32_t id) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto handlers = std::make_shared<HandlerList>();
+        for (const auto& entry : *handlers_) {
+            if (entry.id != id) {
+                handlers->push_back(entry);
+            }
+        }
+        handlers_ = std::move(handlers);
+    }
+
+    // A dispatch that started before the swap may still hold the old list;
+    // the next one reads the new list only after taking dispatchMutex_.
+    if (std::this_thread::get_id() != reactorThread_.load()) {
+        std::lock_guard<std::mutex> dispatch(dispatchMutex_);
+    }
+}
+
+void EvdevReactor::wake() {
+    if (wakeFd_ < 0) {
+        return;
+    }
+
+    uint64_t one = 1;
+    ssize_t written = write(wakeFd_, &one, sizeof(one));
+    (void)written;
+}
+
+void EvdevReactor::scanDevices() {
+    DIR* dir = opendir(kInputDirectory);
+    if (!dir) {
+        return;
+    }
+
+    while (dirent* entry = readdir(dir)) {
+        if (IsEventNode(entry->d_name)) {
+            openDevice(std::string(kInputDirectory) + "/" + entry->d_name);
+        }
+    }
+
+    closedir(dir);
+}
+
+void EvdevReactor::openDevice(const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& device : devices_) {
+            if (device.path == path) {
+                return;
+            }
+        }
+    }
+
+    int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+
+    int clock = CLOCK_MONOTONIC;
+    if (!IsKeyboard(fd) || IsSkippedVirtualKeyboard(fd) || ioctl(fd, EVIOCSCLOCKID, &clock) < 0) {
+        close(fd);
+        return;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        close(fd);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    devices_.push_back({fd, path});
+}
+
+void EvdevReactor::closeDevice(int fd) {
+    epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    keyStates_.erase(fd);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = devices_.begin(); it != devices_.end(); ++it) {
+        if (it->fd == fd) {
+            devices_.erase(it);
+            return;
+        }
+    }
+}
+
+void EvdevReactor::closeAllDevices() {
+    std::vector<Device> devices;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        devices.swap(devices_);
+    }
+
+    for (const auto& device : devices) {
+        epoll_ctl(epollFd_, EPOLL_CTL_DEL, device.fd, nullptr);
+        close(device.fd);
+    }
+    keyStates_.clear();
+}
+
+void EvdevReactor::readDevice(int fd) {
+    std::lock_guard<std::mutex> dispatch(dispatchMutex_);
+
+    std::shared_ptr<const HandlerList> handlers;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        handlers = handlers_;
+    }
+
+    KeyState& state = keyStates_[fd];
+    if (state.down.empty()) {
+        state.down.assign(kKeyWords, 0);
+        state.dropped = false;
+    }
+
+    input_event events[64];
+    for (;;) {
+        ssize_t bytes = read(fd, events, sizeof(events));
+        if (bytes < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN) {
+                closeDevice(fd);
+            }
+            return;
+        }
+        if (bytes == 0) {
+            closeDevice(fd);
+            return;
+        }
+
+        size_t count = static_cast<size_t>(bytes) / sizeof(input_event);
+        for (size_t i = 0; i < count; i++) {
+            const input_event& event = events[i];
+            auto at = std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::seconds(event.input_event_sec) + std::chrono::microseconds(event.input_event_usec)));
+
+            // After an overflow the kernel's advice is to skip everything up
+            // to the next SYN_REPORT and then query the device.
+            if (event.type == EV_SYN && event.code == SYN_DROPPED) {
+                state.dropped = true;
+                continue;
+            }
+            if (state.dropped) {
+                if (event.type == EV_SYN && event.code == SYN_REPORT) {
+                    state.dropped = false;
+                    resyncKeys(fd, state, *handlers, at);
+                }
+                continue;
+            }
+
+            if (event.type != EV_KEY || event.code > KEY_MAX) {
+                continue;
+            }
+
+            SetBit(state.down, event.code, event.value != 0);
+            for (const auto& entry : *handlers) {
+                entry.handler(event.code, event.value, at);
+            }
+        }
+    }
+}
+
+void EvdevReactor::resyncKeys(int fd, KeyState& state, const HandlerList& handlers,
+                              std::chrono::steady_clock::time_point at) {
+    std::vector<unsigned long> down(kKeyWords, 0);
+    if (ioctl(fd, EVIOCGKEY(down.size() * sizeof(unsigned long)), down.data()) < 0) {
+        return;
+    }
+
+    for (unsigned int code = 0; code <= KEY_MAX; code++) {
+        bool wasDown = TestBit(state.down.data(), code);
+        bool isDown = TestBit(down.data(), code);
+        if (wasDown == isDown) {
+            continue;
+        }
+        for (const auto& entry : handlers) {
+            entry.handler(static_cast<uint16_t>(code), isDown ? 1 : 0, at);
+        }
+    }
+
+    state.down.swap(down);
+}
+
+void EvdevReactor::readInotify() {
+    alignas(inotify_event) char buffer[4096];
+
+    for (;;) {
+        ssize_t bytes = read(inotifyFd_, buffer, sizeof(buffer));
+        if (bytes <= 0) {
+            return;
+        }
+
+        for (char* cursor = buffer; cursor < buffer + bytes;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(cursor);
+            if (event->len > 0 && IsEventNode(event->name)) {
+                openDevice(std::string(kInputDirectory) + "/" + event->name);
+            }
+            cursor += sizeof(inotify_event) + event->len;
+        }
+    }
+}
+
+void EvdevReactor::run(std::shared_ptr<std::atomic<bool>> active) {
+    reactorThread_ = std::this_thread::get_id();
+    scanDevices();
+
+    epoll_event events[16];
+
+    while (*active) {
+        int count = epoll_wait(epollFd_, events, 16, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        for (int i = 0; i < count && *active; i++) {
+            int fd = events[i].data.fd;
+            if (fd == wakeFd_) {
+                uint64_t value;
+                while (read(wakeFd_, &value, sizeof(value)) == sizeof(value)) {}
+            } else if (fd == inotifyFd_) {
+                readInotify();
+            } else if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                closeDevice(fd);
+            } else {
+                readDevice(fd);
+            }
+        }
+    }
+
+    closeAllDevices();
+
+    std::thread::id self = std::this_thread::get_id();
+    reactorThread_.compare_exchange_strong(self, std::thread::id());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (active_ == active) {
+        running_ = false;
+    }
+}
+
+}
+
+#endif
@@ -0,0 +1,367 @@
+#include "gesture_engine.h"
+#include "latency_metrics.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace speechly {
+
+namespace {
+
+const size_t kMaxGestureSteps = 8;
+const size_t kMaxChordKeys = 4;
+const int kMaxWindowMs = 5000;
+
+std::vector<std::string> TokenizeSpec(const std::string& spec) {
+    std::vector<std::string> tokens;
+    std::string current;
+
+    for (char c : spec) {
+        if (std::isspace(static_cast<unsigned char>(c)) || c == ',') {
+            if (!current.empty()) {
+                tokens.push_back(current);
+                current.clear();
+            }
+            if (c == ',') {
+                tokens.push_back(",");
+            }
+        } else {
+            current += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+    }
+
+    if (!current.empty()) {
+        tokens.push_back(current);
+    }
+    return tokens;
+}
+
+std::vector<std::string> Split(const std::string& value, char separator) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+
+    for (;;) {
+        size_t end = value.find(separator, start);
+        parts.push_back(value.substr(start, end == std::string::npos ? std::string::npos : end - start));
+        if (end == std::string::npos) {
+            return parts;
+        }
+        start = end + 1;
+    }
+}
+
+uint8_t ParseGestureKey(const std::string& name) {
+    if (name == "ctrl" || name == "control") return kGestureKeyCtrl;
+    if (name == "alt" || name == "option") return kGestureKeyAlt;
+    if (name == "shift") return kGestureKeyShift;
+    if (name == "capslock" || name == "caps") return kGestureKeyCapsLock;
+    if (name == "meta" || name == "cmd" || name == "command" || name == "super" || name == "win") {
+        return kGestureKeyMeta;
+    }
+    if (name == "fn") return kGestureKeyFn;
+
+    uint32_t keyCode = HotkeyManager::parseAccelerator(name).keyCode;
+    return keyCode < 256 ? static_cast<uint8_t>(keyCode) : kGestureKeyNone;
+}
+
+bool ParseChord(const std::string& token, GestureKeySet& keys) {
+    std::vector<std::string> names = Split(token, '+');
+    if (names.size() > kMaxChordKeys) {
+        return false;
+    }
+
+    for (const auto& name : names) {
+        uint8_t key = ParseGestureKey(name);
+        if (key == kGestureKeyNone) {
+            return false;
+        }
+        keys.set(key);
+    }
+    return true;
+}
+
+// "tap", "hold", "tap-tap-hold": one entry per repetition of the chord.
+bool ParseActions(const std::string& token, std::vector<bool>& holds) {
+    for (const auto& action : Split(token, '-')) {
+        if (action == "tap") {
+            holds.push_back(false);
+        } else if (action == "hold") {
+            holds.push_back(true);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ParseWindow(const std::vector<std::string>& tokens, size_t index, int& withinMs) {
+    if (index >= tokens.size()) {
+        return false;
+    }
+
+    std::string value = tokens[index];
+    if (value.size() > 2 && value.compare(value.size() - 2, 2, "ms") == 0) {
+        value.resize(value.size() - 2);
+    } else if (index + 1 < tokens.size() && tokens[index + 1] == "ms") {
+        index++;
+    }
+    if (index + 1 != tokens.size() || value.empty()) {
+        return false;
+    }
+
+    char* end = nullptr;
+    long ms = std::strtol(value.c_str(), &end, 10);
+    if (*end != '\0' || ms <= 0 || ms > kMaxWindowMs) {
+        return false;
+    }
+
+    withinMs = static_cast<int>(ms);
+    return true;
+}
+
+}
+
+uint8_t GestureKeyForTrigger(TriggerKey key) {
+    switch (key) {
+        case TriggerKey::Ctrl: return kGestureKeyCtrl;
+        case TriggerKey::Alt: return kGestureKeyAlt;
+        case TriggerKey::Shift: return kGestureKeyShift;
+        case TriggerKey::CapsLock: return kGestureKeyCapsLock;
+        case TriggerKey::Fn: return kGestureKeyFn;
+        default: return kGestureKeyCtrl;
+    }
+}
+
+bool CompileGesture(const std::string& spec, GesturePattern& pattern) {
+    std::vector<std::string> tokens = TokenizeSpec(spec);
+    GesturePattern result;
+    bool expectChord = true;
+
+    for (size_t i = 0; i < tokens.size(); i++) {
+        const std::string& token = tokens[i];
+
+        if (expectChord) {
+            GestureStep step;
+            step.hold = false;
+            if (!ParseChord(token, step.keys)) {
+                return false;
+            }
+
+            std::vector<bool> holds;
+            if (i + 1 < tokens.size() && ParseActions(tokens[i + 1], holds)) {
+                i++;
+            } else {
+                holds.assign(1, false);
+            }
+
+            for (bool hold : holds) {
+                step.hold = hold;
+                result.steps.push_back(step);
+            }
+            expectChord = false;
+        } else if (token == "," || token == "then") {
+            expectChord = true;
+        } else if (token == "within") {
+            if (!ParseWindow(tokens, i + 1, result.withinMs)) {
+                return false;
+            }
+            break;
+        } else {
+            return false;
+        }
+    }
+
+    if (expectChord || result.steps.empty() || result.steps.size() > kMaxGestureSteps) {
+        return false;
+    }
+
+    // Holds fire without a timer, on the press, so only the last step may
+    // be one; anything after it could never be told apart from a tap.
+    for (size_t i = 0; i + 1 < result.steps.size(); i++) {
+        if (result.steps[i].hold) {
+            return false;
+        }
+    }
+
+    pattern = std::move(result);
+    return true;
+}
+
+Gesture::Gesture(GesturePattern pattern, const char* completeEvent, GestureCallback callback)
+    : pattern_(std::move(pattern)),
+      window_(pattern_.withinMs),
+      completeEvent_(completeEvent),
+      callback_(std::move(callback)),
+      step_(0),
+      lastSerial_(0),
+      holding_(false) {}
+
+void Gesture::onPress(uint8_t key, const GestureKeySet& down, uint64_t serial, EventTime at) {
+    if (holding_) {
+        return;
+    }
+
+    // A sequence only continues if no other key was pressed since its last
+    // progress and the step lands inside the window.
+    if (step_ > 0 && (serial != lastSerial_ + 1 || at - lastStepAt_ > window_)) {
+        step_ = 0;
+    }
+
+    if (!pattern_.steps[step_].keys.test(key)) {
+        step_ = 0;
+        if (!pattern_.steps[0].keys.test(key)) {
+            return;
+        }
+    }
+
+    lastSerial_ = serial;
+
+    const GestureStep& step = pattern_.steps[step_];
+    if ((step.keys & down) != step.keys) {
+        return;
+    }
+
+    if (step_ + 1 < pattern_.steps.size()) {
+        step_++;
+        lastStepAt_ = at;
+        return;
+    }
+
+    if (step.hold) {
+        holding_ = true;
+        holdStart_ = at;
+        if (callback_) {
+            callback_("hold-start", 0, at);
+        }
+        return;
+    }
+
+    step_ = 0;
+    if (callback_) {
+        callback_(completeEvent_, 0, at);
+    }
+}
+
+void Gesture::onRelease(uint8_t key, EventTime at) {
+    if (!holding_ || !pattern_.steps[step_].keys.test(key)) {
+        return;
+    }
+
+    holding_ = false;
+    step_ = 0;
+    int duration = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(at - holdStart_).count());
+    if (callback_) {
+        callback_("hold-end", duration, at);
+    }
+}
+
+std::shared_ptr<Gesture> MakeDoubleTapGesture(TriggerKey key, int thresholdMs, DoubleTapCallback callback) {
+    GestureStep tap;
+    tap.keys.set(GestureKeyForTrigger(key));
+    tap.hold = false;
+
+    GesturePattern pattern;
+    pattern.steps.assign(2, tap);
+    pattern.withinMs = thresholdMs;
+
+    return std::make_shared<Gesture>(std::move(pattern), "double-tap",
+        [callback](const std::string& event, int, EventTime at) {
+            if (callback) {
+                callback(event, at);
+            }
+        });
+}
+
+std::shared_ptr<Gesture> MakeHoldGesture(TriggerKey key, HoldCallback callback) {
+    GestureStep hold;
+    hold.keys.set(GestureKeyForTrigger(key));
+    hold.hold = true;
+
+    GesturePattern pattern;
+    pattern.steps.push_back(hold);
+
+    return std::make_shared<Gesture>(std::move(pattern), "hold", std::move(callback));
+}
+
+int32_t GestureRegistry::add(std::shared_ptr<Gesture> gesture) {
+    int32_t id = nextId_++;
+    gestures_[id] = std::move(gesture);
+    return id;
+}
+
+bool GestureRegistry::remove(int32_t id) {
+    return gestures_.erase(id) > 0;
+}
+
+std::shared_ptr<const GestureTable> GestureRegistry::buildTable() const {
+    auto table = std::make_shared<GestureTable>();
+    std::vector<GestureKeySet> gestureKeys;
+
+    for (const auto& pair : gestures_) {
+        GestureKeySet keys;
+        for (const auto& step : pair.second->pattern().steps) {
+            keys |= step.keys;
+        }
+        for (size_t key = 0; key < 256; key++) {
+            if (keys.test(key)) {
+                table->keyStart[key + 1]++;
+            }
+        }
+        table->usedKeys |= keys;
+        table->gestures.push_back(pair.second);
+        gestureKeys.push_back(keys);
+    }
+
+    for (size_t key = 0; key < 256; key++) {
+        table->keyStart[key + 1] += table->keyStart[key];
+    }
+
+    table->byKey.resize(table->keyStart[256]);
+    std::array<uint32_t, 256> next;
+    std::copy(table->keyStart.begin(), table->keyStart.begin() + 256, next.begin());
+    for (size_t i = 0; i < table->gestures.size(); i++) {
+        for (size_t key = 0; key < 256; key++) {
+            if (gestureKeys[i].test(key)) {
+                table->byKey[next[key]++] = table->gestures[i].get();
+            }
+        }
+    }
+
+    return table;
+}
+
+void GestureTracker::onKey(const GestureTable& table, uint8_t key, bool isDown, EventTime at) {
+    if (key == kGestureKeyNone) {
+        if (isDown) {
+            serial_++;
+        }
+        return;
+    }
+
+    ScopedLatency decision(LatencyStage::DetectorDecision);
+
+    if (isDown) {
+        if (down_.test(key)) {
+            return;
+        }
+        serial_++;
+        down_.set(key);
+        for (uint32_t i = table.keyStart[key]; i < table.keyStart[key + 1]; i++) {
+            table.byKey[i]->onPress(key, down_, serial_, at);
+        }
+    } else {
+        if (!down_.test(key)) {
+            return;
+        }
+        down_.reset(key);
+        for (uint32_t i = table.keyStart[key]; i < table.keyStart[key + 1]; i++) {
+            table.byKey[i]->onRelease(key, at);
+        }
+    }
+}
+
+void GestureTracker::reset() {
+    down_.reset();
+}
+
+}
@@ -0,0 +1,128 @@
+#ifndef GESTURE_ENGINE_H
+#define GESTURE_ENGINE_H
+
+#include "hotkey_manager.h"
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace speechly {
+
+// Platform-neutral key codes for gestures: the accelerator key codes used by
+// HotkeyManager::parseAccelerator for ordinary keys, and the Windows
+// virtual-key codes for modifiers (left and right folded together). Each
+// platform maps its raw key codes onto these; anything unmapped reports
+// kGestureKeyNone so it still breaks a sequence in progress.
+const uint8_t kGestureKeyNone = 0x00;
+const uint8_t kGestureKeyShift = 0x10;
+const uint8_t kGestureKeyCtrl = 0x11;
+const uint8_t kGestureKeyAlt = 0x12;
+const uint8_t kGestureKeyCapsLock = 0x14;
+const uint8_t kGestureKeyMeta = 0x5B;
+const uint8_t kGestureKeyFn = 0xFF;
+
+using GestureKeySet = std::bitset<256>;
+
+uint8_t GestureKeyForTrigger(TriggerKey key);
+
+// One step of a gesture: a chord that completes when all of its keys are
+// down, either as a tap (fires on the press) or, for the last step only, a
+// hold (fires hold-start on the press and hold-end with the duration when
+// any chord key is released).
+struct GestureStep {
+    GestureKeySet keys;
+    bool hold;
+};
+
+struct GesturePattern {
+    std::vector<GestureStep> steps;
+    int withinMs;
+
+    GesturePattern() : withinMs(300) {}
+};
+
+// Parses a gesture spec into a pattern. Steps are separated by "," or
+// "then"; keys in a chord are joined with "+"; a step may end with a
+// dash-joined action list that repeats its chord, and the spec may end with
+// "within <n>ms" bounding the time between consecutive steps:
+//
+//   "Ctrl,Ctrl"   "Alt+Shift hold"   "Ctrl tap-tap-hold"
+//   "Ctrl then Space within 200ms"
+bool CompileGesture(const std::string& spec, GesturePattern& pattern);
+
+// A compiled gesture and its recognition state. The state is only touched by
+// the thread that feeds key events to the GestureTracker.
+class Gesture {
+public:
+    Gesture(GesturePattern pattern, const char* completeEvent, GestureCallback callback);
+
+    void onPress(uint8_t key, const GestureKeySet& down, uint64_t serial, EventTime at);
+    void onRelease(uint8_t key, EventTime at);
+
+    const GesturePattern& pattern() const { return pattern_; }
+
+private:
+    GesturePattern pattern_;
+    std::chrono::milliseconds window_;
+    const char* completeEvent_;
+    GestureCallback callback_;
+    size_t step_;
+    uint64_t lastSerial_;
+    EventTime lastStepAt_;
+    bool holding_;
+    EventTime holdStart_;
+};
+
+// Immutable key -> gestures index, rebuilt whenever a gesture is added or
+// removed. Gestures are bucketed by every key they mention, so a key event
+// costs one table lookup plus the gestures that actually use that key; keys
+// no gesture mentions never reach a gesture at all.
+struct GestureTable {
+    std::vector<std::shared_ptr<Gesture>> gestures;
+    std::array<uint32_t, 257> keyStart{};
+    std::vector<Gesture*> byKey;
+    GestureKeySet usedKeys;
+};
+
+// The fixed gestures behind registerDoubleTapListener and
+// registerHoldListener, reporting through their original callback shapes.
+std::shared_ptr<Gesture> MakeDoubleTapGesture(TriggerKey key, int thresholdMs, DoubleTapCallback callback);
+std::shared_ptr<Gesture> MakeHoldGesture(TriggerKey key, HoldCallback callback);
+
+// Registration side of a KeyListener: owns the gestures by listener id and
+// builds tables from them. Callers serialize access.
+class GestureRegistry {
+public:
+    GestureRegistry() : nextId_(1) {}
+
+    int32_t add(std::shared_ptr<Gesture> gesture);
+    bool remove(int32_t id);
+    std::shared_ptr<const GestureTable> buildTable() const;
+
+private:
+    std::map<int32_t, std::shared_ptr<Gesture>> gestures_;
+    int32_t nextId_;
+};
+
+// Per-thread key state fed with every raw key event. Auto-repeat presses of
+// a key that is already down are dropped, and every real press advances a
+// serial so a gesture can tell whether another key came between its steps.
+class GestureTracker {
+public:
+    GestureTracker() : serial_(0) {}
+
+    void onKey(const GestureTable& table, uint8_t key, bool isDown, EventTime at);
+    void reset();
+
+private:
+    GestureKeySet down_;
+    uint64_t serial_;
+};
+
+}
+
+#endif
@@ -6,64 +6,6 @@
 
 namespace speechly {
 
-bool DoubleTapDetector::detectDoubleTap() {
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastTapTime).count();
-    
-    if (elapsed < thresholdMs && tapCount > 0) {
-        tapCount = 0;
-        return true;
-    }
-    
-    return false;
-}
-
-void DoubleTapDetector::reset() {
-    tapCount = 0;
-    wasKeyUp = true;
-}
-
-void DoubleTapDetector::onKeyDown() {
-    if (wasKeyUp) {
-        auto now = std::chrono::steady_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastTapTime).count();
-        
-        if (elapsed > thresholdMs) {
-            tapCount = 1;
-        } else {
-            tapCount++;
-        }
-        
-        lastTapTime = now;
-        wasKeyUp = false;
-    }
-}
-
-void DoubleTapDetector::onKeyUp() {
-    wasKeyUp = true;
-}
-
-void HoldDetector::onKeyDown() {
-    if (!isHeld) {
-        isHeld = true;
-        holdStartTime = std::chrono::steady_clock::now();
-    }
-}
-
-void HoldDetector::onKeyUp() {
-    isHeld = false;
-}
-
-bool HoldDetector::isCurrentlyHeld() const {
-    return isHeld;
-}
-
-int HoldDetector::holdDurationMs() const {
-    if (!isHeld) return 0;
-    auto now = std::chrono::steady_clock::now();
-    return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(now - holdStartTime).count());
-}
-
 TriggerKey HotkeyManager::parseTriggerKey(const std::string& keyName) {
     std::string key = keyName;
     std::transform(key.begin(), key.end(), key.begin(), ::tolower);
@@ -234,6 +176,10 @@ int32_t KeyListener::registerHoldListener(const std::string& key, HoldCallback c
     return -1;
 }
 
+int32_t KeyListener::registerGestureListener(const std::string& spec, GestureCallback callback) {
+    return -1;
+}
+
 bool KeyListener::unregisterDoubleTapListener(int32_t id) {
     return false;
 }
@@ -242,6 +188,10 @@ bool KeyListener::unregisterHoldListener(int32_t id) {
     return false;
 }
 
+bool KeyListener::unregisterGestureListener(int32_t id) {
+    return false;
+}
+
 bool KeyListener::start() {
     return false;
 }
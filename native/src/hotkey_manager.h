@@ -32,9 +32,15 @@ struct Hotkey {
     std::string accelerator;
 };
 
-using HotkeyCallback = std::function<void()>;
-using DoubleTapCallback = std::function<void(const std::string&)>;
-using HoldCallback = std::function<void(const std::string&, int)>;
+// When an input event happened, on steady_clock. Platforms stamp events with
+// the time the OS or X server recorded them, not the time a thread got round
+// to processing them, so durations and thresholds are free of delivery jitter.
+using EventTime = std::chrono::steady_clock::time_point;
+
+using HotkeyCallback = std::function<void(EventTime)>;
+using DoubleTapCallback = std::function<void(const std::string&, EventTime)>;
+using HoldCallback = std::function<void(const std::string&, int, EventTime)>;
+using GestureCallback = std::function<void(const std::string&, int, EventTime)>;
 
 enum class TriggerKey {
     Ctrl,
@@ -44,34 +50,6 @@ enum class TriggerKey {
     Fn
 };
 
-struct DoubleTapDetector {
-    TriggerKey key;
-    int tapCount;
-    std::chrono::steady_clock::time_point lastTapTime;
-    int thresholdMs;
-    bool wasKeyUp;
-    
-    DoubleTapDetector() : key(TriggerKey::Ctrl), tapCount(0), thresholdMs(300), wasKeyUp(true) {}
-    
-    bool detectDoubleTap();
-    void reset();
-    void onKeyDown();
-    void onKeyUp();
-};
-
-struct HoldDetector {
-    TriggerKey key;
-    bool isHeld;
-    std::chrono::steady_clock::time_point holdStartTime;
-    
-    HoldDetector() : key(TriggerKey::Ctrl), isHeld(false) {}
-    
-    void onKeyDown();
-    void onKeyUp();
-    bool isCurrentlyHeld() const;
-    int holdDurationMs() const;
-};
-
 class HotkeyManager {
 public:
     HotkeyManager();
@@ -102,8 +80,10 @@ public:
     
     int32_t registerDoubleTapListener(const std::string& key, int thresholdMs, DoubleTapCallback callback);
     int32_t registerHoldListener(const std::string& key, HoldCallback callback);
+    int32_t registerGestureListener(const std::string& spec, GestureCallback callback);
     bool unregisterDoubleTapListener(int32_t id);
     bool unregisterHoldListener(int32_t id);
+    bool unregisterGestureListener(int32_t id);
     
     bool start();
     void stop();
@@ -1,15 +1,25 @@
 #ifdef __linux__
 
 #include "hotkey_manager.h"
+#include "display_pool.h"
+#include "evdev_keys.h"
+#include "evdev_reactor.h"
+#include "gesture_engine.h"
+#include "input_backend.h"
+#include "input_reactor.h"
+#include "snapshot_cell.h"
 #include <X11/Xlib.h>
 #include <X11/keysym.h>
 #include <X11/XKBlib.h>
 #include <X11/extensions/XInput2.h>
-#include <thread>
+#include <linux/input-event-codes.h>
+#include <array>
 #include <atomic>
+#include <bitset>
 #include <map>
+#include <memory>
 #include <mutex>
-#include <unistd.h>
+#include <vector>
 
 namespace speechly {
 
@@ -72,26 +82,68 @@ static KeySym ConvertKeyCode(uint32_t keyCode) {
     }
 }
 
-static KeySym GetKeySymForTrigger(TriggerKey key) {
-    switch (key) {
-        case TriggerKey::Ctrl: return XK_Control_L;
-        case TriggerKey::Alt: return XK_Alt_L;
-        case TriggerKey::Shift: return XK_Shift_L;
-        case TriggerKey::CapsLock: return XK_Caps_Lock;
-        case TriggerKey::Fn: return NoSymbol;
-        default: return XK_Control_L;
+static const unsigned int kHotkeyModifierMask = ControlMask | Mod1Mask | ShiftMask | Mod4Mask;
+
+static size_t HotkeySlot(unsigned int keycode, unsigned int xMods) {
+    size_t modIndex = 0;
+    if (xMods & ControlMask) modIndex |= 1;
+    if (xMods & Mod1Mask) modIndex |= 2;
+    if (xMods & ShiftMask) modIndex |= 4;
+    if (xMods & Mod4Mask) modIndex |= 8;
+    return ((keycode & 0xFF) << 4) | modIndex;
+}
+
+// Evdev-backed listeners never talk to X, so they get an empty lease instead
+// of opening a display that may not exist.
+static DisplayLease AcquireInputDisplay(InputBackend backend) {
+    if (backend == InputBackend::Evdev) {
+        return DisplayLease(nullptr, std::unique_lock<std::recursive_mutex>());
     }
+    return AcquireDisplay(DisplayAffinity::Reactor);
 }
 
+static const uint16_t kEvdevModifierKeys[] = {
+    KEY_LEFTCTRL, KEY_RIGHTCTRL, KEY_LEFTALT, KEY_RIGHTALT,
+    KEY_LEFTSHIFT, KEY_RIGHTSHIFT, KEY_LEFTMETA, KEY_RIGHTMETA
+};
+
+struct HotkeyTable {
+    std::array<uint16_t, 256 * 16> slots{};
+    std::vector<HotkeyCallback> callbacks;
+};
+
+// With the X11 backend hotkeys are passive grabs keyed by X keycode. With
+// evdev nothing can be grabbed, so the same table is keyed by KEY_* code and
+// matched against the modifiers currently held; the key still reaches the
+// focused application.
 class HotkeyManager::Impl {
 public:
     std::atomic<bool> running{false};
-    std::thread watcherThread;
+    InputBackend backend{GetInputBackend()};
     std::map<int32_t, HotkeyCallback> callbacks;
     std::map<int32_t, std::pair<unsigned int, KeyCode>> hotkeys;
     std::mutex mutex;
     int32_t nextId{1};
-    Display* display{nullptr};
+    int32_t handlerId{-1};
+    SnapshotCell<HotkeyTable> table;
+    SnapshotCell<HotkeyTable>::Reader tableReader;
+    std::bitset<256> evdevDown;
+    
+    void rebuildTable() {
+        auto next = std::make_shared<HotkeyTable>();
+        
+        for (const auto& pair : hotkeys) {
+            size_t slot = HotkeySlot(pair.second.second, pair.second.first);
+            if (next->slots[slot] != 0) {
+                continue;
+            }
+            
+            next->callbacks.push_back(callbacks[pair.first]);
+            next->slots[slot] = static_cast<uint16_t>(next->callbacks.size());
+        }
+        
+        table.publish(std::move(next));
+    }
     
     void grabKey(Display* dpy, unsigned int modifiers, KeyCode keycode) {
         Window root = DefaultRootWindow(dpy);
@@ -114,57 +166,43 @@ public:
         }
     }
     
-    void watchLoop() {
-        Display* dpy = XOpenDisplay(nullptr);
-        if (!dpy) {
-            running = false;
+    void onEvent(XEvent& event) {
+        if (event.type != KeyPress) {
             return;
         }
         
-        {
-            std::lock_guard<std::mutex> lock(mutex);
-            for (const auto& pair : hotkeys) {
-                grabKey(dpy, pair.second.first, pair.second.second);
-            }
-        }
+        XKeyEvent* keyEvent = &event.xkey;
+        const HotkeyTable& snapshot = table.read(tableReader);
+        uint16_t entry = snapshot.slots[HotkeySlot(keyEvent->keycode, keyEvent->state & kHotkeyModifierMask)];
         
-        Window root = DefaultRootWindow(dpy);
-        XSelectInput(dpy, root, KeyPressMask);
+        if (entry != 0 && snapshot.callbacks[entry - 1]) {
+            snapshot.callbacks[entry - 1](InputReactor::instance().serverTimeToSteady(keyEvent->time));
+        }
+    }
+    
+    void onEvdevKey(uint16_t code, int32_t value, EventTime at) {
+        if (code >= evdevDown.size()) {
+            return;
+        }
         
-        while (running) {
-            while (XPending(dpy) > 0) {
-                XEvent event;
-                XNextEvent(dpy, &event);
-                
-                if (event.type == KeyPress) {
-                    XKeyEvent* keyEvent = &event.xkey;
-                    unsigned int modState = keyEvent->state & (ControlMask | Mod1Mask | ShiftMask | Mod4Mask);
-                    
-                    std::lock_guard<std::mutex> lock(mutex);
-                    for (const auto& pair : hotkeys) {
-                        if (pair.second.second == keyEvent->keycode &&
-                            pair.second.first == modState) {
-                            auto it = callbacks.find(pair.first);
-                            if (it != callbacks.end() && it->second) {
-                                it->second();
-                            }
-                            break;
-                        }
-                    }
-                }
-            }
-            
-            usleep(10000);
+        evdevDown[code] = value != 0;
+        if (value != 1) {
+            return;
         }
         
-        {
-            std::lock_guard<std::mutex> lock(mutex);
-            for (const auto& pair : hotkeys) {
-                ungrabKey(dpy, pair.second.first, pair.second.second);
+        unsigned int xMods = 0;
+        for (uint16_t modifierKey : kEvdevModifierKeys) {
+            if (evdevDown[modifierKey]) {
+                xMods |= ConvertModifiers(ModifierForEvdevKey(modifierKey));
             }
         }
         
-        XCloseDisplay(dpy);
+        const HotkeyTable& snapshot = table.read(tableReader);
+        uint16_t entry = snapshot.slots[HotkeySlot(code, xMods)];
+        
+        if (entry != 0 && snapshot.callbacks[entry - 1]) {
+            snapshot.callbacks[entry - 1](at);
+        }
     }
 };
 
@@ -181,35 +219,51 @@ int32_t HotkeyManager::registerHotkey(const std::string& accelerator, HotkeyCall
 }
 
 int32_t HotkeyManager::registerHotkey(uint32_t modifiers, uint32_t keyCode, HotkeyCallback callback) {
-    std::lock_guard<std::mutex> lock(impl_->mutex);
+    if (impl_->backend == InputBackend::Evdev) {
+        uint16_t code = EvdevKeyForAccelerator(keyCode);
+        if (code == 0 || code > 0xFF) {
+            return -1;
+        }
+        
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        int32_t id = impl_->nextId++;
+        impl_->callbacks[id] = callback;
+        impl_->hotkeys[id] = {ConvertModifiers(modifiers), static_cast<KeyCode>(code)};
+        impl_->rebuildTable();
+        return id;
+    }
     
-    Display* dpy = XOpenDisplay(nullptr);
+    DisplayLease dpy = AcquireDisplay(DisplayAffinity::Reactor);
     if (!dpy) {
         return -1;
     }
     
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    
     KeySym keysym = ConvertKeyCode(keyCode);
     if (keysym == NoSymbol) {
-        XCloseDisplay(dpy);
         return -1;
     }
     
-    KeyCode xKeyCode = XKeysymToKeycode(dpy, keysym);
+    KeyCode xKeyCode = XKeysymToKeycode(dpy.get(), keysym);
     unsigned int xMods = ConvertModifiers(modifiers);
     
     int32_t id = impl_->nextId++;
     impl_->callbacks[id] = callback;
     impl_->hotkeys[id] = {xMods, xKeyCode};
+    impl_->rebuildTable();
     
     if (impl_->running) {
-        impl_->grabKey(dpy, xMods, xKeyCode);
+        impl_->grabKey(dpy.get(), xMods, xKeyCode);
+        XFlush(dpy.get());
+        InputReactor::instance().wake();
     }
     
-    XCloseDisplay(dpy);
     return id;
 }
 
 bool HotkeyManager::unregisterHotkey(int32_t id) {
+    DisplayLease dpy = AcquireInputDisplay(impl_->backend);
     std::lock_guard<std::mutex> lock(impl_->mutex);
     
     auto it = impl_->callbacks.find(id);
@@ -218,35 +272,34 @@ bool HotkeyManager::unregisterHotkey(int32_t id) {
     }
     
     auto hkIt = impl_->hotkeys.find(id);
-    if (hkIt != impl_->hotkeys.end() && impl_->running) {
-        Display* dpy = XOpenDisplay(nullptr);
-        if (dpy) {
-            impl_->ungrabKey(dpy, hkIt->second.first, hkIt->second.second);
-            XCloseDisplay(dpy);
-        }
+    if (hkIt != impl_->hotkeys.end() && impl_->running && dpy) {
+        impl_->ungrabKey(dpy.get(), hkIt->second.first, hkIt->second.second);
+        XFlush(dpy.get());
+        InputReactor::instance().wake();
     }
     
     impl_->callbacks.erase(it);
     impl_->hotkeys.erase(id);
+    impl_->rebuildTable();
     
     return true;
 }
 
 void HotkeyManager::unregisterAll() {
+    DisplayLease dpy = AcquireInputDisplay(impl_->backend);
     std::lock_guard<std::mutex> lock(impl_->mutex);
     
-    if (impl_->running) {
-        Display* dpy = XOpenDisplay(nullptr);
-        if (dpy) {
-            for (const auto& pair : impl_->hotkeys) {
-                impl_->ungrabKey(dpy, pair.second.first, pair.second.second);
-            }
-            XCloseDisplay(dpy);
+    if (impl_->running && dpy) {
+        for (const auto& pair : impl_->hotkeys) {
+            impl_->ungrabKey(dpy.get(), pair.second.first, pair.second.second);
         }
+        XFlush(dpy.get());
+        InputReactor::instance().wake();
     }
     
     impl_->callbacks.clear();
     impl_->hotkeys.clear();
+    impl_->rebuildTable();
 }
 
 bool HotkeyManager::start() {
@@ -254,8 +307,41 @@ bool HotkeyManager::start() {
         return true;
     }
     
-    impl_->running = true;
-    impl_->watcherThread = std::thread(&Impl::watchLoop, impl_);
+    if (impl_->backend == InputBackend::Evdev) {
+        EvdevReactor& evdev = EvdevReactor::instance();
+        if (!evdev.retain()) {
+            return false;
+        }
+        
+        Impl* impl = impl_;
+        impl_->running = true;
+        impl_->handlerId = evdev.addKeyHandler([impl](uint16_t code, int32_t value, EventTime at) {
+            impl->onEvdevKey(code, value, at);
+        });
+        return true;
+    }
+    
+    InputReactor& reactor = InputReactor::instance();
+    if (!reactor.retain()) {
+        return false;
+    }
+    
+    {
+        DisplayLease dpy = AcquireDisplay(DisplayAffinity::Reactor);
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        if (dpy) {
+            for (const auto& pair : impl_->hotkeys) {
+                impl_->grabKey(dpy.get(), pair.second.first, pair.second.second);
+            }
+            XFlush(dpy.get());
+        }
+        impl_->running = true;
+    }
+    
+    Impl* impl = impl_;
+    impl_->handlerId = reactor.addXEventHandler(KeyPressMask, [impl](Display*, XEvent& event) {
+        impl->onEvent(event);
+    });
     
     return true;
 }
@@ -265,11 +351,32 @@ void HotkeyManager::stop() {
         return;
     }
     
-    impl_->running = false;
+    if (impl_->backend == InputBackend::Evdev) {
+        EvdevReactor& evdev = EvdevReactor::instance();
+        evdev.removeKeyHandler(impl_->handlerId);
+        impl_->handlerId = -1;
+        impl_->running = false;
+        evdev.release();
+        return;
+    }
+    
+    InputReactor& reactor = InputReactor::instance();
+    reactor.removeXEventHandler(impl_->handlerId);
+    impl_->handlerId = -1;
     
-    if (impl_->watcherThread.joinable()) {
-        impl_->watcherThread.join();
+    {
+        DisplayLease dpy = AcquireDisplay(DisplayAffinity::Reactor);
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        if (dpy) {
+            for (const auto& pair : impl_->hotkeys) {
+                impl_->ungrabKey(dpy.get(), pair.second.first, pair.second.second);
+            }
+            XFlush(dpy.get());
+        }
+        impl_->running = false;
     }
+    
+    reactor.release();
 }
 
 bool HotkeyManager::isRunning() const {
@@ -284,44 +391,111 @@ bool UnregisterGlobalHotkey(int32_t id) {
     return false;
 }
 
-struct DoubleTapListenerInfo {
-    TriggerKey key;
-    int thresholdMs;
-    DoubleTapCallback callback;
-    DoubleTapDetector detector;
-    KeyCode keycode;
+// Raw X keycode -> gesture key for every key the registered gestures name,
+// alongside the gesture index itself, published together so the reactor
+// thread sees one consistent pair.
+struct KeyListenerTable {
+    std::array<uint8_t, 256> gestureKeys{};
+    std::shared_ptr<const GestureTable> gestures = std::make_shared<GestureTable>();
 };
 
-struct HoldListenerInfo {
-    TriggerKey key;
-    HoldCallback callback;
-    HoldDetector detector;
-    KeyCode keycode;
-};
+static void GetKeySymsForGestureKey(uint8_t key, KeySym keysyms[2]) {
+    keysyms[0] = NoSymbol;
+    keysyms[1] = NoSymbol;
+    
+    switch (key) {
+        case kGestureKeyCtrl:
+            keysyms[0] = XK_Control_L;
+            keysyms[1] = XK_Control_R;
+            break;
+        case kGestureKeyAlt:
+            keysyms[0] = XK_Alt_L;
+            keysyms[1] = XK_Alt_R;
+            break;
+        case kGestureKeyShift:
+            keysyms[0] = XK_Shift_L;
+            keysyms[1] = XK_Shift_R;
+            break;
+        case kGestureKeyCapsLock:
+            keysyms[0] = XK_Caps_Lock;
+            break;
+        case kGestureKeyMeta:
+            keysyms[0] = XK_Super_L;
+            keysyms[1] = XK_Super_R;
+            break;
+        case kGestureKeyFn:
+            break;
+        default:
+            keysyms[0] = ConvertKeyCode(key);
+            break;
+    }
+}
 
 class KeyListener::Impl {
 public:
     std::atomic<bool> running{false};
-    std::thread watcherThread;
-    std::map<int32_t, DoubleTapListenerInfo> doubleTapListeners;
-    std::map<int32_t, HoldListenerInfo> holdListeners;
+    InputBackend backend{GetInputBackend()};
+    GestureRegistry registry;
     std::mutex mutex;
-    int32_t nextId{1};
+    int32_t handlerId{-1};
+    int xiOpcode{-1};
+    SnapshotCell<KeyListenerTable> table;
+    SnapshotCell<KeyListenerTable>::Reader tableReader;
+    GestureTracker tracker;
+    
+    void rebuildTable(Display* dpy) {
+        auto next = std::make_shared<KeyListenerTable>();
+        next->gestures = registry.buildTable();
+        
+        // Evdev events carry KEY_* codes, which map to gesture keys through
+        // a fixed table instead.
+        for (size_t key = 1; dpy && key < 256; key++) {
+            if (!next->gestures->usedKeys.test(key)) {
+                continue;
+            }
+            
+            KeySym keysyms[2];
+            GetKeySymsForGestureKey(static_cast<uint8_t>(key), keysyms);
+            for (KeySym keysym : keysyms) {
+                KeyCode keycode = keysym == NoSymbol ? 0 : XKeysymToKeycode(dpy, keysym);
+                if (keycode != 0) {
+                    next->gestureKeys[keycode] = static_cast<uint8_t>(key);
+                }
+            }
+        }
+        
+        table.publish(std::move(next));
+    }
     
-    void watchLoop() {
-        Display* dpy = XOpenDisplay(nullptr);
-        if (!dpy) {
-            running = false;
-            return;
+    int32_t add(std::shared_ptr<Gesture> gesture) {
+        DisplayLease dpy = AcquireInputDisplay(backend);
+        if (!dpy && backend == InputBackend::X11) {
+            return -1;
         }
         
-        int xiOpcode, xiEvent, xiError;
-        if (!XQueryExtension(dpy, "XInputExtension", &xiOpcode, &xiEvent, &xiError)) {
-            XCloseDisplay(dpy);
-            running = false;
-            return;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (dpy) {
+            InputReactor::instance().wake();
         }
         
+        int32_t id = registry.add(std::move(gesture));
+        rebuildTable(dpy.get());
+        return id;
+    }
+    
+    bool remove(int32_t id) {
+        DisplayLease dpy = AcquireInputDisplay(backend);
+        std::lock_guard<std::mutex> lock(mutex);
+        
+        if ((!dpy && backend == InputBackend::X11) || !registry.remove(id)) {
+            return false;
+        }
+        
+        rebuildTable(dpy.get());
+        return true;
+    }
+    
+    void selectRawEvents(Display* dpy, bool enable) {
         Window root = DefaultRootWindow(dpy);
         
         XIEventMask eventMask;
@@ -329,68 +503,41 @@ public:
         eventMask.deviceid = XIAllMasterDevices;
         eventMask.mask_len = sizeof(mask);
         eventMask.mask = mask;
-        XISetMask(mask, XI_RawKeyPress);
-        XISetMask(mask, XI_RawKeyRelease);
+        if (enable) {
+            XISetMask(mask, XI_RawKeyPress);
+            XISetMask(mask, XI_RawKeyRelease);
+        }
         
         XISelectEvents(dpy, root, &eventMask, 1);
-        XSync(dpy, False);
+        XFlush(dpy);
+    }
+    
+    void onEvent(XEvent& event) {
+        if (event.xcookie.type != GenericEvent || event.xcookie.extension != xiOpcode ||
+            !event.xcookie.data) {
+            return;
+        }
         
-        while (running) {
-            while (XPending(dpy) > 0) {
-                XEvent event;
-                XNextEvent(dpy, &event);
-                
-                if (event.xcookie.type == GenericEvent && event.xcookie.extension == xiOpcode) {
-                    if (XGetEventData(dpy, &event.xcookie)) {
-                        XIRawEvent* rawEvent = static_cast<XIRawEvent*>(event.xcookie.data);
-                        KeyCode keycode = static_cast<KeyCode>(rawEvent->detail);
-                        bool isKeyDown = (rawEvent->evtype == XI_RawKeyPress);
-                        bool isKeyUp = (rawEvent->evtype == XI_RawKeyRelease);
-                        
-                        std::lock_guard<std::mutex> lock(mutex);
-                        
-                        for (auto& pair : doubleTapListeners) {
-                            if (pair.second.keycode == keycode) {
-                                if (isKeyDown) {
-                                    pair.second.detector.onKeyDown();
-                                    if (pair.second.detector.tapCount >= 2) {
-                                        pair.second.detector.reset();
-                                        if (pair.second.callback) {
-                                            pair.second.callback("double-tap");
-                                        }
-                                    }
-                                } else if (isKeyUp) {
-                                    pair.second.detector.onKeyUp();
-                                }
-                            }
-                        }
-                        
-                        for (auto& pair : holdListeners) {
-                            if (pair.second.keycode == keycode) {
-                                if (isKeyDown && !pair.second.detector.isCurrentlyHeld()) {
-                                    pair.second.detector.onKeyDown();
-                                    if (pair.second.callback) {
-                                        pair.second.callback("hold-start", 0);
-                                    }
-                                } else if (isKeyUp && pair.second.detector.isCurrentlyHeld()) {
-                                    int duration = pair.second.detector.holdDurationMs();
-                                    pair.second.detector.onKeyUp();
-                                    if (pair.second.callback) {
-                                        pair.second.callback("hold-end", duration);
-                                    }
-                                }
-                            }
-                        }
-                        
-                        XFreeEventData(dpy, &event.xcookie);
-                    }
-                }
-            }
-            
-            usleep(10000);
+        XIRawEvent* rawEvent = static_cast<XIRawEvent*>(event.xcookie.data);
+        if (rawEvent->evtype != XI_RawKeyPress && rawEvent->evtype != XI_RawKeyRelease) {
+            return;
         }
         
-        XCloseDisplay(dpy);
+        const KeyListenerTable& current = table.read(tableReader);
+        if (current.gestures->gestures.empty()) {
+            return;
+        }
+        
+        uint8_t key = current.gestureKeys[rawEvent->detail & 0xFF];
+        EventTime at = InputReactor::instance().serverTimeToSteady(rawEvent->time);
+        tracker.onKey(*current.gestures, key, rawEvent->evtype == XI_RawKeyPress, at);
+    }
+    
+    void onEvdevKey(uint16_t code, int32_t value, EventTime at) {
+        const KeyListenerTable& current = table.read(tableReader);
+        if (!current.gestures->gestures.empty()) {
+            tracker.onKey(*current.gestures, GestureKeyForEvdevKey(code), value != 0, at);
+        }
     }
 };
 
@@ -402,73 +549,42 @@ KeyListener::~KeyListener() {
 }
 
 int32_t KeyListener::registerDoubleTapListener(const std::string& key, int thresholdMs, DoubleTapCallback callback) {
-    std::lock_guard<std::mutex> lock(impl_->mutex);
-    
-    Display* dpy = XOpenDisplay(nullptr);
-    if (!dpy) {
-        return -1;
-    }
-    
     TriggerKey triggerKey = HotkeyManager::parseTriggerKey(key);
-    KeySym keysym = GetKeySymForTrigger(triggerKey);
-    if (keysym == NoSymbol) {
-        XCloseDisplay(dpy);
+    if (triggerKey == TriggerKey::Fn) {
         return -1;
     }
     
-    KeyCode keycode = XKeysymToKeycode(dpy, keysym);
-    XCloseDisplay(dpy);
-    
-    int32_t id = impl_->nextId++;
-    DoubleTapListenerInfo info;
-    info.key = triggerKey;
-    info.thresholdMs = thresholdMs;
-    info.callback = callback;
-    info.detector.key = triggerKey;
-    info.detector.thresholdMs = thresholdMs;
-    info.keycode = keycode;
-    
-    impl_->doubleTapListeners[id] = info;
-    return id;
+    return impl_->add(MakeDoubleTapGesture(triggerKey, thresholdMs, std::move(callback)));
 }
 
 int32_t KeyListener::registerHoldListener(const std::string& key, HoldCallback callback) {
-    std::lock_guard<std::mutex> lock(impl_->mutex);
-    
-    Display* dpy = XOpenDisplay(nullptr);
-    if (!dpy) {
+    TriggerKey triggerKey = HotkeyManager::parseTriggerKey(key);
+    if (triggerKey == TriggerKey::Fn) {
         return -1;
     }
     
-    TriggerKey triggerKey = HotkeyManager::parseTriggerKey(key);
-    KeySym keysym = GetKeySymForTrigger(triggerKey);
-    if (keysym == NoSymbol) {
-        XCloseDisplay(dpy);
+    return impl_->add(MakeHoldGesture(triggerKey, std::move(callback)));
+}
+
+int32_t KeyListener::registerGestureListener(const std::string& spec, GestureCallback callback) {
+    GesturePattern pattern;
+    if (!CompileGesture(spec, pattern)) {
         return -1;
     }
     
-    KeyCode keycode = XKeysymToKeycode(dpy, keysym);
-    XCloseDisplay(dpy);
-    
-    int32_t id = impl_->nextId++;
-    HoldListenerInfo info;
-    info.key = triggerKey;
-    info.callback = callback;
-    info.detector.key = triggerKey;
-    info.keycode = keycode;
-    
-    impl_->holdListeners[id] = info;
-    return id;
+    return impl_->add(std::make_shared<Gesture>(std::move(pattern), "gesture", std::move(callback)));
 }
 
 bool KeyListener::unregisterDoubleTapListener(int32_t id) {
-    std::lock_guard<std::mutex> lock(impl_->mutex);
-    return impl_->doubleTapListeners.erase(id) > 0;
+    return impl_->remove(id);
 }
 
 bool KeyListener::unregisterHoldListener(int32_t id) {
-    std::lock_guard<std::mutex> lock(impl_->mutex);
-    return impl_->holdListeners.erase(id) > 0;
+    return impl_->remove(id);
+}
+
+bool KeyListener::unregisterGestureListener(int32_t id) {
+    return impl_->remove(id);
 }
 
 bool KeyListener::start() {
@@ -476,8 +592,41 @@ bool KeyListener::start() {
         return true;
     }
     
-    impl_->running = true;
-    impl_->watcherThread = std::thread(&Impl::watchLoop, impl_);
+    if (impl_->backend == InputBackend::Evdev) {
+        EvdevReactor& evdev = EvdevReactor::instance();
+        if (!evdev.retain()) {
+            return false;
+        }
+        
+        Impl* impl = impl_;
+        impl_->running = true;
+        impl_->handlerId = evdev.addKeyHandler([impl](uint16_t code, int32_t value, EventTime at) {
+            impl->onEvdevKey(code, value, at);
+        });
+        return true;
+    }
+    
+    InputReactor& reactor = InputReactor::instance();
+    if (!reactor.retain()) {
+        return false;
+    }
+    
+    {
+        DisplayLease dpy = AcquireDisplay(DisplayAffinity::Reactor);
+        int xiEvent, xiError;
+        if (!dpy || !XQueryExtension(dpy.get(), "XInputExtension", &impl_->xiOpcode, &xiEvent, &xiError)) {
+            reactor.release();
+            return false;
+        }
+        
+        impl_->selectRawEvents(dpy.get(), true);
+        impl_->running = true;
+    }
+    
+    Impl* impl = impl_;
+    impl_->handlerId = reactor.addXEventHandler(NoEventMask, [impl](Display*, XEvent& event) {
+        impl->onEvent(event);
+    });
     
     return true;
 }
@@ -487,11 +636,31 @@ void KeyListener::stop() {
         return;
     }
     
-    impl_->running = false;
+    if (impl_->backend == InputBackend::Evdev) {
+        EvdevReactor& evdev = EvdevReactor::instance();
+        // Waits out a dispatch in progress, so the tracker is ours again.
+        evdev.removeKeyHandler(impl_->handlerId);
+        impl_->handlerId = -1;
+        impl_->running = false;
+        evdev.release();
+        impl_->tracker.reset();
+        return;
+    }
     
-    if (impl_->watcherThread.joinable()) {
-        impl_->watcherThread.join();
+    InputReactor& reactor = InputReactor::instance();
+    reactor.removeXEventHandler(impl_->handlerId);
+    impl_->handlerId = -1;
+    
+    {
+        DisplayLease dpy = AcquireDisplay(DisplayAffinity::Reactor);
+        if (dpy) {
+            impl_->selectRawEvents(dpy.get(), false);
+        }
+        impl_->tracker.reset();
+        impl_->running = false;
     }
+    
+    reactor.release();
 }
 
 bool KeyListener::isRunning() const {
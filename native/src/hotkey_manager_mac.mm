@@ -1,8 +1,11 @@
 #ifdef __APPLE__
 
 #include "hotkey_manager.h"
+#include "gesture_engine.h"
 #import <Carbon/Carbon.h>
 #import <Cocoa/Cocoa.h>
+#include <mach/mach_time.h>
+#include <array>
 #include <map>
 #include <mutex>
 #include <atomic>
@@ -10,8 +13,8 @@
 
 namespace speechly {
 
-static UInt32 ConvertKeyCode(uint32_t keyCode) {
-    static std::map<uint32_t, UInt32> keyMap = {
+static const std::map<uint32_t, UInt32>& AcceleratorKeyMap() {
+    static const std::map<uint32_t, UInt32> keyMap = {
         {'A', kVK_ANSI_A}, {'B', kVK_ANSI_B}, {'C', kVK_ANSI_C}, {'D', kVK_ANSI_D},
         {'E', kVK_ANSI_E}, {'F', kVK_ANSI_F}, {'G', kVK_ANSI_G}, {'H', kVK_ANSI_H},
         {'I', kVK_ANSI_I}, {'J', kVK_ANSI_J}, {'K', kVK_ANSI_K}, {'L', kVK_ANSI_L},
@@ -40,7 +43,11 @@ static UInt32 ConvertKeyCode(uint32_t keyCode) {
         {0x74, kVK_F5}, {0x75, kVK_F6}, {0x76, kVK_F7}, {0x77, kVK_F8},
         {0x78, kVK_F9}, {0x79, kVK_F10}, {0x7A, kVK_F11}, {0x7B, kVK_F12}
     };
-    
+    return keyMap;
+}
+
+static UInt32 ConvertKeyCode(uint32_t keyCode) {
+    const std::map<uint32_t, UInt32>& keyMap = AcceleratorKeyMap();
     auto it = keyMap.find(keyCode);
     return (it != keyMap.end()) ? it->second : 0;
 }
@@ -64,28 +71,70 @@ static UInt32 ConvertModifiers(uint32_t modifiers) {
     return macMods;
 }
 
-static CGEventFlags GetModifierFlagForTrigger(TriggerKey key) {
-    switch (key) {
-        case TriggerKey::Ctrl: return kCGEventFlagMaskControl;
-        case TriggerKey::Alt: return kCGEventFlagMaskAlternate;
-        case TriggerKey::Shift: return kCGEventFlagMaskShift;
-        case TriggerKey::CapsLock: return kCGEventFlagMaskAlphaShift;
-        case TriggerKey::Fn: return kCGEventFlagMaskSecondaryFn;
-        default: return kCGEventFlagMaskControl;
-    }
+// Virtual key code -> gesture key, covering the accelerator keys and both
+// sides of every modifier.
+static uint8_t GestureKeyForKeyCode(CGKeyCode keyCode) {
+    static const std::array<uint8_t, 128> table = [] {
+        std::array<uint8_t, 128> result{};
+        for (const auto& pair : AcceleratorKeyMap()) {
+            if (pair.second < result.size()) {
+                result[pair.second] = static_cast<uint8_t>(pair.first);
+            }
+        }
+        result[kVK_Control] = kGestureKeyCtrl;
+        result[kVK_RightControl] = kGestureKeyCtrl;
+        result[kVK_Option] = kGestureKeyAlt;
+        result[kVK_RightOption] = kGestureKeyAlt;
+        result[kVK_Shift] = kGestureKeyShift;
+        result[kVK_RightShift] = kGestureKeyShift;
+        result[kVK_Command] = kGestureKeyMeta;
+        result[kVK_RightCommand] = kGestureKeyMeta;
+        result[kVK_CapsLock] = kGestureKeyCapsLock;
+        result[kVK_Function] = kGestureKeyFn;
+        return result;
+    }();
+    
+    return keyCode < table.size() ? table[keyCode] : kGestureKeyNone;
 }
 
-static CGKeyCode GetKeyCodeForTrigger(TriggerKey key) {
+static CGEventFlags GetModifierFlagForGestureKey(uint8_t key) {
     switch (key) {
-        case TriggerKey::Ctrl: return kVK_Control;
-        case TriggerKey::Alt: return kVK_Option;
-        case TriggerKey::Shift: return kVK_Shift;
-        case TriggerKey::CapsLock: return kVK_CapsLock;
-        case TriggerKey::Fn: return kVK_Function;
-        default: return kVK_Control;
+        case kGestureKeyCtrl: return kCGEventFlagMaskControl;
+        case kGestureKeyAlt: return kCGEventFlagMaskAlternate;
+        case kGestureKeyShift: return kCGEventFlagMaskShift;
+        case kGestureKeyMeta: return kCGEventFlagMaskCommand;
+        case kGestureKeyCapsLock: return kCGEventFlagMaskAlphaShift;
+        case kGestureKeyFn: return kCGEventFlagMaskSecondaryFn;
+        default: return 0;
     }
 }
 
+// Event taps are fed from a run loop port and Carbon handlers from the main
+// run loop, so either can run well after the key was pressed. Both events
+// carry their own time: CGEvent timestamps are mach_absolute_time() ticks
+// and Carbon event times are the same clock in seconds. libc++'s
+// steady_clock counts that clock too (CLOCK_UPTIME_RAW), so the times map
+// straight across. Events posted without a time, or with one ahead of now,
+// get now.
+static EventTime SteadyFromUptime(std::chrono::nanoseconds uptime) {
+    auto now = std::chrono::steady_clock::now();
+    EventTime at(std::chrono::duration_cast<std::chrono::steady_clock::duration>(uptime));
+    return (uptime.count() <= 0 || at > now) ? now : at;
+}
+
+static EventTime SteadyFromMachTicks(uint64_t ticks) {
+    static const mach_timebase_info_data_t timebase = [] {
+        mach_timebase_info_data_t info;
+        mach_timebase_info(&info);
+        return info;
+    }();
+    return SteadyFromUptime(std::chrono::nanoseconds(ticks * timebase.numer / timebase.denom));
+}
+
+static EventTime SteadyFromCarbonTime(::EventTime seconds) {
+    return SteadyFromUptime(std::chrono::nanoseconds(static_cast<int64_t>(seconds * 1e9)));
+}
+
 class HotkeyManager::Impl {
 public:
     std::atomic<bool> running{false};
@@ -116,8 +165,9 @@ public:
         }
         
         if (cb) {
+            EventTime at = SteadyFromCarbonTime(GetEventTime(event));
             dispatch_async(dispatch_get_main_queue(), ^{
-                cb();
+                cb(at);
             });
         }
         
@@ -283,26 +333,13 @@ bool UnregisterGlobalHotkey(int32_t id) {
     return false;
 }
 
-struct DoubleTapListenerInfo {
-    TriggerKey key;
-    int thresholdMs;
-    DoubleTapCallback callback;
-    DoubleTapDetector detector;
-};
-
-struct HoldListenerInfo {
-    TriggerKey key;
-    HoldCallback callback;
-    HoldDetector detector;
-};
-
 class KeyListener::Impl {
 public:
     std::atomic<bool> running{false};
-    std::map<int32_t, DoubleTapListenerInfo> doubleTapListeners;
-    std::map<int32_t, HoldListenerInfo> holdListeners;
+    GestureRegistry registry;
+    std::shared_ptr<const GestureTable> table{std::make_shared<GestureTable>()};
+    GestureTracker tracker;
     std::mutex mutex;
-    int32_t nextId{1};
     CFMachPortRef eventTap{nullptr};
     CFRunLoopSourceRef runLoopSource{nullptr};
     std::thread eventThread;
@@ -318,69 +355,53 @@ public:
             return event;
         }
         
-        if (type != kCGEventFlagsChanged) {
+        if (type != kCGEventFlagsChanged && type != kCGEventKeyDown && type != kCGEventKeyUp) {
             return event;
         }
         
-        CGEventFlags flags = CGEventGetFlags(event);
         CGKeyCode keyCode = static_cast<CGKeyCode>(CGEventGetIntegerValueField(event, kCGKeyboardEventKeycode));
-        
-        std::lock_guard<std::mutex> lock(instance->mutex);
-        
-        for (auto& pair : instance->doubleTapListeners) {
-            CGKeyCode targetKeyCode = GetKeyCodeForTrigger(pair.second.key);
-            CGEventFlags targetFlag = GetModifierFlagForTrigger(pair.second.key);
-            
-            if (keyCode == targetKeyCode) {
-                bool isPressed = (flags & targetFlag) != 0;
-                
-                if (isPressed) {
-                    pair.second.detector.onKeyDown();
-                    if (pair.second.detector.tapCount >= 2) {
-                        pair.second.detector.reset();
-                        if (pair.second.callback) {
-                            dispatch_async(dispatch_get_main_queue(), ^{
-                                pair.second.callback("double-tap");
-                            });
-                        }
-                    }
-                } else {
-                    pair.second.detector.onKeyUp();
-                }
+        uint8_t key = GestureKeyForKeyCode(keyCode);
+        bool isDown = (type == kCGEventKeyDown);
+        if (type == kCGEventFlagsChanged) {
+            // Modifiers only report a new flag state; the key's own flag
+            // says which way it went.
+            CGEventFlags flag = GetModifierFlagForGestureKey(key);
+            if (flag == 0) {
+                return event;
             }
+            isDown = (CGEventGetFlags(event) & flag) != 0;
         }
         
-        for (auto& pair : instance->holdListeners) {
-            CGKeyCode targetKeyCode = GetKeyCodeForTrigger(pair.second.key);
-            CGEventFlags targetFlag = GetModifierFlagForTrigger(pair.second.key);
-            
-            if (keyCode == targetKeyCode) {
-                bool isPressed = (flags & targetFlag) != 0;
-                
-                if (isPressed && !pair.second.detector.isCurrentlyHeld()) {
-                    pair.second.detector.onKeyDown();
-                    if (pair.second.callback) {
-                        dispatch_async(dispatch_get_main_queue(), ^{
-                            pair.second.callback("hold-start", 0);
-                        });
-                    }
-                } else if (!isPressed && pair.second.detector.isCurrentlyHeld()) {
-                    int duration = pair.second.detector.holdDurationMs();
-                    pair.second.detector.onKeyUp();
-                    if (pair.second.callback) {
-                        dispatch_async(dispatch_get_main_queue(), ^{
-                            pair.second.callback("hold-end", duration);
-                        });
-                    }
-                }
-            }
+        EventTime at = SteadyFromMachTicks(CGEventGetTimestamp(event));
+        
+        std::lock_guard<std::mutex> lock(instance->mutex);
+        if (!instance->table->gestures.empty()) {
+            instance->tracker.onKey(*instance->table, key, isDown, at);
         }
         
         return event;
     }
     
+    int32_t add(std::shared_ptr<Gesture> gesture) {
+        std::lock_guard<std::mutex> lock(mutex);
+        int32_t id = registry.add(std::move(gesture));
+        table = registry.buildTable();
+        return id;
+    }
+    
+    bool remove(int32_t id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!registry.remove(id)) {
+            return false;
+        }
+        table = registry.buildTable();
+        return true;
+    }
+    
     void eventLoop() {
-        CGEventMask eventMask = CGEventMaskBit(kCGEventFlagsChanged);
+        CGEventMask eventMask = CGEventMaskBit(kCGEventFlagsChanged) |
+                                CGEventMaskBit(kCGEventKeyDown) |
+                                CGEventMaskBit(kCGEventKeyUp);
         
         eventTap = CGEventTapCreate(kCGSessionEventTap, kCGHeadInsertEventTap,
                                     kCGEventTapOptionListenOnly, eventMask,
@@ -425,41 +446,34 @@ KeyListener::~KeyListener() {
 }
 
 int32_t KeyListener::registerDoubleTapListener(const std::string& key, int thresholdMs, DoubleTapCallback callback) {
-    std::lock_guard<std::mutex> lock(impl_->mutex);
-    
-    int32_t id = impl_->nextId++;
-    DoubleTapListenerInfo info;
-    info.key = HotkeyManager::parseTriggerKey(key);
-    info.thresholdMs = thresholdMs;
-    info.callback = callback;
-    info.detector.key = info.key;
-    info.detector.thresholdMs = thresholdMs;
-    
-    impl_->doubleTapListeners[id] = info;
-    return id;
+    TriggerKey triggerKey = HotkeyManager::parseTriggerKey(key);
+    return impl_->add(MakeDoubleTapGesture(triggerKey, thresholdMs, std::move(callback)));
 }
 
 int32_t KeyListener::registerHoldListener(const std::string& key, HoldCallback callback) {
-    std::lock_guard<std::mutex> lock(impl_->mutex);
-    
-    int32_t id = impl_->nextId++;
-    HoldListenerInfo info;
-    info.key = HotkeyManager::parseTriggerKey(key);
-    info.callback = callback;
-    info.detector.key = info.key;
+    TriggerKey triggerKey = HotkeyManager::parseTriggerKey(key);
+    return impl_->add(MakeHoldGesture(triggerKey, std::move(callback)));
+}
+
+int32_t KeyListener::registerGestureListener(const std::string& spec, GestureCallback callback) {
+    GesturePattern pattern;
+    if (!CompileGesture(spec, pattern)) {
+        return -1;
+    }
     
-    impl_->holdListeners[id] = info;
-    return id;
+    return impl_->add(std::make_shared<Gesture>(std::move(pattern), "gesture", std::move(callback)));
 }
 
 bool KeyListener::unregisterDoubleTapListener(int32_t id) {
-    std::lock_guard<std::mutex> lock(impl_->mutex);
-    return impl_->doubleTapListeners.erase(id) > 0;
+    return impl_->remove(id);
 }
 
 bool KeyListener::unregisterHoldListener(int32_t id) {
-    std::lock_guard<std::mutex> lock(impl_->mutex);
-    return impl_->holdListeners.erase(id) > 0;
+    return impl_->remove(id);
+}
+
+bool KeyListener::unregisterGestureListener(int32_t id) {
+    return impl_->remove(id);
 }
 
 bool KeyListener::start() {
@@ -483,6 +497,9 @@ void KeyListener::stop() {
     if (impl_->eventThread.joinable()) {
         impl_->eventThread.join();
     }
+    
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    impl_->tracker.reset();
 }
 
 bool KeyListener::isRunning() const {
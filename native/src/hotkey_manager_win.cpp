@@ -1,6 +1,7 @@
 #ifdef _WIN32
 
 #include "hotkey_manager.h"
+#include "gesture_engine.h"
 #include <windows.h>
 #include <thread>
 #include <atomic>
@@ -28,15 +29,12 @@ static UINT ConvertModifiers(uint32_t modifiers) {
     return winMods | MOD_NOREPEAT;
 }
 
-static DWORD GetVirtualKeyForTrigger(TriggerKey key) {
-    switch (key) {
-        case TriggerKey::Ctrl: return VK_CONTROL;
-        case TriggerKey::Alt: return VK_MENU;
-        case TriggerKey::Shift: return VK_SHIFT;
-        case TriggerKey::CapsLock: return VK_CAPITAL;
-        case TriggerKey::Fn: return 0xFF;
-        default: return VK_CONTROL;
-    }
+// Message and hook timestamps are GetTickCount() values; their age against
+// the current tick count places them on steady_clock. Unsigned subtraction
+// keeps this correct across the 49.7-day wraparound.
+static EventTime TickCountToSteady(DWORD ticks) {
+    DWORD ageMs = GetTickCount() - ticks;
+    return std::chrono::steady_clock::now() - std::chrono::milliseconds(ageMs);
 }
 
 class HotkeyManager::Impl {
@@ -77,7 +75,7 @@ public:
                 }
                 
                 if (cb) {
-                    cb();
+                    cb(TickCountToSteady(static_cast<DWORD>(msg.time)));
                 }
             }
         }
@@ -205,27 +203,34 @@ bool UnregisterGlobalHotkey(int32_t id) {
     return UnregisterHotKey(NULL, id) != 0;
 }
 
-struct DoubleTapListenerInfo {
-    TriggerKey key;
-    int thresholdMs;
-    DoubleTapCallback callback;
-    DoubleTapDetector detector;
-};
-
-struct HoldListenerInfo {
-    TriggerKey key;
-    HoldCallback callback;
-    HoldDetector detector;
-};
+// The low-level hook reports left/right modifier codes; gestures name the
+// generic ones.
+static uint8_t GestureKeyForVirtualKey(DWORD vkCode) {
+    switch (vkCode) {
+        case VK_LCONTROL:
+        case VK_RCONTROL:
+            return kGestureKeyCtrl;
+        case VK_LMENU:
+        case VK_RMENU:
+            return kGestureKeyAlt;
+        case VK_LSHIFT:
+        case VK_RSHIFT:
+            return kGestureKeyShift;
+        case VK_RWIN:
+            return kGestureKeyMeta;
+        default:
+            return vkCode < 0xFF ? static_cast<uint8_t>(vkCode) : kGestureKeyNone;
+    }
+}
 
 class KeyListener::Impl {
 public:
     std::atomic<bool> running{false};
     std::thread hookThread;
-    std::map<int32_t, DoubleTapListenerInfo> doubleTapListeners;
-    std::map<int32_t, HoldListenerInfo> holdListeners;
+    GestureRegistry registry;
+    std::shared_ptr<const GestureTable> table{std::make_shared<GestureTable>()};
+    GestureTracker tracker;
     std::mutex mutex;
-    int32_t nextId{1};
     HHOOK keyboardHook{nullptr};
     
     static Impl* instance;
@@ -237,40 +242,11 @@ public:
             bool isKeyDown = (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN);
             bool isKeyUp = (wParam == WM_KEYUP || wParam == WM_SYSKEYUP);
             
-            std::lock_guard<std::mutex> lock(instance->mutex);
-            
-            for (auto& pair : instance->doubleTapListeners) {
-                DWORD targetVK = GetVirtualKeyForTrigger(pair.second.key);
-                if (kbd->vkCode == targetVK) {
-                    if (isKeyDown) {
-                        pair.second.detector.onKeyDown();
-                        if (pair.second.detector.tapCount >= 2) {
-                            pair.second.detector.reset();
-                            if (pair.second.callback) {
-                                pair.second.callback("double-tap");
-                            }
-                        }
-                    } else if (isKeyUp) {
-                        pair.second.detector.onKeyUp();
-                    }
-                }
-            }
-            
-            for (auto& pair : instance->holdListeners) {
-                DWORD targetVK = GetVirtualKeyForTrigger(pair.second.key);
-                if (kbd->vkCode == targetVK) {
-                    if (isKeyDown && !pair.second.detector.isCurrentlyHeld()) {
-                        pair.second.detector.onKeyDown();
-                        if (pair.second.callback) {
-                            pair.second.callback("hold-start", 0);
-                        }
-                    } else if (isKeyUp && pair.second.detector.isCurrentlyHeld()) {
-                        int duration = pair.second.detector.holdDurationMs();
-                        pair.second.detector.onKeyUp();
-                        if (pair.second.callback) {
-                            pair.second.callback("hold-end", duration);
-                        }
-                    }
+            if (isKeyDown || isKeyUp) {
+                EventTime at = TickCountToSteady(kbd->time);
+                std::lock_guard<std::mutex> lock(instance->mutex);
+                if (!instance->table->gestures.empty()) {
+                    instance->tracker.onKey(*instance->table, GestureKeyForVirtualKey(kbd->vkCode), isKeyDown, at);
                 }
             }
         }
@@ -278,6 +254,22 @@ public:
         return CallNextHookEx(nullptr, nCode, wParam, lParam);
     }
     
+    int32_t add(std::shared_ptr<Gesture> gesture) {
+        std::lock_guard<std::mutex> lock(mutex);
+        int32_t id = registry.add(std::move(gesture));
+        table = registry.buildTable();
+        return id;
+    }
+    
+    bool remove(int32_t id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!registry.remove(id)) {
+            return false;
+        }
+        table = registry.buildTable();
+        return true;
+    }
+    
     void hookLoop() {
         keyboardHook = SetWindowsHookEx(WH_KEYBOARD_LL, LowLevelKeyboardProc, nullptr, 0);
         
@@ -314,41 +306,34 @@ KeyListener::~KeyListener() {
 }
 
 int32_t KeyListener::registerDoubleTapListener(const std::string& key, int thresholdMs, DoubleTapCallback callback) {
-    std::lock_guard<std::mutex> lock(impl_->mutex);
-    
-    int32_t id = impl_->nextId++;
-    DoubleTapListenerInfo info;
-    info.key = HotkeyManager::parseTriggerKey(key);
-    info.thresholdMs = thresholdMs;
-    info.callback = callback;
-    info.detector.key = info.key;
-    info.detector.thresholdMs = thresholdMs;
-    
-    impl_->doubleTapListeners[id] = info;
-    return id;
+    TriggerKey triggerKey = HotkeyManager::parseTriggerKey(key);
+    return impl_->add(MakeDoubleTapGesture(triggerKey, thresholdMs, std::move(callback)));
 }
 
 int32_t KeyListener::registerHoldListener(const std::string& key, HoldCallback callback) {
-    std::lock_guard<std::mutex> lock(impl_->mutex);
-    
-    int32_t id = impl_->nextId++;
-    HoldListenerInfo info;
-    info.key = HotkeyManager::parseTriggerKey(key);
-    info.callback = callback;
-    info.detector.key = info.key;
+    TriggerKey triggerKey = HotkeyManager::parseTriggerKey(key);
+    return impl_->add(MakeHoldGesture(triggerKey, std::move(callback)));
+}
+
+int32_t KeyListener::registerGestureListener(const std::string& spec, GestureCallback callback) {
+    GesturePattern pattern;
+    if (!CompileGesture(spec, pattern)) {
+        return -1;
+    }
     
-    impl_->holdListeners[id] = info;
-    return id;
+    return impl_->add(std::make_shared<Gesture>(std::move(pattern), "gesture", std::move(callback)));
 }
 
 bool KeyListener::unregisterDoubleTapListener(int32_t id) {
-    std::lock_guard<std::mutex> lock(impl_->mutex);
-    return impl_->doubleTapListeners.erase(id) > 0;
+    return impl_->remove(id);
 }
 
 bool KeyListener::unregisterHoldListener(int32_t id) {
-    std::lock_guard<std::mutex> lock(impl_->mutex);
-    return impl_->holdListeners.erase(id) > 0;
+    return impl_->remove(id);
+}
+
+bool KeyListener::unregisterGestureListener(int32_t id) {
+    return impl_->remove(id);
 }
 
 bool KeyListener::start() {
@@ -374,6 +359,9 @@ void KeyListener::stop() {
     if (impl_->hookThread.joinable()) {
         impl_->hookThread.join();
     }
+    
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    impl_->tracker.reset();
 }
 
 bool KeyListener::isRunning() const {
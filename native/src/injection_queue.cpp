@@ -0,0 +1,155 @@
+#include "injection_queue.h"
+#include "latency_metrics.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace speechly {
+
+struct QueuedInjection {
+    uint32_t id;
+    InjectionJob job;
+    std::shared_ptr<std::atomic<bool>> cancelled;
+    std::chrono::steady_clock::time_point queuedAt;
+};
+
+class InjectionQueue::Impl {
+public:
+    Impl(TextInjector& injector, InjectionCompletion onComplete)
+        : injector(injector), onComplete(std::move(onComplete)), nextId(1), stopping(false) {}
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (true) {
+            wakeup.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (jobs.empty()) {
+                return;
+            }
+
+            QueuedInjection job = std::move(jobs.front());
+            jobs.pop_front();
+            RecordLatencySince(LatencyStage::InjectionEnqueue, job.queuedAt);
+
+            // Only what cancel() needs stays shared; the text is the
+            // worker's alone from here.
+            currentId = job.id;
+            currentCancelled = job.cancelled;
+
+            if (job.job.delayMs > 0) {
+                wakeup.wait_for(lock, std::chrono::milliseconds(job.job.delayMs), [&job] {
+                    return job.cancelled->load();
+                });
+            }
+
+            lock.unlock();
+
+            InjectionResult result;
+            if (*job.cancelled) {
+                result = {false, "Injection cancelled"};
+            } else {
+                result = injector.injectText(job.job.text, job.job.method, job.cancelled.get());
+            }
+            onComplete(job.id, result);
+
+            lock.lock();
+            currentCancelled.reset();
+        }
+    }
+
+    TextInjector& injector;
+    InjectionCompletion onComplete;
+    mutable std::mutex mutex;
+    std::condition_variable wakeup;
+    std::deque<QueuedInjection> jobs;
+    uint32_t currentId{0};
+    std::shared_ptr<std::atomic<bool>> currentCancelled;
+    uint32_t nextId;
+    bool stopping;
+    std::thread worker;
+};
+
+InjectionQueue::InjectionQueue(TextInjector& injector, InjectionCompletion onComplete)
+    : impl_(new Impl(injector, std::move(onComplete))) {}
+
+InjectionQueue::~InjectionQueue() {
+    cancelAll();
+
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->stopping = true;
+    }
+    impl_->wakeup.notify_all();
+
+    if (impl_->worker.joinable()) {
+        impl_->worker.join();
+    }
+
+    delete impl_;
+}
+
+uint32_t InjectionQueue::enqueue(InjectionJob job) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+
+    uint32_t id = impl_->nextId++;
+    impl_->jobs.push_back({id, std::move(job), std::make_shared<std::atomic<bool>>(false),
+                           std::chrono::steady_clock::now()});
+
+    if (!impl_->worker.joinable()) {
+        impl_->worker = std::thread(&Impl::run, impl_);
+    }
+
+    impl_->wakeup.notify_all();
+    return id;
+}
+
+bool InjectionQueue::cancel(uint32_t jobId) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+
+    bool found = false;
+    if (impl_->currentCancelled && impl_->currentId == jobId) {
+        *impl_->currentCancelled = true;
+        found = true;
+    }
+
+    for (auto& job : impl_->jobs) {
+        if (job.id == jobId) {
+            *job.cancelled = true;
+            found = true;
+        }
+    }
+
+    if (found) {
+        impl_->wakeup.notify_all();
+    }
+    return found;
+}
+
+size_t InjectionQueue::cancelAll() {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+
+    size_t count = 0;
+    if (impl_->currentCancelled && !impl_->currentCancelled->exchange(true)) {
+        count++;
+    }
+
+    for (auto& job : impl_->jobs) {
+        if (!job.cancelled->exchange(true)) {
+            count++;
+        }
+    }
+
+    impl_->wakeup.notify_all();
+    return count;
+}
+
+size_t InjectionQueue::pending() const {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    return impl_->jobs.size() + (impl_->currentCancelled ? 1 : 0);
+}
+
+}
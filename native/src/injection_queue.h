@@ -0,0 +1,42 @@
+#ifndef INJECTION_QUEUE_H
+#define INJECTION_QUEUE_H
+
+#include "text_injector.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace speechly {
+
+struct InjectionJob {
+    std::string text;
+    InjectionMethod method;
+    uint32_t delayMs;
+
+    InjectionJob() : method(InjectionMethod::Auto), delayMs(0) {}
+};
+
+using InjectionCompletion = std::function<void(uint32_t jobId, const InjectionResult& result)>;
+
+// Runs injections on one worker thread in submission order so the caller's
+// thread never sleeps or types. Every job completes exactly once, including
+// jobs that are cancelled before or while they run.
+class InjectionQueue {
+public:
+    InjectionQueue(TextInjector& injector, InjectionCompletion onComplete);
+    ~InjectionQueue();
+
+    uint32_t enqueue(InjectionJob job);
+    bool cancel(uint32_t jobId);
+    size_t cancelAll();
+    size_t pending() const;
+
+private:
+    class Impl;
+    Impl* impl_;
+};
+
+}
+
+#endif
@@ -0,0 +1,295 @@
+#include "injection_strategy.h"
+#include "utf8.h"
+#include "window_detector.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+namespace speechly {
+
+namespace {
+
+const size_t kMaxApps = 128;
+const size_t kMaxDirectLength = 256;
+const double kAlpha = 0.25;
+const double kMinSuccessRate = 0.8;
+const double kDefaultClipboardUs = 30000;
+const double kDefaultDirectPerCharUs = 1500;
+// Each time a method is passed over as unreliable, its success rate moves
+// this far back toward 1, so it gets retried after a few dozen injections
+// instead of being locked out for good.
+const double kRecovery = 0.02;
+// Clipboard cost is timed only until the paste chord is sent, while direct
+// typing is timed to the last key, so the clipboard tends to look cheaper
+// than it is and would otherwise be the only method ever sampled again.
+// Every this many choices for an app, the method that lost is used instead
+// so both averages keep tracking the app.
+const uint32_t kExploreEvery = 20;
+// The table is written at most once per this many records or this interval,
+// whichever comes first, and when the strategy is flushed.
+const uint32_t kSaveEveryRecords = 16;
+const auto kSaveInterval = std::chrono::seconds(30);
+
+struct MethodModel {
+    uint32_t samples{0};
+    double costUs{0};
+    double successRate{1};
+
+    void add(double sampleUs, bool success) {
+        if (samples == 0) {
+            costUs = sampleUs;
+        } else {
+            costUs += kAlpha * (sampleUs - costUs);
+        }
+        successRate += kAlpha * ((success ? 1.0 : 0.0) - successRate);
+        samples++;
+    }
+
+    bool reliable() const {
+        return samples == 0 || successRate >= kMinSuccessRate;
+    }
+
+    void forgive() {
+        successRate += kRecovery * (1.0 - successRate);
+    }
+};
+
+struct AppModel {
+    MethodModel clipboard;
+    MethodModel direct;
+    uint64_t lastUsed{0};
+    uint32_t choices{0};
+};
+
+size_t CodepointCount(const std::string& text) {
+    size_t count = 0;
+    for (size_t pos = 0; pos < text.size(); count++) {
+        DecodeUtf8(text, pos);
+    }
+    return count;
+}
+
+}
+
+class InjectionStrategy::Impl {
+public:
+    AppModel& model(const std::string& processName);
+    void load();
+    void save();
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, AppModel> apps;
+    std::string path;
+    uint64_t clock{0};
+    uint32_t unsavedRecords{0};
+    std::chrono::steady_clock::time_point lastSave;
+};
+
+AppModel& InjectionStrategy::Impl::model(const std::string& processName) {
+    auto it = apps.find(processName);
+    if (it == apps.end()) {
+        if (apps.size() >= kMaxApps) {
+            auto oldest = apps.begin();
+            for (auto candidate = apps.begin(); candidate != apps.end(); ++candidate) {
+                if (candidate->second.lastUsed < oldest->second.lastUsed) {
+                    oldest = candidate;
+                }
+            }
+            apps.erase(oldest);
+        }
+        it = apps.emplace(processName, AppModel()).first;
+    }
+    it->second.lastUsed = ++clock;
+    return it->second;
+}
+
+// One line per process: name, then samples/cost/success for clipboard and
+// direct, tab separated.
+void InjectionStrategy::Impl::load() {
+    std::ifstream file(path);
+    std::string line;
+
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string name;
+        if (!std::getline(fields, name, '\t') || name.empty()) {
+            continue;
+        }
+
+        AppModel app;
+        fields >> app.clipboard.samples >> app.clipboard.costUs >> app.clipboard.successRate
+               >> app.direct.samples >> app.direct.costUs >> app.direct.successRate;
+        if (!fields.fail()) {
+            app.lastUsed = ++clock;
+            apps[name] = app;
+        }
+    }
+}
+
+void InjectionStrategy::Impl::save() {
+    unsavedRecords = 0;
+    lastSave = std::chrono::steady_clock::now();
+    if (path.empty()) {
+        return;
+    }
+
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::trunc);
+        if (!file) {
+            return;
+        }
+
+        for (const auto& entry : apps) {
+            const AppModel& app = entry.second;
+            file << entry.first << '\t'
+                 << app.clipboard.samples << ' ' << app.clipboard.costUs << ' ' << app.clipboard.successRate << ' '
+                 << app.direct.samples << ' ' << app.direct.costUs << ' ' << app.direct.successRate << '\n';
+        }
+    }
+
+    std::rename(tempPath.c_str(), path.c_str());
+}
+
+InjectionStrategy& InjectionStrategy::instance() {
+    static InjectionStrategy* strategy = new InjectionStrategy();
+    return *strategy;
+}
+
+InjectionStrategy::InjectionStrategy() : impl_(new Impl()) {}
+
+InjectionStrategy::~InjectionStrategy() {
+    delete impl_;
+}
+
+InjectionMethod InjectionStrategy::choose(const std::string& processName, const std::string& text) {
+    // Direct typing turns newlines into Return presses, which submit forms
+    // and chat messages, so multi-line text always goes through the clipboard,
+    // as does text the active backend cannot type as written.
+    size_t length = CodepointCount(text);
+    if (length > kMaxDirectLength || text.find('\n') != std::string::npos || !CanInjectDirect(text)) {
+        return InjectionMethod::Clipboard;
+    }
+
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    AppModel& app = impl_->model(processName);
+
+    if (!app.direct.reliable()) {
+        app.direct.forgive();
+        return InjectionMethod::Clipboard;
+    }
+    if (!app.clipboard.reliable()) {
+        app.clipboard.forgive();
+        return InjectionMethod::Direct;
+    }
+
+    double perCharUs = app.direct.samples > 0 ? app.direct.costUs : kDefaultDirectPerCharUs;
+    double clipboardUs = app.clipboard.samples > 0 ? app.clipboard.costUs : kDefaultClipboardUs;
+
+    bool direct = perCharUs * length < clipboardUs;
+    if (++app.choices % kExploreEvery == 0) {
+        direct = !direct;
+    }
+    return direct ? InjectionMethod::Direct : InjectionMethod::Clipboard;
+}
+
+void InjectionStrategy::record(const std::string& processName, InjectionMethod method, size_t length,
+                               uint64_t durationUs, bool success) {
+    if (method == InjectionMethod::Auto || length == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    AppModel& app = impl_->model(processName);
+
+    if (method == InjectionMethod::Direct) {
+        app.direct.add(static_cast<double>(durationUs) / length, success);
+    } else {
+        app.clipboard.add(static_cast<double>(durationUs), success);
+    }
+
+    if (++impl_->unsavedRecords >= kSaveEveryRecords ||
+        std::chrono::steady_clock::now() - impl_->lastSave >= kSaveInterval) {
+        impl_->save();
+    }
+}
+
+void InjectionStrategy::flush() {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    if (impl_->unsavedRecords > 0) {
+        impl_->save();
+    }
+}
+
+bool InjectionStrategy::setStoragePath(const std::string& path) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+
+    if (impl_->unsavedRecords > 0) {
+        impl_->save();
+    }
+    impl_->path = path;
+    impl_->apps.clear();
+    impl_->load();
+
+    std::ofstream probe(path, std::ios::app);
+    return static_cast<bool>(probe);
+}
+
+std::vector<InjectionAppStats> InjectionStrategy::snapshot() const {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+
+    std::vector<InjectionAppStats> result;
+    result.reserve(impl_->apps.size());
+
+    for (const auto& entry : impl_->apps) {
+        InjectionAppStats stats;
+        stats.processName = entry.first;
+        stats.clipboardSamples = entry.second.clipboard.samples;
+        stats.clipboardLatencyUs = entry.second.clipboard.costUs;
+        stats.clipboardSuccessRate = entry.second.clipboard.successRate;
+        stats.directSamples = entry.second.direct.samples;
+        stats.directPerCharUs = entry.second.direct.costUs;
+        stats.directSuccessRate = entry.second.direct.successRate;
+        result.push_back(stats);
+    }
+
+    return result;
+}
+
+InjectionResult InjectTextAdaptive(TextInjector& injector, const std::string& text,
+                                   const std::atomic<bool>* cancelled) {
+    std::string processName = GetActiveWindowInfo().processName;
+
+    InjectionStrategy& strategy = InjectionStrategy::instance();
+    InjectionMethod method = strategy.choose(processName, text);
+
+    auto start = std::chrono::steady_clock::now();
+    InjectionResult result = injector.injectText(text, method, cancelled);
+    uint64_t durationUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    if (cancelled && *cancelled) {
+        return result;
+    }
+
+    // A method that turned the text down without sending anything says
+    // nothing about the app, and the clipboard can still deliver it.
+    if (!result.success && !result.inputSent && method == InjectionMethod::Direct) {
+        start = std::chrono::steady_clock::now();
+        method = InjectionMethod::Clipboard;
+        result = injector.injectText(text, method, cancelled);
+        durationUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        if (cancelled && *cancelled) {
+            return result;
+        }
+    }
+
+    strategy.record(processName, method, CodepointCount(text), durationUs, result.success);
+    return result;
+}
+
+}
@@ -0,0 +1,61 @@
+#ifndef INJECTION_STRATEGY_H
+#define INJECTION_STRATEGY_H
+
+#include "text_injector.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace speechly {
+
+struct InjectionAppStats {
+    std::string processName;
+    uint32_t clipboardSamples;
+    double clipboardLatencyUs;
+    double clipboardSuccessRate;
+    uint32_t directSamples;
+    double directPerCharUs;
+    double directSuccessRate;
+
+    InjectionAppStats()
+        : clipboardSamples(0), clipboardLatencyUs(0), clipboardSuccessRate(1),
+          directSamples(0), directPerCharUs(0), directSuccessRate(1) {}
+};
+
+// Backs InjectionMethod::Auto. Keeps a moving average of latency and success
+// for each method per focused process, and picks whichever is expected to
+// get the text on screen sooner; every so often it picks the other one, so
+// a method that once measured badly is sampled again. Direct cost is per
+// code point. A method that keeps failing is passed over but slowly
+// forgiven, so it is probed again later. Once a path has been
+// set, the table is written to disk every few updates and on flush().
+class InjectionStrategy {
+public:
+    static InjectionStrategy& instance();
+
+    InjectionMethod choose(const std::string& processName, const std::string& text);
+    void record(const std::string& processName, InjectionMethod method, size_t length,
+                uint64_t durationUs, bool success);
+    void flush();
+
+    bool setStoragePath(const std::string& path);
+    std::vector<InjectionAppStats> snapshot() const;
+
+private:
+    InjectionStrategy();
+    ~InjectionStrategy();
+
+    class Impl;
+    Impl* impl_;
+};
+
+// Resolves Auto for the focused application, injects, and feeds the
+// measurement back into the strategy.
+InjectionResult InjectTextAdaptive(TextInjector& injector, const std::string& text,
+                                   const std::atomic<bool>* cancelled);
+
+}
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef INPUT_BACKEND_H
+#define INPUT_BACKEND_H
+
+#ifdef __linux__
+
+#include <string>
+
+namespace speechly {
+
+// Which layer Linux key capture and injection go through. X11 sees global
+// input only on an X session; under Wayland it sees XWayland clients alone
+// and without a display it sees nothing. Evdev reads /dev/input and injects
+// through /dev/uinput, below any display server, which needs read access to
+// the input devices and write access to /dev/uinput.
+enum class InputBackend {
+    X11,
+    Evdev
+};
+
+// "x11", "evdev" or "auto". Auto, the default, honours
+// SPEECHLY_INPUT_BACKEND and otherwise picks evdev on Wayland or without a
+// DISPLAY when the device nodes are accessible. HotkeyManager and
+// KeyListener bind to the backend selected when they are created; injection
+// follows the selection on every call.
+bool SelectInputBackend(const std::string& name);
+InputBackend GetInputBackend();
+const char* InputBackendName(InputBackend backend);
+
+}
+
+#endif
+
+#endif
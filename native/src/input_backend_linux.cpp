@@ -0,0 +1,76 @@
+#ifdef __linux__
+
+#include "input_backend.h"
+#include <atomic>
+#include <cstdlib>
+#include <unistd.h>
+
+namespace speechly {
+
+namespace {
+
+const int kBackendUnresolved = -1;
+
+std::atomic<int> g_backend(kBackendUnresolved);
+
+bool HasEnv(const char* name) {
+    const char* value = std::getenv(name);
+    return value && *value;
+}
+
+bool ParseBackend(const std::string& name, int& backend) {
+    if (name == "x11") {
+        backend = static_cast<int>(InputBackend::X11);
+    } else if (name == "evdev") {
+        backend = static_cast<int>(InputBackend::Evdev);
+    } else if (name == "auto" || name.empty()) {
+        backend = kBackendUnresolved;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+InputBackend DetectBackend() {
+    int forced;
+    const char* env = std::getenv("SPEECHLY_INPUT_BACKEND");
+    if (env && ParseBackend(env, forced) && forced != kBackendUnresolved) {
+        return static_cast<InputBackend>(forced);
+    }
+
+    bool xCannotSeeInput = !HasEnv("DISPLAY") || HasEnv("WAYLAND_DISPLAY");
+    bool devicesAccessible = access("/dev/input", R_OK | X_OK) == 0 && access("/dev/uinput", W_OK) == 0;
+    return xCannotSeeInput && devicesAccessible ? InputBackend::Evdev : InputBackend::X11;
+}
+
+}
+
+bool SelectInputBackend(const std::string& name) {
+    int backend;
+    if (!ParseBackend(name, backend)) {
+        return false;
+    }
+
+    g_backend.store(backend, std::memory_order_release);
+    return true;
+}
+
+InputBackend GetInputBackend() {
+    int backend = g_backend.load(std::memory_order_acquire);
+    if (backend != kBackendUnresolved) {
+        return static_cast<InputBackend>(backend);
+    }
+
+    InputBackend detected = DetectBackend();
+    int expected = kBackendUnresolved;
+    g_backend.compare_exchange_strong(expected, static_cast<int>(detected), std::memory_order_acq_rel);
+    return static_cast<InputBackend>(g_backend.load(std::memory_order_acquire));
+}
+
+const char* InputBackendName(InputBackend backend) {
+    return backend == InputBackend::Evdev ? "evdev" : "x11";
+}
+
+}
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef INPUT_REACTOR_H
+#define INPUT_REACTOR_H
+
+#ifdef __linux__
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+
+typedef struct _XDisplay Display;
+typedef union _XEvent XEvent;
+
+namespace speechly {
+
+// One native thread and one epoll set for every X11 input source. Hotkeys,
+// raw key listeners and the window watcher all subscribe here and share the
+// DisplayAffinity::Reactor connection, so their events arrive in one order.
+//
+// Other threads may use the reactor connection through AcquireDisplay() but
+// must call wake() afterwards: Xlib can read events into its queue during
+// those round trips and the reactor would otherwise sleep past them.
+class InputReactor {
+public:
+    using XEventHandler = std::function<void(Display*, XEvent&)>;
+    using TimerHandler = std::function<void(Display*)>;
+
+    static InputReactor& instance();
+
+    bool retain();
+    void release();
+    bool isRunning() const;
+    bool isReactorThread() const;
+
+    int32_t addXEventHandler(long rootEventMask, XEventHandler handler);
+    void removeXEventHandler(int32_t id);
+
+    // One-shot timers backed by timerfd. Arming a pending timer moves its
+    // deadline; handlers run on the reactor thread under the reactor lease.
+    int32_t addTimer(TimerHandler handler);
+    void armTimer(int32_t id, uint32_t delayMs);
+    void removeTimer(int32_t id);
+
+    void wake();
+
+    // Selects PropertyChangeMask on another client's window for one
+    // subscriber. Window tracking and INCR transfers can want the same
+    // window on the shared connection, so subscriptions are counted and
+    // the mask the connection had before the first one is restored after
+    // the last. Call with the reactor lease held.
+    void selectPropertyChanges(Display* display, unsigned long window);
+    void releasePropertyChanges(Display* display, unsigned long window);
+
+    // Maps an X server timestamp (milliseconds on the server's clock,
+    // wrapping at 2^32) onto steady_clock. Reactor thread only, i.e. from
+    // X event and timer handlers.
+    std::chrono::steady_clock::time_point serverTimeToSteady(unsigned long serverTime);
+
+private:
+    InputReactor();
+    ~InputReactor();
+
+    struct XHandlerEntry {
+        int32_t id;
+        long rootEventMask;
+        XEventHandler handler;
+    };
+    using XHandlerList = std::vector<XHandlerEntry>;
+
+    struct TimerEntry {
+        int32_t id;
+        int fd;
+        std::shared_ptr<TimerHandler> handler;
+    };
+
+    struct PropertySelection {
+        int count;
+        long previousMask;
+    };
+
+    void run(std::shared_ptr<std::atomic<bool>> active);
+    bool drainDisplay();
+    void fireTimer(int fd);
+    void updateRootEventMask();
+
+    std::mutex mutex_;
+    std::shared_ptr<const XHandlerList> xHandlers_;
+    std::vector<TimerEntry> timers_;
+    // Guarded by the reactor lease rather than mutex_.
+    std::unordered_map<unsigned long, PropertySelection> propertySelections_;
+    int32_t nextHandlerId_;
+    int refCount_;
+    std::atomic<bool> running_;
+    // Set by the reactor thread itself, so isReactorThread() can be asked
+    // from any thread without touching thread_.
+    std::atomic<std::thread::id> reactorThread_;
+    std::shared_ptr<std::atomic<bool>> active_;
+    std::thread thread_;
+    int epollFd_;
+    int wakeFd_;
+    int connectionFd_;
+
+    // Offset from server time to steady_clock, estimated as the smallest
+    // (arrival - server time) seen so far: every sample is the true offset
+    // plus a delivery delay, so the minimum converges on the true offset.
+    bool serverClockSeeded_;
+    uint32_t lastServerTime_;
+    int64_t serverTimeMs_;
+    int64_t serverOffsetUs_;
+};
+
+}
+
+#endif
+
+#endif
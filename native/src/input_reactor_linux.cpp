@@ -0,0 +1,395 @@
+#ifdef __linux__
+
+#include "input_reactor.h"
+#include "display_pool.h"
+#include <X11/Xlib.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <cerrno>
+
+namespace speechly {
+
+// An offset sample this far above the estimate means the server clock moved
+// (server restart, clock step) rather than a slow delivery; start over.
+static const int64_t kServerClockReseedUs = 1000000;
+
+InputReactor& InputReactor::instance() {
+    static InputReactor* reactor = new InputReactor();
+    return *reactor;
+}
+
+InputReactor::InputReactor()
+    : xHandlers_(std::make_shared<XHandlerList>()),
+      nextHandlerId_(1),
+      refCount_(0),
+      running_(false),
+      reactorThread_(std::thread::id()),
+      epollFd_(epoll_create1(EPOLL_CLOEXEC)),
+      wakeFd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      connectionFd_(-1),
+      serverClockSeeded_(false),
+      lastServerTime_(0),
+      serverTimeMs_(0),
+      serverOffsetUs_(0) {
+    if (epollFd_ >= 0 && wakeFd_ >= 0) {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = wakeFd_;
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &ev);
+    }
+}
+
+InputReactor::~InputReactor() {
+    if (wakeFd_ >= 0) {
+        close(wakeFd_);
+    }
+    if (epollFd_ >= 0) {
+        close(epollFd_);
+    }
+}
+
+std::chrono::steady_clock::time_point InputReactor::serverTimeToSteady(unsigned long serverTime) {
+    using namespace std::chrono;
+    
+    steady_clock::time_point now = steady_clock::now();
+    int64_t nowUs = duration_cast<microseconds>(now.time_since_epoch()).count();
+    uint32_t stamp = static_cast<uint32_t>(serverTime);
+    
+    if (!serverClockSeeded_) {
+        serverTimeMs_ = stamp;
+    } else {
+        // Signed difference, so wraparound and slightly out-of-order
+        // timestamps both extend the 64-bit clock correctly.
+        serverTimeMs_ += static_cast<int32_t>(stamp - lastServerTime_);
+    }
+    lastServerTime_ = stamp;
+    
+    int64_t sampleUs = nowUs - serverTimeMs_ * 1000;
+    if (!serverClockSeeded_ || sampleUs < serverOffsetUs_ ||
+        sampleUs - serverOffsetUs_ > kServerClockReseedUs) {
+        serverOffsetUs_ = sampleUs;
+        serverClockSeeded_ = true;
+    }
+    
+    int64_t mappedUs = serverTimeMs_ * 1000 + serverOffsetUs_;
+    if (mappedUs > nowUs) {
+        return now;
+    }
+    return steady_clock::time_point(duration_cast<steady_clock::duration>(microseconds(mappedUs)));
+}
+
+bool InputReactor::retain() {
+    int connectionFd;
+    {
+        DisplayLease dpy = AcquireDisplay(DisplayAffinity::Reactor);
+        if (!dpy || epollFd_ < 0 || wakeFd_ < 0) {
+            return false;
+        }
+        connectionFd = ConnectionNumber(dpy.get());
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    refCount_++;
+    if (running_) {
+        return true;
+    }
+
+    if (connectionFd_ < 0) {
+        connectionFd_ = connectionFd;
+
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = connectionFd_;
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, connectionFd_, &ev);
+    }
+
+    if (thread_.joinable()) {
+        thread_.detach();
+    }
+
+    auto active = std::make_shared<std::atomic<bool>>(true);
+    active_ = active;
+    running_ = true;
+    thread_ = std::thread(&InputReactor::run, this, active);
+
+    return true;
+}
+
+void InputReactor::release() {
+    std::thread finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (refCount_ == 0 || --refCount_ > 0) {
+            return;
+        }
+
+        // Stopping from a handler would join the reactor with itself; leave
+        // it idling and let the next retain() pick it back up.
+        if (isReactorThread()) {
+            return;
+        }
+
+        running_ = false;
+        if (active_) {
+            *active_ = false;
+        }
+        finished = std::move(thread_);
+    }
+
+    wake();
+
+    if (finished.joinable()) {
+        finished.join();
+    }
+}
+
+bool InputReactor::isRunning() const {
+    return running_;
+}
+
+bool InputReactor::isReactorThread() const {
+    return std::this_thread::get_id() == reactorThread_.load();
+}
+
+int32_t InputReactor::addXEventHandler(long rootEventMask, XEventHandler handler) {
+    DisplayLease dpy = AcquireDisplay(DisplayAffinity::Reactor);
+    if (!dpy) {
+        return -1;
+    }
+
+    int32_t id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        id = nextHandlerId_++;
+        auto handlers = std::make_shared<XHandlerList>(*xHandlers_);
+        handlers->push_back({id, rootEventMask, std::move(handler)});
+        xHandlers_ = std::move(handlers);
+    }
+
+    updateRootEventMask();
+    wake();
+
+    return id;
+}
+
+void InputReactor::removeXEventHandler(int32_t id) {
+    DisplayLease dpy = AcquireDisplay(DisplayAffinity::Reactor);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto handlers = std::make_shared<XHandlerList>();
+        for (const auto& entry : *xHandlers_) {
+            if (entry.id != id) {
+                handlers->push_back(entry);
+            }
+        }
+        xHandlers_ = std::move(handlers);
+    }
+
+    if (dpy) {
+        updateRootEventMask();
+        wake();
+    }
+}
+
+int32_t InputReactor::addTimer(TimerHandler handler) {
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0 || epollFd_ < 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    int32_t id = nextHandlerId_++;
+    timers_.push_back({id, fd, std::make_shared<TimerHandler>(std::move(handler))});
+    return id;
+}
+
+void InputReactor::armTimer(int32_t id, uint32_t delayMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (const auto& timer : timers_) {
+        if (timer.id == id) {
+            itimerspec spec{};
+            spec.it_value.tv_sec = delayMs / 1000;
+            spec.it_value.tv_nsec = static_cast<long>(delayMs % 1000) * 1000000L;
+            if (delayMs == 0) {
+                spec.it_value.tv_nsec = 1;
+            }
+            timerfd_settime(timer.fd, 0, &spec, nullptr);
+            return;
+        }
+    }
+}
+
+void InputReactor::removeTimer(int32_t id) {
+    DisplayLease dpy = AcquireDisplay(DisplayAffinity::Reactor);
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (auto it = timers_.begin(); it != timers_.end(); ++it) {
+        if (it->id == id) {
+            epoll_ctl(epollFd_, EPOLL_CTL_DEL, it->fd, nullptr);
+            close(it->fd);
+            timers_.erase(it);
+            return;
+        }
+    }
+}
+
+void InputReactor::fireTimer(int fd) {
+    std::shared_ptr<TimerHandler> handler;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& timer : timers_) {
+            if (timer.fd == fd) {
+                handler = timer.handler;
+                break;
+            }
+        }
+    }
+
+    uint64_t expirations;
+    if (!handler || read(fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+        return;
+    }
+
+    DisplayLease dpy = AcquireDisplay(DisplayAffinity::Reactor);
+    if (dpy) {
+        (*handler)(dpy.get());
+    }
+}
+
+void InputReactor::wake() {
+    if (wakeFd_ < 0) {
+        return;
+    }
+
+    uint64_t one = 1;
+    ssize_t written = write(wakeFd_, &one, sizeof(one));
+    (void)written;
+}
+
+void InputReactor::selectPropertyChanges(Display* display, unsigned long window) {
+    PropertySelection& selection = propertySelections_[window];
+    if (selection.count++ > 0) {
+        return;
+    }
+
+    XWindowAttributes attributes;
+    selection.previousMask = XGetWindowAttributes(display, window, &attributes)
+        ? attributes.your_event_mask : NoEventMask;
+    XSelectInput(display, window, selection.previousMask | PropertyChangeMask);
+}
+
+void InputReactor::releasePropertyChanges(Display* display, unsigned long window) {
+    auto it = propertySelections_.find(window);
+    if (it == propertySelections_.end() || --it->second.count > 0) {
+        return;
+    }
+
+    XSelectInput(display, window, it->second.previousMask);
+    propertySelections_.erase(it);
+}
+
+void InputReactor::updateRootEventMask() {
+    DisplayLease dpy = AcquireDisplay(DisplayAffinity::Reactor);
+    if (!dpy) {
+        return;
+    }
+
+    long mask = NoEventMask;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& entry : *xHandlers_) {
+            mask |= entry.rootEventMask;
+        }
+    }
+
+    XSelectInput(dpy.get(), DefaultRootWindow(dpy.get()), mask);
+    XFlush(dpy.get());
+}
+
+bool InputReactor::drainDisplay() {
+    DisplayLease dpy = AcquireDisplay(DisplayAffinity::Reactor);
+    if (!dpy) {
+        return false;
+    }
+
+    std::shared_ptr<const XHandlerList> handlers;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        handlers = xHandlers_;
+    }
+
+    while (XPending(dpy.get()) > 0) {
+        XEvent event;
+        XNextEvent(dpy.get(), &event);
+
+        bool hasCookie = event.type == GenericEvent && XGetEventData(dpy.get(), &event.xcookie);
+
+        for (const auto& entry : *handlers) {
+            entry.handler(dpy.get(), event);
+        }
+
+        if (hasCookie) {
+            XFreeEventData(dpy.get(), &event.xcookie);
+        }
+    }
+
+    return true;
+}
+
+void InputReactor::run(std::shared_ptr<std::atomic<bool>> active) {
+    reactorThread_ = std::this_thread::get_id();
+    epoll_event events[8];
+
+    while (*active) {
+        if (!drainDisplay() || !*active) {
+            break;
+        }
+
+        int count = epoll_wait(epollFd_, events, 8, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            if (events[i].data.fd == wakeFd_) {
+                uint64_t value;
+                while (read(wakeFd_, &value, sizeof(value)) == sizeof(value)) {}
+            } else if (events[i].data.fd != connectionFd_) {
+                fireTimer(events[i].data.fd);
+            } else if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                *active = false;
+            }
+        }
+    }
+
+    std::thread::id self = std::this_thread::get_id();
+    reactorThread_.compare_exchange_strong(self, std::thread::id());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (active_ == active) {
+        running_ = false;
+    }
+}
+
+}
+
+#endif
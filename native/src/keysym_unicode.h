@@ -0,0 +1,20 @@
+#ifndef KEYSYM_UNICODE_H
+#define KEYSYM_UNICODE_H
+
+#ifdef __linux__
+
+#include <cstdint>
+
+namespace speechly {
+
+// The character a legacy (pre-Unicode) X keysym types, such as XK_EuroSign
+// for U+20AC or XK_Cyrillic_ya for U+044F; 0 for keysyms that are not in
+// the legacy character sets. Latin-1 keysyms equal their code points and
+// Unicode keysyms are 0x01000000 | code point, so neither needs a table.
+uint32_t UnicodeForLegacyKeysym(unsigned long keysym);
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,214 @@
+#include "language_model.h"
+#include "case_fold.h"
+#include "char_class.h"
+#include "mapped_file.h"
+#include "snapshot_cell.h"
+#include "utf8.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace speechly {
+
+namespace {
+
+struct LoadedModel {
+    MappedFile file;
+    LanguageModelHeader header{};
+    const char* codes{nullptr};
+    const uint8_t* weights{nullptr};
+};
+
+bool IsLetterCodepoint(uint32_t codepoint) {
+    return IsWordCodepoint(codepoint) && codepoint != '_' && !(codepoint >= '0' && codepoint <= '9');
+}
+
+// FNV-1a over the three code points; the profile builder hashes the same way.
+uint32_t HashTrigram(uint32_t a, uint32_t b, uint32_t c) {
+    uint32_t hash = 2166136261u;
+    hash = (hash ^ a) * 16777619u;
+    hash = (hash ^ b) * 16777619u;
+    hash = (hash ^ c) * 16777619u;
+    return hash;
+}
+
+// Calls visit(hash) for every trigram of every space-padded, folded word.
+template <typename Visit>
+size_t ForEachTrigram(const std::string& text, Visit visit) {
+    size_t trigrams = 0;
+    uint32_t previous[2] = {' ', ' '};
+    bool inWord = false;
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        uint32_t codepoint = DecodeUtf8(text, pos);
+        if (!IsLetterCodepoint(codepoint)) {
+            if (inWord) {
+                visit(HashTrigram(previous[0], previous[1], ' '));
+                trigrams++;
+                inWord = false;
+            }
+            continue;
+        }
+
+        codepoint = FoldCase(codepoint);
+        if (!inWord) {
+            previous[0] = ' ';
+            previous[1] = ' ';
+            inWord = true;
+        } else {
+            visit(HashTrigram(previous[0], previous[1], codepoint));
+            trigrams++;
+        }
+        // The first letter only fills the window; a one-letter word still
+        // yields " a " when it ends.
+        previous[0] = previous[1];
+        previous[1] = codepoint;
+    }
+    if (inWord) {
+        visit(HashTrigram(previous[0], previous[1], ' '));
+        trigrams++;
+    }
+    return trigrams;
+}
+
+bool Validate(const MappedFile& file, LanguageModelHeader& header, std::string& error) {
+    if (file.size() < sizeof(header)) {
+        error = "profile file is truncated";
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    if (std::memcmp(header.magic, kLanguageModelMagic, sizeof(header.magic)) != 0) {
+        error = "not a language profile file";
+        return false;
+    }
+    if (header.version != kLanguageModelVersion) {
+        error = "unsupported profile version " + std::to_string(header.version);
+        return false;
+    }
+    if (header.languageCount == 0 || header.bucketCount == 0 ||
+        (header.bucketCount & (header.bucketCount - 1)) != 0) {
+        error = "profile has no languages or a bucket count that is not a power of two";
+        return false;
+    }
+    if (!(header.scale > 0) || !(header.temperature > 0)) {
+        error = "profile scale and temperature must be positive";
+        return false;
+    }
+
+    uint64_t expected = sizeof(header) + uint64_t(header.languageCount) * kLanguageCodeSize +
+                        uint64_t(header.bucketCount) * header.languageCount;
+    if (file.size() != expected) {
+        error = "profile size does not match its header";
+        return false;
+    }
+    return true;
+}
+
+std::string LanguageCode(const LoadedModel& model, size_t index) {
+    const char* code = model.codes + index * kLanguageCodeSize;
+    return std::string(code, strnlen(code, kLanguageCodeSize));
+}
+
+}
+
+class LanguageModel::Impl {
+public:
+    SnapshotCell<LoadedModel> model;
+};
+
+LanguageModel& LanguageModel::instance() {
+    static LanguageModel* model = new LanguageModel();
+    return *model;
+}
+
+LanguageModel::LanguageModel() : impl_(new Impl()) {}
+
+LanguageModel::~LanguageModel() {
+    delete impl_;
+}
+
+bool LanguageModel::load(const std::string& path, std::string& error) {
+    auto model = std::make_shared<LoadedModel>();
+    if (!model->file.open(path, error)) {
+        return false;
+    }
+    if (!Validate(model->file, model->header, error)) {
+        error = path + ": " + error;
+        return false;
+    }
+
+    const unsigned char* data = model->file.data() + sizeof(LanguageModelHeader);
+    model->codes = reinterpret_cast<const char*>(data);
+    model->weights = data + size_t(model->header.languageCount) * kLanguageCodeSize;
+
+    impl_->model.publish(std::move(model));
+    return true;
+}
+
+bool LanguageModel::isLoaded() const {
+    return impl_->model.load()->weights != nullptr;
+}
+
+std::vector<std::string> LanguageModel::languages() const {
+    std::shared_ptr<const LoadedModel> model = impl_->model.load();
+    std::vector<std::string> codes;
+    if (!model->weights) {
+        return codes;
+    }
+    for (size_t i = 0; i < model->header.languageCount; i++) {
+        codes.push_back(LanguageCode(*model, i));
+    }
+    return codes;
+}
+
+std::vector<LanguageGuess> LanguageModel::identify(const std::string& text, size_t maxResults) const {
+    std::vector<LanguageGuess> guesses;
+    std::shared_ptr<const LoadedModel> model = impl_->model.load();
+    if (!model->weights || maxResults == 0) {
+        return guesses;
+    }
+
+    const size_t languageCount = model->header.languageCount;
+    const uint32_t bucketMask = model->header.bucketCount - 1;
+    const uint8_t* weights = model->weights;
+
+    std::vector<uint32_t> costs(languageCount, 0);
+    uint32_t* totals = costs.data();
+    size_t trigrams = ForEachTrigram(text, [&](uint32_t hash) {
+        const uint8_t* row = weights + size_t(hash & bucketMask) * languageCount;
+        for (size_t i = 0; i < languageCount; i++) {
+            totals[i] += row[i];
+        }
+    });
+    if (trigrams == 0) {
+        return guesses;
+    }
+
+    // Softmax over log-likelihoods, shifted by the best one so the largest
+    // exponent is 0.
+    const double factor = model->header.scale / model->header.temperature;
+    uint32_t best = *std::min_element(costs.begin(), costs.end());
+    std::vector<double> likelihoods(languageCount);
+    double sum = 0;
+    for (size_t i = 0; i < languageCount; i++) {
+        likelihoods[i] = std::exp(-double(costs[i] - best) * factor);
+        sum += likelihoods[i];
+    }
+
+    std::vector<size_t> order(languageCount);
+    for (size_t i = 0; i < languageCount; i++) {
+        order[i] = i;
+    }
+    size_t count = std::min(maxResults, languageCount);
+    std::partial_sort(order.begin(), order.begin() + count, order.end(),
+                      [&](size_t a, size_t b) { return costs[a] < costs[b]; });
+
+    for (size_t i = 0; i < count; i++) {
+        guesses.push_back({LanguageCode(*model, order[i]), likelihoods[order[i]] / sum});
+    }
+    return guesses;
+}
+
+}
@@ -0,0 +1,71 @@
+#ifndef LANGUAGE_MODEL_H
+#define LANGUAGE_MODEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace speechly {
+
+// Profile file layout, little-endian, as written by
+// speechly-clone/scripts/build-language-profiles.js:
+//
+//   LanguageModelHeader
+//   char[16] x languageCount        NUL-padded language codes
+//   uint8_t  x bucketCount x languageCount
+//
+// The weights are one row per trigram hash bucket with a column per
+// language: -log P(bucket | language) in units of scale. Rows are read in
+// place from the mapping, so loading costs a header check and no parsing.
+struct LanguageModelHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t languageCount;
+    uint32_t bucketCount;
+    float scale;
+    // Softmax temperature fitted on held-out text so confidences track
+    // accuracy instead of the naive Bayes overconfidence.
+    float temperature;
+    uint32_t reserved[2];
+};
+
+const char kLanguageModelMagic[4] = {'S', 'L', 'N', 'G'};
+const uint32_t kLanguageModelVersion = 1;
+const size_t kLanguageCodeSize = 16;
+
+struct LanguageGuess {
+    std::string language;
+    double confidence;
+};
+
+// Character-trigram language identification over hashed trigram buckets.
+// Words are case-folded and padded with a space on each side, so "le"
+// contributes " le" and "le ". Each trigram adds one contiguous row of
+// weights to the per-language totals, a loop compilers vectorize.
+class LanguageModel {
+public:
+    static LanguageModel& instance();
+
+    // Maps the profile file and publishes it. A failed load keeps the
+    // previous model and reports why in error.
+    bool load(const std::string& path, std::string& error);
+    bool isLoaded() const;
+    std::vector<std::string> languages() const;
+
+    // The most likely languages, best first. Confidences are over every
+    // language in the model, so they sum to at most 1 across the results.
+    // Empty if no model is loaded or text has no letters.
+    std::vector<LanguageGuess> identify(const std::string& text, size_t maxResults) const;
+
+private:
+    LanguageModel();
+    ~LanguageModel();
+
+    class Impl;
+    Impl* impl_;
+};
+
+}
+
+#endif
@@ -0,0 +1,150 @@
+#include "latency_metrics.h"
+
+namespace speechly {
+
+namespace {
+
+const size_t kStageCount = static_cast<size_t>(LatencyStage::Count);
+
+// Values above 2^36us all land in the last bucket.
+const int kMaxExponent = 35;
+
+LatencyHistogram g_histograms[kStageCount];
+
+int HighestBit(uint64_t value) {
+    int bit = 0;
+    while (value >>= 1) {
+        bit++;
+    }
+    return bit;
+}
+
+size_t BucketFor(uint64_t micros) {
+    if (micros < 16) {
+        return static_cast<size_t>(micros);
+    }
+
+    int exponent = HighestBit(micros);
+    if (exponent > kMaxExponent) {
+        return LatencyHistogram::kBuckets - 1;
+    }
+    return 16 + static_cast<size_t>(exponent - 4) * 8 + static_cast<size_t>((micros >> (exponent - 3)) & 7);
+}
+
+uint64_t BucketUpperBound(size_t bucket) {
+    if (bucket < 16) {
+        return bucket;
+    }
+
+    int exponent = static_cast<int>((bucket - 16) / 8) + 4;
+    uint64_t width = 1ull << (exponent - 3);
+    uint64_t lower = (8 + (bucket - 16) % 8) * width;
+    return lower + width - 1;
+}
+
+}
+
+LatencyHistogram::LatencyHistogram() : max_(0) {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::record(uint64_t micros) {
+    buckets_[BucketFor(micros)].fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t seen = max_.load(std::memory_order_relaxed);
+    while (micros > seen && !max_.compare_exchange_weak(seen, micros, std::memory_order_relaxed)) {
+    }
+}
+
+LatencySummary LatencyHistogram::summarize() const {
+    uint64_t counts[kBuckets];
+    LatencySummary summary;
+
+    for (size_t i = 0; i < kBuckets; i++) {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        summary.count += counts[i];
+    }
+    summary.maxUs = max_.load(std::memory_order_relaxed);
+
+    if (summary.count == 0) {
+        return summary;
+    }
+
+    // Nearest-rank percentiles, reported as the top of the bucket they fall
+    // in, but never above the largest sample actually seen.
+    const struct {
+        uint64_t permille;
+        uint64_t* result;
+    } targets[] = {
+        {500, &summary.p50Us}, {950, &summary.p95Us}, {990, &summary.p99Us}
+    };
+
+    uint64_t cumulative = 0;
+    size_t target = 0;
+    for (size_t i = 0; i < kBuckets && target < 3; i++) {
+        cumulative += counts[i];
+        while (target < 3 && cumulative * 1000 >= targets[target].permille * summary.count) {
+            uint64_t bound = BucketUpperBound(i);
+            *targets[target].result = bound < summary.maxUs ? bound : summary.maxUs;
+            target++;
+        }
+    }
+
+    return summary;
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    max_.store(0, std::memory_order_relaxed);
+}
+
+const char* LatencyStageName(LatencyStage stage) {
+    switch (stage) {
+        case LatencyStage::EventReceipt:
+            return "eventReceipt";
+        case LatencyStage::DetectorDecision:
+            return "detectorDecision";
+        case LatencyStage::TsfEnqueue:
+            return "tsfEnqueue";
+        case LatencyStage::InjectionEnqueue:
+            return "injectionEnqueue";
+        case LatencyStage::JsDispatch:
+            return "jsDispatch";
+        case LatencyStage::ClipboardWrite:
+            return "clipboardWrite";
+        case LatencyStage::PasteSimulate:
+            return "pasteSimulate";
+        case LatencyStage::WindowInfo:
+            return "windowInfo";
+        default:
+            return "unknown";
+    }
+}
+
+void RecordLatency(LatencyStage stage, std::chrono::steady_clock::duration elapsed) {
+    size_t index = static_cast<size_t>(stage);
+    if (index >= kStageCount) {
+        return;
+    }
+
+    // Event times from the OS can land a little after our own clock read.
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    g_histograms[index].record(micros > 0 ? static_cast<uint64_t>(micros) : 0);
+}
+
+LatencySummary GetLatencySummary(LatencyStage stage) {
+    size_t index = static_cast<size_t>(stage);
+    return index < kStageCount ? g_histograms[index].summarize() : LatencySummary();
+}
+
+void ResetLatencyMetrics() {
+    for (auto& histogram : g_histograms) {
+        histogram.reset();
+    }
+}
+
+}
@@ -0,0 +1,37 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace speechly {
+
+// A read-only memory mapping of a whole file. Pages are loaded by the OS
+// on first touch and shared with any other process mapping the same file.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    // Maps path, replacing any previous mapping. On failure error says why
+    // and the object is left empty.
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    const unsigned char* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+private:
+    const unsigned char* data_{nullptr};
+    size_t size_{0};
+#ifdef _WIN32
+    void* mapping_{nullptr};
+#endif
+};
+
+}
+
+#endif
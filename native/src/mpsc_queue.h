@@ -0,0 +1,86 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace speechly {
+
+// Bounded multi-producer/single-consumer ring (Vyukov's sequenced cells).
+// Producers claim a cell with one CAS and never block; a full queue rejects
+// the item. Items are filled and consumed in place, so cells keep their
+// buffers between uses and steady-state traffic does not allocate.
+template <typename T, size_t Capacity>
+class MpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "MpscQueue capacity must be a power of two");
+
+public:
+    MpscQueue() : tail_(0), head_(0) {
+        for (size_t i = 0; i < Capacity; i++) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    template <typename Fill>
+    bool tryPushWith(Fill&& fill) {
+        size_t position = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[position & (Capacity - 1)];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t distance = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+            if (distance == 0) {
+                if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    fill(cell.value);
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (distance < 0) {
+                return false;
+            } else {
+                position = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer thread only. An item whose producer has claimed but not yet
+    // filled its cell is not visible, and neither is anything behind it.
+    template <typename Consume>
+    bool tryConsume(Consume&& consume) {
+        size_t position = head_.load(std::memory_order_relaxed);
+        Cell& cell = cells_[position & (Capacity - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) != position + 1) {
+            return false;
+        }
+
+        consume(cell.value);
+        cell.sequence.store(position + Capacity, std::memory_order_release);
+        head_.store(position + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool empty() const {
+        size_t position = head_.load(std::memory_order_relaxed);
+        return cells_[position & (Capacity - 1)].sequence.load(std::memory_order_acquire) != position + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    alignas(64) std::atomic<size_t> tail_;
+    alignas(64) std::atomic<size_t> head_;
+    std::array<Cell, Capacity> cells_;
+};
+
+}
+
+#endif
@@ -0,0 +1,183 @@
+#include "phrase_rewriter.h"
+#include "case_fold.h"
+#include "char_class.h"
+#include "utf8.h"
+#include <mutex>
+
+namespace speechly {
+
+namespace {
+
+// Calls visit(start, end, folded, spaced) for each word or punctuation
+// character of text, where spaced says whether whitespace came before it.
+template <typename Visit>
+void ForEachToken(const std::string& text, std::string& folded, Visit visit) {
+    size_t pos = 0;
+    bool spaced = false;
+    while (pos < text.size()) {
+        size_t start = pos;
+        uint32_t codepoint = DecodeUtf8(text, pos);
+        if (IsSpaceCodepoint(codepoint)) {
+            spaced = true;
+            continue;
+        }
+
+        folded.clear();
+        if (!IsWordCodepoint(codepoint)) {
+            // Punctuation is a token of its own. Typographic apostrophes
+            // are what macOS and phones produce.
+            AppendUtf8(folded, codepoint == 0x2019 ? '\'' : codepoint);
+        } else {
+            AppendAccentFolded(folded, codepoint);
+            while (pos < text.size()) {
+                size_t next = pos;
+                codepoint = DecodeUtf8(text, next);
+                if (!IsWordCodepoint(codepoint)) {
+                    break;
+                }
+                AppendAccentFolded(folded, codepoint);
+                pos = next;
+            }
+        }
+
+        visit(start, pos, folded, spaced);
+        spaced = false;
+    }
+}
+
+struct Span {
+    size_t start;
+    size_t end;
+    int32_t value;
+};
+
+}
+
+size_t PhraseDictionary::compile(const std::vector<std::pair<std::string, std::string>>& replacements) {
+    vocabulary_.clear();
+    edges_.clear();
+    terminals_.assign(1, -1);
+    values_.clear();
+
+    std::string folded;
+    for (const auto& replacement : replacements) {
+        int32_t node = 0;
+        bool first = true;
+        ForEachToken(replacement.first, folded, [&](size_t, size_t, const std::string& word, bool spaced) {
+            auto inserted = vocabulary_.emplace(word, static_cast<uint32_t>(vocabulary_.size()));
+            auto edge = edges_.emplace(edgeKey(node, inserted.first->second, spaced && !first),
+                                       static_cast<int32_t>(terminals_.size()));
+            if (edge.second) {
+                terminals_.push_back(-1);
+            }
+            node = edge.first->second;
+            first = false;
+        });
+
+        if (node != 0 && terminals_[node] < 0) {
+            terminals_[node] = static_cast<int32_t>(values_.size());
+            values_.push_back(replacement.second);
+        }
+    }
+
+    return values_.size();
+}
+
+std::string PhraseDictionary::rewrite(const std::string& text) const {
+    if (values_.empty()) {
+        return text;
+    }
+
+    // Word ids of the text; words the dictionary never uses cannot continue
+    // any phrase and get no id.
+    struct Token {
+        size_t start;
+        size_t end;
+        const uint32_t* word;
+        bool spaced;
+    };
+    std::vector<Token> tokens;
+    std::string folded;
+    ForEachToken(text, folded, [&](size_t start, size_t end, const std::string& word, bool spaced) {
+        auto it = vocabulary_.find(word);
+        tokens.push_back({start, end, it == vocabulary_.end() ? nullptr : &it->second, spaced});
+    });
+
+    std::vector<Span> spans;
+    size_t length = text.size();
+    for (size_t i = 0; i < tokens.size();) {
+        int32_t node = 0;
+        int32_t value = -1;
+        size_t last = i;
+        for (size_t j = i; j < tokens.size() && tokens[j].word; j++) {
+            auto edge = edges_.find(edgeKey(node, *tokens[j].word, tokens[j].spaced && j != i));
+            if (edge == edges_.end()) {
+                break;
+            }
+            node = edge->second;
+            if (terminals_[node] >= 0) {
+                value = terminals_[node];
+                last = j;
+            }
+        }
+
+        if (value < 0) {
+            i++;
+            continue;
+        }
+
+        spans.push_back({tokens[i].start, tokens[last].end, value});
+        length = length - (tokens[last].end - tokens[i].start) + values_[value].size();
+        i = last + 1;
+    }
+
+    if (spans.empty()) {
+        return text;
+    }
+
+    std::string result;
+    result.reserve(length);
+    size_t cursor = 0;
+    for (const Span& span : spans) {
+        result.append(text, cursor, span.start - cursor);
+        result += values_[span.value];
+        cursor = span.end;
+    }
+    result.append(text, cursor, std::string::npos);
+    return result;
+}
+
+class PhraseRewriter::Impl {
+public:
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<const PhraseDictionary>> dictionaries;
+};
+
+PhraseRewriter& PhraseRewriter::instance() {
+    static PhraseRewriter* rewriter = new PhraseRewriter();
+    return *rewriter;
+}
+
+PhraseRewriter::PhraseRewriter() : impl_(new Impl()) {}
+
+PhraseRewriter::~PhraseRewriter() {
+    delete impl_;
+}
+
+size_t PhraseRewriter::compile(const std::string& contextId,
+                               const std::vector<std::pair<std::string, std::string>>& replacements) {
+    auto dictionary = std::make_shared<PhraseDictionary>();
+    size_t phrases = dictionary->compile(replacements);
+
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    impl_->dictionaries[contextId] = std::move(dictionary);
+    return phrases;
+}
+
+std::shared_ptr<const PhraseDictionary> PhraseRewriter::find(const std::string& contextId) const {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    auto it = impl_->dictionaries.find(contextId);
+    return it == impl_->dictionaries.end() ? nullptr : it->second;
+}
+
+}
@@ -0,0 +1,64 @@
+#ifndef PHRASE_REWRITER_H
+#define PHRASE_REWRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace speechly {
+
+// One context's replacements from context-dictionaries.json compiled into a
+// trie over words, so "point virgule" and "point" share a path and the
+// longest phrase wins. Words are compared case- and accent-insensitively
+// ("Égal" matches "egal"), any whitespace run between two words matches any
+// other, and a phrase only matches whole words.
+class PhraseDictionary {
+public:
+    // Later duplicates of a phrase (after folding) are ignored, as are
+    // phrases with no words. Returns the number of phrases compiled.
+    size_t compile(const std::vector<std::pair<std::string, std::string>>& replacements);
+
+    // Replaces every phrase in one left-to-right pass, leftmost-longest.
+    // Replacement values are never rescanned.
+    std::string rewrite(const std::string& text) const;
+
+    size_t size() const { return values_.size(); }
+
+private:
+    // Edges are keyed by node, word id and whether whitespace preceded the
+    // word, so "d'oeil" and "d' oeil" stay different phrases.
+    static uint64_t edgeKey(int32_t node, uint32_t word, bool spaced) {
+        return (static_cast<uint64_t>(node) << 32) | (static_cast<uint64_t>(word) << 1) | (spaced ? 1 : 0);
+    }
+
+    std::unordered_map<std::string, uint32_t> vocabulary_;
+    std::unordered_map<uint64_t, int32_t> edges_;
+    std::vector<int32_t> terminals_;
+    std::vector<std::string> values_;
+};
+
+// Compiled dictionaries by context id. Compiling a context replaces its
+// dictionary; rewrites already running keep the one they started with.
+class PhraseRewriter {
+public:
+    static PhraseRewriter& instance();
+
+    size_t compile(const std::string& contextId,
+                   const std::vector<std::pair<std::string, std::string>>& replacements);
+    std::shared_ptr<const PhraseDictionary> find(const std::string& contextId) const;
+
+private:
+    PhraseRewriter();
+    ~PhraseRewriter();
+
+    class Impl;
+    Impl* impl_;
+};
+
+}
+
+#endif
@@ -0,0 +1,198 @@
+#include "script_detector.h"
+#include "case_fold.h"
+#include "char_class.h"
+#include "snapshot_cell.h"
+#include "utf8.h"
+#include <algorithm>
+#include <iterator>
+#include <unordered_map>
+
+namespace speechly {
+
+namespace {
+
+const char* const kScriptNames[] = {
+    "cyrillic", "arabic", "hebrew", "chinese", "japanese_hiragana", "japanese_katakana", "korean",
+    "thai", "devanagari", "bengali", "gujarati", "gurmukhi", "tamil", "telugu", "kannada",
+    "malayalam", "sinhala", "myanmar", "khmer", "lao", "georgian", "armenian", "ethiopic",
+    "greek", "odia"
+};
+
+struct ScriptRange {
+    uint32_t first;
+    uint32_t last;
+    Script script;
+};
+
+// Every range starts and ends on a multiple of 16, so the script of any BMP
+// character is one lookup in a table of 16-character blocks.
+const ScriptRange kScriptRanges[] = {
+    {0x0370, 0x03FF, Script::Greek},
+    {0x0400, 0x04FF, Script::Cyrillic},
+    {0x0530, 0x058F, Script::Armenian},
+    {0x0590, 0x05FF, Script::Hebrew},
+    {0x0600, 0x06FF, Script::Arabic},
+    {0x0750, 0x077F, Script::Arabic},
+    {0x0900, 0x097F, Script::Devanagari},
+    {0x0980, 0x09FF, Script::Bengali},
+    {0x0A00, 0x0A7F, Script::Gurmukhi},
+    {0x0A80, 0x0AFF, Script::Gujarati},
+    {0x0B00, 0x0B7F, Script::Odia},
+    {0x0B80, 0x0BFF, Script::Tamil},
+    {0x0C00, 0x0C7F, Script::Telugu},
+    {0x0C80, 0x0CFF, Script::Kannada},
+    {0x0D00, 0x0D7F, Script::Malayalam},
+    {0x0D80, 0x0DFF, Script::Sinhala},
+    {0x0E00, 0x0E7F, Script::Thai},
+    {0x0E80, 0x0EFF, Script::Lao},
+    {0x1000, 0x109F, Script::Myanmar},
+    {0x10A0, 0x10FF, Script::Georgian},
+    {0x1100, 0x11FF, Script::Korean},
+    {0x1200, 0x137F, Script::Ethiopic},
+    {0x1780, 0x17FF, Script::Khmer},
+    {0x3040, 0x309F, Script::Hiragana},
+    {0x30A0, 0x30FF, Script::Katakana},
+    {0x3400, 0x4DBF, Script::Chinese},
+    {0x4E00, 0x9FFF, Script::Chinese},
+    {0xAC00, 0xD7AF, Script::Korean},
+};
+
+const uint8_t kNoScript = 0xFF;
+
+struct ScriptBlocks {
+    uint8_t blocks[0x10000 >> 4];
+
+    ScriptBlocks() {
+        std::fill(std::begin(blocks), std::end(blocks), kNoScript);
+        for (const ScriptRange& range : kScriptRanges) {
+            for (uint32_t block = range.first >> 4; block <= range.last >> 4; block++) {
+                blocks[block] = static_cast<uint8_t>(range.script);
+            }
+        }
+    }
+};
+
+const ScriptBlocks& GetScriptBlocks() {
+    static const ScriptBlocks* blocks = new ScriptBlocks();
+    return *blocks;
+}
+
+// Words map to the set of hints listing them, one bit per hint.
+struct HintTable {
+    std::vector<LanguageHint> hints;
+    std::unordered_map<std::string, uint64_t> words;
+    size_t longestWord{0};
+};
+
+const size_t kMaxHints = 64;
+
+}
+
+const char* ScriptName(Script script) {
+    size_t index = static_cast<size_t>(script);
+    return index < static_cast<size_t>(Script::Count) ? kScriptNames[index] : "unknown";
+}
+
+class ScriptDetector::Impl {
+public:
+    SnapshotCell<HintTable> hints;
+};
+
+ScriptDetector& ScriptDetector::instance() {
+    static ScriptDetector* detector = new ScriptDetector();
+    return *detector;
+}
+
+ScriptDetector::ScriptDetector() : impl_(new Impl()) {}
+
+ScriptDetector::~ScriptDetector() {
+    delete impl_;
+}
+
+size_t ScriptDetector::setHints(std::vector<LanguageHint> hints) {
+    auto table = std::make_shared<HintTable>();
+    if (hints.size() > kMaxHints) {
+        hints.resize(kMaxHints);
+    }
+    table->hints = std::move(hints);
+
+    for (size_t i = 0; i < table->hints.size(); i++) {
+        for (const auto& word : table->hints[i].words) {
+            std::string folded = FoldUtf8(word);
+            table->longestWord = std::max(table->longestWord, folded.size());
+            table->words[folded] |= 1ull << i;
+        }
+    }
+
+    size_t words = table->words.size();
+    impl_->hints.publish(std::move(table));
+    return words;
+}
+
+void ScriptDetector::analyze(const std::string& text, ScriptProfile& profile) const {
+    std::shared_ptr<const HintTable> table = impl_->hints.load();
+    const ScriptBlocks& blocks = GetScriptBlocks();
+
+    std::fill(std::begin(profile.scripts), std::end(profile.scripts), 0);
+    profile.hintScores.assign(table->hints.size(), 0.0);
+
+    // The current word, folded, until it grows longer than any hint word.
+    std::string word;
+    bool inWord = false;
+    bool tooLong = false;
+
+    auto endWord = [&]() {
+        inWord = false;
+        if (tooLong) {
+            return;
+        }
+        auto it = table->words.find(word);
+        if (it == table->words.end()) {
+            return;
+        }
+        uint64_t mask = it->second;
+        for (size_t i = 0; mask; i++, mask >>= 1) {
+            if (mask & 1) {
+                profile.hintScores[i] += table->hints[i].weight;
+            }
+        }
+    };
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        uint32_t codepoint = static_cast<unsigned char>(text[pos]);
+        if (codepoint < 0x80) {
+            pos++;
+        } else {
+            codepoint = DecodeUtf8(text, pos);
+            if (codepoint < 0x10000) {
+                uint8_t script = blocks.blocks[codepoint >> 4];
+                if (script != kNoScript) {
+                    profile.scripts[script]++;
+                }
+            }
+        }
+
+        if (!IsWordCodepoint(codepoint)) {
+            if (inWord) {
+                endWord();
+            }
+            continue;
+        }
+
+        if (!inWord) {
+            inWord = true;
+            tooLong = false;
+            word.clear();
+        }
+        if (!tooLong) {
+            AppendUtf8(word, FoldCase(codepoint));
+            tooLong = word.size() > table->longestWord;
+        }
+    }
+    if (inWord) {
+        endWord();
+    }
+}
+
+}
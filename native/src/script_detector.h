@@ -0,0 +1,80 @@
+#ifndef SCRIPT_DETECTOR_H
+#define SCRIPT_DETECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace speechly {
+
+// The non-Latin scripts language-detector.ts recognizes, in the same order
+// as its SCRIPT_PATTERNS so counts can be read by index.
+enum class Script : uint8_t {
+    Cyrillic,
+    Arabic,
+    Hebrew,
+    Chinese,
+    Hiragana,
+    Katakana,
+    Korean,
+    Thai,
+    Devanagari,
+    Bengali,
+    Gujarati,
+    Gurmukhi,
+    Tamil,
+    Telugu,
+    Kannada,
+    Malayalam,
+    Sinhala,
+    Myanmar,
+    Khmer,
+    Lao,
+    Georgian,
+    Armenian,
+    Ethiopic,
+    Greek,
+    Odia,
+    Count
+};
+
+const char* ScriptName(Script script);
+
+// A stop-word list for one Latin-script language. Every occurrence of one
+// of its words, compared case-insensitively as a whole word, adds weight.
+struct LanguageHint {
+    std::string language;
+    std::vector<std::string> words;
+    double weight;
+};
+
+struct ScriptProfile {
+    uint32_t scripts[static_cast<size_t>(Script::Count)];
+    std::vector<double> hintScores;
+};
+
+// Bins every character of a text by script and scores the language hints in
+// the same pass: the script is a table lookup per character and each word
+// costs one hash lookup, however many hints there are.
+class ScriptDetector {
+public:
+    static ScriptDetector& instance();
+
+    // Replaces the hints; returns the number of distinct words.
+    size_t setHints(std::vector<LanguageHint> hints);
+
+    // hintScores is indexed like the hints last set.
+    void analyze(const std::string& text, ScriptProfile& profile) const;
+
+private:
+    ScriptDetector();
+    ~ScriptDetector();
+
+    class Impl;
+    Impl* impl_;
+};
+
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef SNAPSHOT_CELL_H
+#define SNAPSHOT_CELL_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace speechly {
+
+// Copy-on-write holder for data read on a hot path and rarely replaced.
+// Writers publish a new immutable value under a mutex. Each reader keeps a
+// Reader cache and takes the mutex only when the version has moved, so a
+// steady-state read is a single atomic load.
+template <typename T>
+class SnapshotCell {
+public:
+    struct Reader {
+        std::shared_ptr<const T> value;
+        uint64_t version{~0ull};
+    };
+
+    SnapshotCell() : current_(std::make_shared<const T>()), version_(0) {}
+
+    void publish(std::shared_ptr<const T> value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        current_ = std::move(value);
+        version_.fetch_add(1, std::memory_order_release);
+    }
+
+    std::shared_ptr<const T> load() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return current_;
+    }
+
+    const T& read(Reader& reader) const {
+        uint64_t version = version_.load(std::memory_order_acquire);
+        if (version != reader.version) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            reader.value = current_;
+            reader.version = version_.load(std::memory_order_relaxed);
+        }
+        return *reader.value;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::shared_ptr<const T> current_;
+    std::atomic<uint64_t> version_;
+};
+
+}
+
+#endif
@@ -0,0 +1,171 @@
+#include "snippet_matcher.h"
+#include "case_fold.h"
+#include "snapshot_cell.h"
+#include <algorithm>
+#include <deque>
+#include <limits>
+
+namespace speechly {
+
+namespace {
+
+size_t Utf16Length(const std::string& text) {
+    size_t units = 0;
+    for (unsigned char byte : text) {
+        units += Utf16UnitsForByte(byte);
+    }
+    return units;
+}
+
+// Leftmost start wins, then the longer match, then the earlier entry.
+template <typename Candidate>
+bool Precedes(const Candidate& a, const Candidate& b) {
+    if (a.startByte != b.startByte) {
+        return a.startByte < b.startByte;
+    }
+    if (a.match.end != b.match.end) {
+        return a.match.end > b.match.end;
+    }
+    return a.match.entry < b.match.entry;
+}
+
+// Keeps candidates ordered by start with only the best match for each
+// start, since the others can never be committed. New matches start no
+// earlier than the horizon, so the ordered part is at most one pattern long.
+template <typename Candidate>
+void Insert(std::deque<Candidate>& candidates, const Candidate& candidate) {
+    auto it = std::lower_bound(candidates.begin(), candidates.end(), candidate,
+                               [](const Candidate& a, const Candidate& b) { return a.startByte < b.startByte; });
+    if (it != candidates.end() && it->startByte == candidate.startByte) {
+        if (Precedes(candidate, *it)) {
+            *it = candidate;
+        }
+        return;
+    }
+    candidates.insert(it, candidate);
+}
+
+// Commits from the front for as long as candidates start before horizon: no
+// later text can produce a match starting there, so the front is final.
+// Anything that starts inside a committed match is dropped.
+template <typename Candidate>
+void Resolve(std::deque<Candidate>& candidates, size_t& committedEnd, size_t horizonByte,
+             std::vector<SnippetMatch>& committed) {
+    while (!candidates.empty() && candidates.front().startByte < horizonByte) {
+        const Candidate& next = candidates.front();
+        if (next.match.start >= committedEnd) {
+            committed.push_back(next.match);
+            committedEnd = next.match.end;
+        }
+        candidates.pop_front();
+    }
+}
+
+}
+
+SnippetStream::SnippetStream(std::shared_ptr<const SnippetSet> set) {
+    reset(std::move(set));
+}
+
+void SnippetStream::reset(std::shared_ptr<const SnippetSet> set) {
+    set_ = set ? std::move(set) : std::make_shared<const SnippetSet>();
+    state_ = AhoCorasick::kRootState;
+    byteLength_ = 0;
+    utf16Length_ = 0;
+    committedEnd_ = 0;
+    candidates_.clear();
+}
+
+void SnippetStream::append(const std::string& delta, std::vector<SnippetMatch>& committed) {
+    const AhoCorasick& automaton = set_->automaton;
+    if (automaton.empty()) {
+        utf16Length_ += Utf16Length(delta);
+        byteLength_ += delta.size();
+        return;
+    }
+
+    folded_.clear();
+    AppendFoldedUtf8(folded_, delta.data(), delta.size());
+
+    for (unsigned char byte : folded_) {
+        utf16Length_ += Utf16UnitsForByte(byte);
+        byteLength_++;
+        state_ = automaton.step(state_, byte);
+
+        automaton.forEachMatch(state_, [&](int32_t id) {
+            size_t start = utf16Length_ - set_->patternUtf16Lengths[id];
+            if (start >= committedEnd_) {
+                Insert(candidates_, Candidate{{set_->patternEntries[id], start, utf16Length_},
+                                              byteLength_ - automaton.patternLength(id)});
+            }
+        });
+
+        Resolve(candidates_, committedEnd_, byteLength_ - automaton.depth(state_), committed);
+    }
+}
+
+void SnippetStream::finish(std::vector<SnippetMatch>& committed) {
+    Resolve(candidates_, committedEnd_, std::numeric_limits<size_t>::max(), committed);
+    state_ = AhoCorasick::kRootState;
+}
+
+void SnippetStream::pending(std::vector<SnippetMatch>& out) const {
+    size_t committedEnd = committedEnd_;
+    for (const auto& candidate : candidates_) {
+        if (candidate.match.start >= committedEnd) {
+            out.push_back(candidate.match);
+            committedEnd = candidate.match.end;
+        }
+    }
+}
+
+class SnippetMatcher::Impl {
+public:
+    SnapshotCell<SnippetSet> compiled;
+};
+
+SnippetMatcher& SnippetMatcher::instance() {
+    static SnippetMatcher* matcher = new SnippetMatcher();
+    return *matcher;
+}
+
+SnippetMatcher::SnippetMatcher() : impl_(new Impl()) {}
+
+SnippetMatcher::~SnippetMatcher() {
+    delete impl_;
+}
+
+size_t SnippetMatcher::compile(std::vector<SnippetEntry> entries) {
+    auto set = std::make_shared<SnippetSet>();
+    set->entries = std::move(entries);
+
+    for (size_t i = 0; i < set->entries.size(); i++) {
+        for (const auto& trigger : set->entries[i].triggers) {
+            if (trigger.empty()) {
+                continue;
+            }
+            set->automaton.addPattern(FoldUtf8(trigger));
+            set->patternEntries.push_back(static_cast<int32_t>(i));
+            set->patternUtf16Lengths.push_back(static_cast<uint32_t>(Utf16Length(trigger)));
+        }
+    }
+    set->automaton.build();
+
+    size_t patterns = set->automaton.patternCount();
+    impl_->compiled.publish(std::move(set));
+    return patterns;
+}
+
+std::shared_ptr<const SnippetSet> SnippetMatcher::current() const {
+    return impl_->compiled.load();
+}
+
+std::vector<SnippetMatch> SnippetMatcher::match(const std::string& text) const {
+    std::vector<SnippetMatch> matches;
+    SnippetStream stream(current());
+    stream.append(text, matches);
+    stream.finish(matches);
+    return matches;
+}
+
+}
@@ -0,0 +1,100 @@
+#ifndef SNIPPET_MATCHER_H
+#define SNIPPET_MATCHER_H
+
+#include "aho_corasick.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace speechly {
+
+// One snippet or dictionary entry: any of its triggers is replaced by value.
+struct SnippetEntry {
+    std::string id;
+    std::vector<std::string> triggers;
+    std::string value;
+};
+
+// Every trigger of every entry in one case-folded automaton. Immutable once
+// built, so streams can keep matching against it while a newer set is
+// compiled.
+struct SnippetSet {
+    std::vector<SnippetEntry> entries;
+    AhoCorasick automaton;
+    std::vector<int32_t> patternEntries;
+    std::vector<uint32_t> patternUtf16Lengths;
+};
+
+// A trigger occurrence in UTF-16 code units, the offsets JS strings use.
+struct SnippetMatch {
+    int32_t entry;
+    size_t start;
+    size_t end;
+};
+
+// Matches text that arrives in pieces, e.g. interim speech results, at a
+// cost proportional to each piece. The automaton state is carried between
+// calls, and a match is committed only once no later text can produce a
+// match that starts at or before it: leftmost-longest, exactly as if the
+// whole text had been scanned at once. Matches still open to a longer
+// alternative are reported separately as pending.
+class SnippetStream {
+public:
+    explicit SnippetStream(std::shared_ptr<const SnippetSet> set);
+
+    // Appends newly committed matches to committed.
+    void append(const std::string& delta, std::vector<SnippetMatch>& committed);
+
+    // Ends the text: every pending match is decided and committed.
+    void finish(std::vector<SnippetMatch>& committed);
+
+    // How the undecided tail resolves if the text ended now.
+    void pending(std::vector<SnippetMatch>& out) const;
+
+    // Starts over at offset 0 against set, usually the latest compiled one.
+    void reset(std::shared_ptr<const SnippetSet> set);
+
+    const SnippetSet& set() const { return *set_; }
+    size_t length() const { return utf16Length_; }
+
+private:
+    struct Candidate {
+        SnippetMatch match;
+        size_t startByte;
+    };
+
+    std::shared_ptr<const SnippetSet> set_;
+    int32_t state_;
+    size_t byteLength_;
+    size_t utf16Length_;
+    size_t committedEnd_;
+    std::deque<Candidate> candidates_;
+    std::string folded_;
+};
+
+// The set the app's active snippets compile to. compile() publishes a new
+// set without disturbing streams that are still using the previous one.
+class SnippetMatcher {
+public:
+    static SnippetMatcher& instance();
+
+    size_t compile(std::vector<SnippetEntry> entries);
+    std::shared_ptr<const SnippetSet> current() const;
+
+    // One-shot leftmost-longest matching of a complete text.
+    std::vector<SnippetMatch> match(const std::string& text) const;
+
+private:
+    SnippetMatcher();
+    ~SnippetMatcher();
+
+    class Impl;
+    Impl* impl_;
+};
+
+}
+
+#endif
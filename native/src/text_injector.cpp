@@ -14,7 +14,8 @@ public:
 TextInjector::TextInjector() : impl_(new Impl()), typingDelay_(5) {}
 TextInjector::~TextInjector() { delete impl_; }
 
-InjectionResult TextInjector::injectText(const std::string& text, InjectionMethod method) {
+InjectionResult TextInjector::injectText(const std::string& text, InjectionMethod method,
+                                         const std::atomic<bool>* cancelled) {
     return {false, "Platform not supported"};
 }
 
@@ -46,7 +47,11 @@ bool InjectTextViaClipboard(const std::string& text) {
     return false;
 }
 
-bool InjectTextDirect(const std::string& text) {
+bool InjectTextDirect(const std::string& text, const std::atomic<bool>* cancelled) {
+    return false;
+}
+
+bool CanInjectDirect(const std::string& text) {
     return false;
 }
 
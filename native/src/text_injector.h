@@ -3,6 +3,7 @@
 
 #include <string>
 #include <cstdint>
+#include <atomic>
 
 namespace speechly {
 
@@ -15,6 +16,9 @@ enum class InjectionMethod {
 struct InjectionResult {
     bool success;
     std::string error;
+    // False when the method turned the text down before sending any input,
+    // so another method can still deliver it.
+    bool inputSent = true;
 };
 
 class TextInjector {
@@ -22,7 +26,8 @@ public:
     TextInjector();
     ~TextInjector();
 
-    InjectionResult injectText(const std::string& text, InjectionMethod method = InjectionMethod::Auto);
+    InjectionResult injectText(const std::string& text, InjectionMethod method = InjectionMethod::Auto,
+                               const std::atomic<bool>* cancelled = nullptr);
     InjectionResult injectTextWithDelay(const std::string& text, uint32_t delayMs);
     InjectionResult pasteFromClipboard();
     
@@ -39,7 +44,9 @@ private:
 };
 
 bool InjectTextViaClipboard(const std::string& text);
-bool InjectTextDirect(const std::string& text);
+bool InjectTextDirect(const std::string& text, const std::atomic<bool>* cancelled = nullptr);
+// Whether direct typing can produce every character of text as written.
+bool CanInjectDirect(const std::string& text);
 
 }
 
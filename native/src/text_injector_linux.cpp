@@ -1,6 +1,14 @@
 #ifdef __linux__
 
 #include "text_injector.h"
+#include "injection_strategy.h"
+#include "display_pool.h"
+#include "clipboard_owner.h"
+#include "typing_engine.h"
+#include "input_backend.h"
+#include "uinput_keyboard.h"
+#include "evdev_keys.h"
+#include "latency_metrics.h"
 #include <X11/Xlib.h>
 #include <X11/Xatom.h>
 #include <X11/extensions/XTest.h>
@@ -9,63 +17,34 @@
 #include <thread>
 #include <chrono>
 #include <cstdlib>
+#include <linux/input-event-codes.h>
 
 namespace speechly {
 
 class TextInjector::Impl {
 public:
-    Display* display{nullptr};
     std::string savedClipboard;
     bool clipboardSaved{false};
-    
-    Impl() {
-        display = XOpenDisplay(nullptr);
-    }
-    
-    ~Impl() {
-        if (display) {
-            XCloseDisplay(display);
-        }
-    }
 };
 
 TextInjector::TextInjector() : impl_(new Impl()), typingDelay_(5) {}
 
 TextInjector::~TextInjector() {
+    TypingEngine::instance().restoreKeymap();
     delete impl_;
 }
 
 bool TextInjector::setClipboardText(const std::string& text) {
-    if (!impl_->display) return false;
-    
-    FILE* pipe = popen("xclip -selection clipboard", "w");
-    if (!pipe) {
-        pipe = popen("xsel --clipboard --input", "w");
-    }
-    
-    if (!pipe) return false;
-    
-    fwrite(text.c_str(), 1, text.size(), pipe);
-    int result = pclose(pipe);
-    
-    return result == 0;
+    return ClipboardOwner::instance().setText(text);
 }
 
 std::string TextInjector::getClipboardText() {
-    FILE* pipe = popen("xclip -selection clipboard -o 2>/dev/null || xsel --clipboard --output 2>/dev/null", "r");
-    if (!pipe) return "";
-    
     std::string result;
-    char buffer[256];
-    while (fgets(buffer, sizeof(buffer), pipe)) {
-        result += buffer;
-    }
-    
-    pclose(pipe);
+    ClipboardOwner::instance().getText(result);
     return result;
 }
 
-static void SimulatePaste(Display* display) {
+static void SimulatePasteX11(Display* display) {
     if (!display) return;
     
     KeyCode ctrlKey = XKeysymToKeycode(display, XK_Control_L);
@@ -79,56 +58,60 @@ static void SimulatePaste(Display* display) {
     XFlush(display);
 }
 
-static void TypeCharacter(Display* display, const char* utf8Char) {
-    if (!display) return;
-    
-    KeySym keysym = XStringToKeysym(utf8Char);
-    if (keysym == NoSymbol) {
-        return;
-    }
+// The paste keystroke for whichever backend is active. The clipboard itself
+// stays with ClipboardOwner on either backend, which under Wayland reaches
+// XWayland clients and whatever the compositor bridges to them.
+static bool SimulatePaste() {
+    ScopedLatency latency(LatencyStage::PasteSimulate);
     
-    KeyCode keycode = XKeysymToKeycode(display, keysym);
-    if (keycode == 0) {
-        return;
+    if (GetInputBackend() == InputBackend::Evdev) {
+        uint16_t pasteKey;
+        return EvdevPasteKey(pasteKey) && UinputKeyboard::instance().pressChord({KEY_LEFTCTRL, pasteKey});
     }
     
-    int index = 0;
-    KeySym lower, upper;
-    XConvertCase(keysym, &lower, &upper);
-    bool needShift = (keysym == upper && lower != upper);
-    
-    if (needShift) {
-        KeyCode shiftKey = XKeysymToKeycode(display, XK_Shift_L);
-        XTestFakeKeyEvent(display, shiftKey, True, CurrentTime);
+    DisplayLease display = AcquireDisplay(DisplayAffinity::Injector);
+    if (!display) {
+        return false;
     }
     
-    XTestFakeKeyEvent(display, keycode, True, CurrentTime);
-    XTestFakeKeyEvent(display, keycode, False, CurrentTime);
-    
-    if (needShift) {
-        KeyCode shiftKey = XKeysymToKeycode(display, XK_Shift_L);
-        XTestFakeKeyEvent(display, shiftKey, False, CurrentTime);
+    SimulatePasteX11(display.get());
+    return true;
+}
+
+// The paste chord is refused rather than guessed on a layout whose V key
+// is unknown, which deserves its own message.
+static std::string PasteFailure(const char* otherwise) {
+    uint16_t pasteKey;
+    if (GetInputBackend() == InputBackend::Evdev && !EvdevPasteKey(pasteKey)) {
+        return "Paste shortcut is unknown for this keyboard layout";
     }
-    
-    XFlush(display);
+    return otherwise;
 }
 
-InjectionResult TextInjector::injectText(const std::string& text, InjectionMethod method) {
+InjectionResult TextInjector::injectText(const std::string& text, InjectionMethod method,
+                                         const std::atomic<bool>* cancelled) {
     if (text.empty()) {
         return {true, ""};
     }
     
-    if (!impl_->display) {
-        return {false, "No display connection"};
+    if (method == InjectionMethod::Auto) {
+        return InjectTextAdaptive(*this, text, cancelled);
     }
     
     if (method == InjectionMethod::Direct) {
-        bool success = InjectTextDirect(text);
+        if (!CanInjectDirect(text)) {
+            return {false, "Text cannot be typed on this keyboard layout", false};
+        }
+        
+        bool success = InjectTextDirect(text, cancelled);
+        if (!success && cancelled && *cancelled) {
+            return {false, "Injection cancelled"};
+        }
         return {success, success ? "" : "Failed to inject text directly"};
     }
     
     bool success = InjectTextViaClipboard(text);
-    return {success, success ? "" : "Failed to inject text via clipboard"};
+    return {success, success ? "" : PasteFailure("Failed to inject text via clipboard")};
 }
 
 InjectionResult TextInjector::injectTextWithDelay(const std::string& text, uint32_t delayMs) {
@@ -137,11 +120,9 @@ InjectionResult TextInjector::injectTextWithDelay(const std::string& text, uint3
 }
 
 InjectionResult TextInjector::pasteFromClipboard() {
-    if (!impl_->display) {
-        return {false, "No display connection"};
+    if (!SimulatePaste()) {
+        return {false, PasteFailure(GetInputBackend() == InputBackend::Evdev ? "No uinput device" : "No display connection")};
     }
-    
-    SimulatePaste(impl_->display);
     return {true, ""};
 }
 
@@ -154,39 +135,27 @@ uint32_t TextInjector::getTypingDelay() const {
 }
 
 bool InjectTextViaClipboard(const std::string& text) {
-    FILE* pipe = popen("xclip -selection clipboard", "w");
-    if (!pipe) {
-        pipe = popen("xsel --clipboard --input", "w");
-    }
-    
-    if (!pipe) return false;
-    
-    fwrite(text.c_str(), 1, text.size(), pipe);
-    if (pclose(pipe) != 0) {
-        return false;
+    {
+        ScopedLatency latency(LatencyStage::ClipboardWrite);
+        if (!ClipboardOwner::instance().setText(text)) {
+            return false;
+        }
     }
     
-    Display* display = XOpenDisplay(nullptr);
-    if (!display) return false;
-    
-    SimulatePaste(display);
-    
-    XCloseDisplay(display);
-    return true;
+    return SimulatePaste();
 }
 
-bool InjectTextDirect(const std::string& text) {
-    Display* display = XOpenDisplay(nullptr);
-    if (!display) return false;
-    
-    for (size_t i = 0; i < text.size(); i++) {
-        char c[2] = {text[i], '\0'};
-        TypeCharacter(display, c);
-        usleep(5000);
+bool InjectTextDirect(const std::string& text, const std::atomic<bool>* cancelled) {
+    if (GetInputBackend() == InputBackend::Evdev) {
+        return UinputKeyboard::instance().type(text, cancelled);
     }
-    
-    XCloseDisplay(display);
-    return true;
+    return TypingEngine::instance().type(text, cancelled);
+}
+
+// XTest remaps spare keycodes for characters the layout lacks; uinput only
+// has its US table, so evdev typing is limited to what that table produces.
+bool CanInjectDirect(const std::string& text) {
+    return GetInputBackend() != InputBackend::Evdev || UinputKeyboard::instance().canType(text);
 }
 
 }
@@ -1,6 +1,8 @@
 #ifdef __APPLE__
 
 #include "text_injector.h"
+#include "injection_strategy.h"
+#include "latency_metrics.h"
 #import <Cocoa/Cocoa.h>
 #import <Carbon/Carbon.h>
 #include <thread>
@@ -64,6 +66,8 @@ std::string TextInjector::getClipboardText() {
 }
 
 static void SimulatePaste() {
+    ScopedLatency latency(LatencyStage::PasteSimulate);
+    
     CGEventSourceRef source = CGEventSourceCreate(kCGEventSourceStateHIDSystemState);
     if (!source) return;
     
@@ -105,13 +109,21 @@ static void TypeCharacter(UniChar character) {
     CFRelease(source);
 }
 
-InjectionResult TextInjector::injectText(const std::string& text, InjectionMethod method) {
+InjectionResult TextInjector::injectText(const std::string& text, InjectionMethod method,
+                                         const std::atomic<bool>* cancelled) {
     if (text.empty()) {
         return {true, ""};
     }
     
+    if (method == InjectionMethod::Auto) {
+        return InjectTextAdaptive(*this, text, cancelled);
+    }
+    
     if (method == InjectionMethod::Direct) {
-        bool success = InjectTextDirect(text);
+        bool success = InjectTextDirect(text, cancelled);
+        if (!success && cancelled && *cancelled) {
+            return {false, "Injection cancelled"};
+        }
         return {success, success ? "" : "Failed to inject text directly"};
     }
     
@@ -139,11 +151,14 @@ uint32_t TextInjector::getTypingDelay() const {
 
 bool InjectTextViaClipboard(const std::string& text) {
     @autoreleasepool {
-        NSPasteboard* pasteboard = [NSPasteboard generalPasteboard];
-        [pasteboard clearContents];
-        NSString* nsText = [NSString stringWithUTF8String:text.c_str()];
-        if (![pasteboard setString:nsText forType:NSPasteboardTypeString]) {
-            return false;
+        {
+            ScopedLatency latency(LatencyStage::ClipboardWrite);
+            NSPasteboard* pasteboard = [NSPasteboard generalPasteboard];
+            [pasteboard clearContents];
+            NSString* nsText = [NSString stringWithUTF8String:text.c_str()];
+            if (![pasteboard setString:nsText forType:NSPasteboardTypeString]) {
+                return false;
+            }
         }
         
         SimulatePaste();
@@ -151,11 +166,15 @@ bool InjectTextViaClipboard(const std::string& text) {
     }
 }
 
-bool InjectTextDirect(const std::string& text) {
+bool InjectTextDirect(const std::string& text, const std::atomic<bool>* cancelled) {
     @autoreleasepool {
         NSString* nsText = [NSString stringWithUTF8String:text.c_str()];
         
         for (NSUInteger i = 0; i < [nsText length]; i++) {
+            if (cancelled && *cancelled) {
+                return false;
+            }
+            
             UniChar c = [nsText characterAtIndex:i];
             TypeCharacter(c);
             usleep(5000);
@@ -165,6 +184,10 @@ bool InjectTextDirect(const std::string& text) {
     }
 }
 
+bool CanInjectDirect(const std::string& text) {
+    return true;
+}
+
 }
 
 #endif
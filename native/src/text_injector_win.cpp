@@ -1,6 +1,8 @@
 #ifdef _WIN32
 
 #include "text_injector.h"
+#include "injection_strategy.h"
+#include "latency_metrics.h"
 #include <windows.h>
 #include <string>
 #include <thread>
@@ -119,13 +121,21 @@ std::string TextInjector::getClipboardText() {
     return result;
 }
 
-InjectionResult TextInjector::injectText(const std::string& text, InjectionMethod method) {
+InjectionResult TextInjector::injectText(const std::string& text, InjectionMethod method,
+                                         const std::atomic<bool>* cancelled) {
     if (text.empty()) {
         return {true, ""};
     }
     
+    if (method == InjectionMethod::Auto) {
+        return InjectTextAdaptive(*this, text, cancelled);
+    }
+    
     if (method == InjectionMethod::Direct) {
-        bool success = InjectTextDirect(text);
+        bool success = InjectTextDirect(text, cancelled);
+        if (!success && cancelled && *cancelled) {
+            return {false, "Injection cancelled"};
+        }
         return {success, success ? "" : "Failed to inject text directly"};
     }
     
@@ -139,6 +149,7 @@ InjectionResult TextInjector::injectTextWithDelay(const std::string& text, uint3
 }
 
 InjectionResult TextInjector::pasteFromClipboard() {
+    ScopedLatency latency(LatencyStage::PasteSimulate);
     INPUT inputs[4] = {};
     
     inputs[0].type = INPUT_KEYBOARD;
@@ -171,24 +182,28 @@ uint32_t TextInjector::getTypingDelay() const {
 bool InjectTextViaClipboard(const std::string& text) {
     std::wstring wtext = Utf8ToWide(text);
     
-    if (!OpenClipboard(nullptr)) {
-        return false;
-    }
-    
-    EmptyClipboard();
-    
-    size_t size = (wtext.size() + 1) * sizeof(wchar_t);
-    HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, size);
-    if (!hMem) {
+    {
+        ScopedLatency latency(LatencyStage::ClipboardWrite);
+        if (!OpenClipboard(nullptr)) {
+            return false;
+        }
+        
+        EmptyClipboard();
+        
+        size_t size = (wtext.size() + 1) * sizeof(wchar_t);
+        HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, size);
+        if (!hMem) {
+            CloseClipboard();
+            return false;
+        }
+        
+        memcpy(GlobalLock(hMem), wtext.c_str(), size);
+        GlobalUnlock(hMem);
+        SetClipboardData(CF_UNICODETEXT, hMem);
         CloseClipboard();
-        return false;
     }
     
-    memcpy(GlobalLock(hMem), wtext.c_str(), size);
-    GlobalUnlock(hMem);
-    SetClipboardData(CF_UNICODETEXT, hMem);
-    CloseClipboard();
-    
+    ScopedLatency latency(LatencyStage::PasteSimulate);
     INPUT inputs[4] = {};
     
     inputs[0].type = INPUT_KEYBOARD;
@@ -208,10 +223,14 @@ bool InjectTextViaClipboard(const std::string& text) {
     return SendInput(4, inputs, sizeof(INPUT)) == 4;
 }
 
-bool InjectTextDirect(const std::string& text) {
+bool InjectTextDirect(const std::string& text, const std::atomic<bool>* cancelled) {
     std::wstring wtext = Utf8ToWide(text);
     
     for (wchar_t c : wtext) {
+        if (cancelled && *cancelled) {
+            return false;
+        }
+        
         INPUT inputs[2] = {};
         
         inputs[0].type = INPUT_KEYBOARD;
@@ -232,6 +251,10 @@ bool InjectTextDirect(const std::string& text) {
     return true;
 }
 
+bool CanInjectDirect(const std::string& text) {
+    return true;
+}
+
 }
 
 #endif
@@ -0,0 +1,285 @@
+#include "text_metrics.h"
+#include "aho_corasick.h"
+#include "case_fold.h"
+#include "char_class.h"
+#include "snapshot_cell.h"
+#include "utf8.h"
+#include <algorithm>
+#include <unordered_set>
+
+namespace speechly {
+
+namespace {
+
+struct PatternSet {
+    std::vector<PatternGroup> groups;
+    AhoCorasick automaton;
+    std::vector<uint32_t> patternGroups;
+    std::vector<uint32_t> patternOrders;
+};
+
+// Folded, with whitespace runs collapsed to one space, so phrases and text
+// compare the same way.
+std::string NormalizePhrase(const std::string& phrase) {
+    std::string normalized;
+    size_t pos = 0;
+    bool space = false;
+    while (pos < phrase.size()) {
+        uint32_t codepoint = DecodeUtf8(phrase, pos);
+        if (IsSpaceCodepoint(codepoint)) {
+            space = !normalized.empty();
+            continue;
+        }
+        if (space) {
+            normalized += ' ';
+            space = false;
+        }
+        AppendUtf8(normalized, FoldCase(codepoint));
+    }
+    return normalized;
+}
+
+// Characters kept in unique words: the JS /[\wÀ-ɏ]/.
+bool IsUniqueWordCodepoint(uint32_t codepoint) {
+    if (codepoint < 0x80) {
+        return (codepoint >= 'a' && codepoint <= 'z') || (codepoint >= 'A' && codepoint <= 'Z') ||
+               (codepoint >= '0' && codepoint <= '9') || codepoint == '_';
+    }
+    return codepoint >= 0xC0 && codepoint <= 0x24F;
+}
+
+const uint64_t kFnvOffset = 14695981039346656037ull;
+const uint64_t kFnvPrime = 1099511628211ull;
+
+bool IsWordBefore(const std::string& folded, size_t pos) {
+    if (pos == 0) {
+        return false;
+    }
+    size_t start = pos - 1;
+    while (start > 0 && (static_cast<unsigned char>(folded[start]) & 0xC0) == 0x80) {
+        start--;
+    }
+    return IsWordCodepoint(DecodeUtf8(folded, start));
+}
+
+bool IsWordAt(const std::string& folded, size_t pos) {
+    return pos < folded.size() && IsWordCodepoint(DecodeUtf8(folded, pos));
+}
+
+bool IsBoundary(const std::string& folded, size_t pos) {
+    return IsWordBefore(folded, pos) != IsWordAt(folded, pos);
+}
+
+struct Candidate {
+    size_t start;
+    size_t end;
+    uint32_t order;
+};
+
+bool Earlier(const Candidate& a, const Candidate& b) {
+    return a.start != b.start ? a.start < b.start : a.order < b.order;
+}
+
+}
+
+class TextMetricsAnalyzer::Impl {
+public:
+    SnapshotCell<PatternSet> patterns;
+};
+
+TextMetricsAnalyzer& TextMetricsAnalyzer::instance() {
+    static TextMetricsAnalyzer* analyzer = new TextMetricsAnalyzer();
+    return *analyzer;
+}
+
+TextMetricsAnalyzer::TextMetricsAnalyzer() : impl_(new Impl()) {}
+
+TextMetricsAnalyzer::~TextMetricsAnalyzer() {
+    delete impl_;
+}
+
+size_t TextMetricsAnalyzer::setPatterns(std::vector<PatternGroup> groups) {
+    auto set = std::make_shared<PatternSet>();
+    set->groups = std::move(groups);
+
+    for (size_t group = 0; group < set->groups.size(); group++) {
+        const auto& phrases = set->groups[group].phrases;
+        for (size_t order = 0; order < phrases.size(); order++) {
+            std::string phrase = NormalizePhrase(phrases[order]);
+            if (phrase.empty()) {
+                continue;
+            }
+            set->automaton.addPattern(phrase);
+            set->patternGroups.push_back(static_cast<uint32_t>(group));
+            set->patternOrders.push_back(static_cast<uint32_t>(order));
+        }
+    }
+    set->automaton.build();
+
+    size_t patterns = set->automaton.patternCount();
+    impl_->patterns.publish(std::move(set));
+    return patterns;
+}
+
+void TextMetricsAnalyzer::analyze(const std::string& text, TextMetrics& metrics) const {
+    std::shared_ptr<const PatternSet> set = impl_->patterns.load();
+    const AhoCorasick& automaton = set->automaton;
+    const bool matching = !automaton.empty();
+
+    metrics = TextMetrics();
+    metrics.groupMatches.resize(set->groups.size());
+
+    // The automaton input, and for each of its bytes the span of text it
+    // came from, so matches can be reported as written.
+    std::string folded;
+    std::vector<size_t> origins;
+    std::vector<size_t> originEnds;
+    std::vector<std::vector<Candidate>> candidates(set->groups.size());
+    int32_t state = AhoCorasick::kRootState;
+
+    auto feed = [&](const std::string& bytes, size_t start, size_t end) {
+        for (unsigned char byte : bytes) {
+            folded += static_cast<char>(byte);
+            origins.push_back(start);
+            originEnds.push_back(end);
+            state = automaton.step(state, byte);
+            automaton.forEachMatch(state, [&](int32_t id) {
+                size_t matchEnd = folded.size();
+                candidates[set->patternGroups[id]].push_back(
+                    {matchEnd - automaton.patternLength(id), matchEnd, set->patternOrders[id]});
+            });
+        }
+    };
+
+    bool inWord = false;
+    bool inSentenceWord = false;
+    bool sentenceOpen = false;
+    uint32_t sentenceWords = 0;
+    uint32_t dots = 0;
+
+    std::unordered_set<uint64_t> uniqueWords;
+    uint64_t wordHash = kFnvOffset;
+    uint32_t wordUnits = 0;
+
+    auto endWord = [&]() {
+        if (inWord && wordUnits > 2) {
+            uniqueWords.insert(wordHash);
+        }
+        inWord = false;
+        inSentenceWord = false;
+    };
+
+    std::string scratch;
+    size_t spaceStart = std::string::npos;
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t start = pos;
+        uint32_t codepoint = DecodeUtf8(text, pos);
+
+        if (codepoint != '.' && dots > 0) {
+            metrics.ellipses += dots / 3;
+            dots = 0;
+        }
+
+        if (IsSpaceCodepoint(codepoint)) {
+            endWord();
+            if (spaceStart == std::string::npos) {
+                spaceStart = start;
+            }
+            continue;
+        }
+
+        if (spaceStart != std::string::npos) {
+            if (matching) {
+                feed(" ", spaceStart, start);
+            }
+            spaceStart = std::string::npos;
+        }
+
+        if (!inWord) {
+            inWord = true;
+            metrics.wordCount++;
+            wordHash = kFnvOffset;
+            wordUnits = 0;
+        }
+
+        if (codepoint == '.' || codepoint == '!' || codepoint == '?') {
+            inSentenceWord = false;
+            sentenceOpen = false;
+        } else if (!inSentenceWord) {
+            inSentenceWord = true;
+            sentenceWords++;
+            if (!sentenceOpen) {
+                sentenceOpen = true;
+                metrics.sentenceCount++;
+            }
+        }
+
+        switch (codepoint) {
+            case ';': metrics.semicolons++; break;
+            case '!': metrics.exclamations++; break;
+            case '.': dots++; break;
+            case 0x2026: metrics.ellipses++; break;
+            default: break;
+        }
+
+        uint32_t lower = FoldCase(codepoint);
+        if (IsUniqueWordCodepoint(lower)) {
+            wordHash = (wordHash ^ lower) * kFnvPrime;
+            wordUnits++;
+        }
+
+        if (matching) {
+            scratch.clear();
+            AppendUtf8(scratch, lower);
+            feed(scratch, start, pos);
+        }
+    }
+    endWord();
+    metrics.ellipses += dots / 3;
+
+    metrics.uniqueWordCount = static_cast<uint32_t>(uniqueWords.size());
+    if (metrics.sentenceCount > 0) {
+        metrics.averageSentenceLength = static_cast<double>(sentenceWords) / metrics.sentenceCount;
+    }
+
+    for (size_t group = 0; group < set->groups.size(); group++) {
+        std::vector<Candidate>& found = candidates[group];
+        std::sort(found.begin(), found.end(), Earlier);
+        std::vector<std::string>& matches = metrics.groupMatches[group];
+        auto report = [&](const Candidate& candidate) {
+            size_t begin = origins[candidate.start];
+            matches.push_back(text.substr(begin, originEnds[candidate.end - 1] - begin));
+        };
+
+        switch (set->groups[group].mode) {
+            case PatternMode::Start:
+                for (const Candidate& candidate : found) {
+                    if (candidate.start == 0 && IsBoundary(folded, candidate.end)) {
+                        report(candidate);
+                        break;
+                    }
+                }
+                break;
+            case PatternMode::First:
+                if (!found.empty()) {
+                    report(found.front());
+                }
+                break;
+            case PatternMode::Words: {
+                size_t end = 0;
+                for (const Candidate& candidate : found) {
+                    if (candidate.start >= end && IsBoundary(folded, candidate.start) &&
+                        IsBoundary(folded, candidate.end)) {
+                        report(candidate);
+                        end = candidate.end;
+                    }
+                }
+                break;
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,65 @@
+#ifndef TEXT_METRICS_H
+#define TEXT_METRICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace speechly {
+
+// How a group of phrases matches, mirroring the regexes the style learner
+// used: ^(...)\b, (...) and \b(...)\b/g.
+enum class PatternMode : uint8_t {
+    Start,   // the phrase the text begins with, ending on a word boundary
+    First,   // the leftmost occurrence anywhere, even inside a word
+    Words    // every non-overlapping whole-word occurrence
+};
+
+// Alternatives at the same position are tried in order, as in a regex
+// alternation. Phrases match case-insensitively and any whitespace run in
+// the text matches a single space in a phrase.
+struct PatternGroup {
+    PatternMode mode;
+    std::vector<std::string> phrases;
+};
+
+struct TextMetrics {
+    // Sentences are split on runs of . ! and ?, words on whitespace.
+    uint32_t sentenceCount{0};
+    uint32_t wordCount{0};
+    double averageSentenceLength{0};
+    uint32_t semicolons{0};
+    uint32_t exclamations{0};
+    uint32_t ellipses{0};
+    // Distinct lowercased words of three or more letters, after dropping
+    // characters other than ASCII word characters and Latin letters.
+    uint32_t uniqueWordCount{0};
+    // The text each group matched, as written, indexed like the groups.
+    std::vector<std::vector<std::string>> groupMatches;
+};
+
+// Everything the style learner measures in a sample, from one pass over
+// the text: counters advance per character, unique words go into a set of
+// 64-bit hashes, and every pattern group is matched by one case-folded
+// Aho-Corasick automaton stepped alongside.
+class TextMetricsAnalyzer {
+public:
+    static TextMetricsAnalyzer& instance();
+
+    // Replaces the pattern groups; returns the number of phrases compiled.
+    size_t setPatterns(std::vector<PatternGroup> groups);
+
+    void analyze(const std::string& text, TextMetrics& metrics) const;
+
+private:
+    TextMetricsAnalyzer();
+    ~TextMetricsAnalyzer();
+
+    class Impl;
+    Impl* impl_;
+};
+
+}
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef TYPING_ENGINE_H
+#define TYPING_ENGINE_H
+
+#ifdef __linux__
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace speechly {
+
+// Types text through XTest on the DisplayAffinity::Injector connection.
+// Keysyms are resolved through a keymap snapshot that is rebuilt only on
+// MappingNotify, fake events are queued a word at a time and flushed
+// together, and the gap between batches follows how fast the server
+// drains them instead of sleeping a fixed time per character.
+//
+// Code points the layout cannot produce are bound to spare keycodes with
+// XChangeKeyboardMapping. Those bindings are kept in a small LRU so repeated
+// characters do not remap again; restoreKeymap() puts the spares back.
+class TypingEngine {
+public:
+    static TypingEngine& instance();
+
+    bool type(const std::string& text, const std::atomic<bool>* cancelled = nullptr);
+    void restoreKeymap();
+
+private:
+    TypingEngine();
+    ~TypingEngine();
+
+    class Impl;
+    Impl* impl_;
+};
+
+}
+
+#endif
+
+#endif
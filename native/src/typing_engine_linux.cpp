@@ -0,0 +1,369 @@
+#ifdef __linux__
+
+#include "typing_engine.h"
+#include "display_pool.h"
+#include "keysym_unicode.h"
+#include "utf8.h"
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XTest.h>
+#include <X11/keysym.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace speechly {
+
+namespace {
+
+const size_t kMaxBatchChars = 32;
+const int64_t kMinGapUs = 500;
+const int64_t kMaxGapUs = 20000;
+const int64_t kSlowSyncUs = 4000;
+const size_t kMaxRemapSlots = 8;
+// How long clients get to refetch the keymap after a MappingNotify before
+// the remapped key is pressed.
+const int64_t kRemapSettleUs = 10000;
+
+struct KeyStroke {
+    KeyCode keycode;
+    bool shift;
+};
+
+struct RemapSlot {
+    KeyCode keycode;
+    KeySym keysym;
+    uint64_t lastUsed;
+    uint64_t batch;
+};
+
+// Latin-1 keysyms equal their code points; everything else uses the
+// 0x01000000 Unicode keysym range, which the keymap also indexes legacy
+// keysyms under.
+KeySym KeysymForCodepoint(uint32_t codepoint) {
+    switch (codepoint) {
+        case '\n':
+            return XK_Return;
+        case '\t':
+            return XK_Tab;
+        case '\b':
+            return XK_BackSpace;
+    }
+    if ((codepoint >= 0x20 && codepoint < 0x7f) || (codepoint >= 0xa0 && codepoint <= 0xff)) {
+        return codepoint;
+    }
+    if (codepoint < 0x100) {
+        return NoSymbol;
+    }
+    return 0x01000000 | codepoint;
+}
+
+bool IsWordBoundary(KeySym keysym) {
+    return keysym == XK_space || keysym == XK_Return || keysym == XK_Tab;
+}
+
+}
+
+// Only touched while holding the Injector display lease, which already
+// serializes every user of this state.
+class TypingEngine::Impl {
+public:
+    void drainEvents(Display* display);
+    void refreshKeymap(Display* display);
+    bool lookup(KeySym keysym, KeyStroke& stroke) const;
+    bool remap(Display* display, KeySym keysym, KeyStroke& stroke);
+    bool isRemapSlot(int keycode) const;
+    void flushBatch(Display* display, bool pace);
+
+    std::unordered_map<KeySym, KeyStroke> keymap;
+    bool keymapValid{false};
+    KeyCode shiftKeycode{0};
+    int64_t gapUs{2000};
+
+    std::vector<RemapSlot> remapSlots;
+    bool remapSlotsFound{false};
+    uint64_t useClock{0};
+    uint64_t batchEpoch{0};
+};
+
+void TypingEngine::Impl::drainEvents(Display* display) {
+    while (XPending(display) > 0) {
+        XEvent event;
+        XNextEvent(display, &event);
+
+        if (event.type == MappingNotify) {
+            XRefreshKeyboardMapping(&event.xmapping);
+
+            bool ownRemap = event.xmapping.request == MappingKeyboard &&
+                            event.xmapping.count == 1 &&
+                            isRemapSlot(event.xmapping.first_keycode);
+            if (!ownRemap) {
+                keymapValid = false;
+            }
+        }
+    }
+
+    if (!keymapValid) {
+        refreshKeymap(display);
+    }
+}
+
+void TypingEngine::Impl::refreshKeymap(Display* display) {
+    keymap.clear();
+
+    int minKeycode = 0;
+    int maxKeycode = 0;
+    XDisplayKeycodes(display, &minKeycode, &maxKeycode);
+
+    int keysymsPerKeycode = 0;
+    KeySym* keysyms = XGetKeyboardMapping(display, static_cast<KeyCode>(minKeycode),
+                                          maxKeycode - minKeycode + 1, &keysymsPerKeycode);
+    if (!keysyms) {
+        return;
+    }
+
+    // Keycodes with no keysyms at all are borrowed for characters the layout
+    // cannot type. A slot is dropped if another client maps something else
+    // onto it.
+    for (int keycode = minKeycode; keycode <= maxKeycode; keycode++) {
+        const KeySym* entry = keysyms + (keycode - minKeycode) * keysymsPerKeycode;
+        bool empty = true;
+        for (int i = 0; i < keysymsPerKeycode; i++) {
+            empty = empty && entry[i] == NoSymbol;
+        }
+
+        if (isRemapSlot(keycode)) {
+            for (auto it = remapSlots.begin(); it != remapSlots.end(); ++it) {
+                if (it->keycode == keycode && !empty && entry[0] != it->keysym) {
+                    remapSlots.erase(it);
+                    break;
+                }
+            }
+        } else if (!remapSlotsFound && empty && remapSlots.size() < kMaxRemapSlots) {
+            remapSlots.push_back({static_cast<KeyCode>(keycode), NoSymbol, 0, 0});
+        }
+    }
+    remapSlotsFound = true;
+
+    // Unshifted placements win over shifted ones, then lower keycodes win.
+    for (int level = 0; level < 2; level++) {
+        for (int keycode = minKeycode; keycode <= maxKeycode; keycode++) {
+            if (isRemapSlot(keycode)) {
+                continue;
+            }
+
+            const KeySym* entry = keysyms + (keycode - minKeycode) * keysymsPerKeycode;
+            KeySym plain = keysymsPerKeycode > 0 ? entry[0] : NoSymbol;
+            KeySym shifted = keysymsPerKeycode > 1 ? entry[1] : NoSymbol;
+
+            if (shifted == NoSymbol && plain != NoSymbol) {
+                KeySym lower, upper;
+                XConvertCase(plain, &lower, &upper);
+                if (lower != upper) {
+                    plain = lower;
+                    shifted = upper;
+                }
+            }
+
+            KeySym keysym = level == 0 ? plain : shifted;
+            if (keysym != NoSymbol) {
+                KeyStroke stroke{static_cast<KeyCode>(keycode), level == 1};
+                keymap.emplace(keysym, stroke);
+
+                // Text is looked up by Unicode keysym, but layouts list
+                // characters such as the euro sign or Cyrillic letters by
+                // their legacy keysyms; index those under both.
+                if (uint32_t codepoint = UnicodeForLegacyKeysym(keysym)) {
+                    keymap.emplace(0x01000000 | codepoint, stroke);
+                }
+            }
+        }
+    }
+
+    XFree(keysyms);
+
+    shiftKeycode = XKeysymToKeycode(display, XK_Shift_L);
+    keymapValid = true;
+}
+
+bool TypingEngine::Impl::lookup(KeySym keysym, KeyStroke& stroke) const {
+    auto it = keymap.find(keysym);
+    if (it == keymap.end()) {
+        return false;
+    }
+    stroke = it->second;
+    return true;
+}
+
+bool TypingEngine::Impl::isRemapSlot(int keycode) const {
+    for (const auto& slot : remapSlots) {
+        if (slot.keycode == keycode) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Binds keysym to a borrowed keycode, reusing the least recently used slot.
+// A slot still referenced by unflushed events is only rebound after the
+// batch has been synced, otherwise the client would read the new keysym
+// for the old key presses. Rebinding ends the batch and waits for clients
+// to pick up the new mapping.
+bool TypingEngine::Impl::remap(Display* display, KeySym keysym, KeyStroke& stroke) {
+    RemapSlot* victim = nullptr;
+    for (auto& slot : remapSlots) {
+        if (slot.keysym == keysym) {
+            slot.lastUsed = ++useClock;
+            slot.batch = batchEpoch;
+            stroke = KeyStroke{slot.keycode, false};
+            return true;
+        }
+        if (!victim || slot.lastUsed < victim->lastUsed) {
+            victim = &slot;
+        }
+    }
+
+    if (!victim) {
+        return false;
+    }
+
+    if (victim->keysym != NoSymbol && victim->batch == batchEpoch) {
+        flushBatch(display, true);
+        return remap(display, keysym, stroke);
+    }
+
+    KeySym keysyms[2] = {keysym, keysym};
+    XChangeKeyboardMapping(display, victim->keycode, 2, keysyms, 1);
+
+    // Clients such as Chromium refresh their keymap asynchronously after
+    // MappingNotify, so the new binding has to reach the server and settle
+    // before any event uses it, as xdotool does.
+    flushBatch(display, false);
+    std::this_thread::sleep_for(std::chrono::microseconds(std::max(gapUs, kRemapSettleUs)));
+
+    victim->keysym = keysym;
+    victim->lastUsed = ++useClock;
+    victim->batch = batchEpoch;
+    stroke = KeyStroke{victim->keycode, false};
+    return true;
+}
+
+// XSync returns once the server has processed the batch, so its duration is
+// a cheap signal of how loaded the server and focused client are. Back off
+// quickly when it is slow and creep back toward the minimum gap otherwise.
+void TypingEngine::Impl::flushBatch(Display* display, bool pace) {
+    auto start = std::chrono::steady_clock::now();
+    XSync(display, False);
+    int64_t elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    if (elapsedUs > kSlowSyncUs) {
+        gapUs = std::min(gapUs * 2, kMaxGapUs);
+    } else {
+        gapUs = std::max(gapUs * 3 / 4, kMinGapUs);
+    }
+
+    batchEpoch++;
+    drainEvents(display);
+
+    if (pace) {
+        std::this_thread::sleep_for(std::chrono::microseconds(gapUs));
+    }
+}
+
+TypingEngine& TypingEngine::instance() {
+    static TypingEngine* engine = new TypingEngine();
+    return *engine;
+}
+
+TypingEngine::TypingEngine() : impl_(new Impl()) {}
+
+TypingEngine::~TypingEngine() {
+    delete impl_;
+}
+
+void TypingEngine::restoreKeymap() {
+    DisplayLease lease = AcquireDisplay(DisplayAffinity::Injector);
+    if (!lease) {
+        return;
+    }
+
+    for (auto& slot : impl_->remapSlots) {
+        if (slot.keysym != NoSymbol) {
+            KeySym keysyms[2] = {NoSymbol, NoSymbol};
+            XChangeKeyboardMapping(lease.get(), slot.keycode, 2, keysyms, 1);
+            slot.keysym = NoSymbol;
+            slot.lastUsed = 0;
+        }
+    }
+    XFlush(lease.get());
+}
+
+bool TypingEngine::type(const std::string& text, const std::atomic<bool>* cancelled) {
+    DisplayLease lease = AcquireDisplay(DisplayAffinity::Injector);
+    if (!lease) {
+        return false;
+    }
+
+    Display* display = lease.get();
+    impl_->drainEvents(display);
+    if (!impl_->keymapValid) {
+        return false;
+    }
+
+    bool shiftDown = false;
+    size_t batched = 0;
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        if (cancelled && *cancelled) {
+            if (shiftDown) {
+                XTestFakeKeyEvent(display, impl_->shiftKeycode, False, CurrentTime);
+            }
+            XFlush(display);
+            return false;
+        }
+
+        KeySym keysym = KeysymForCodepoint(DecodeUtf8(text, pos));
+        KeyStroke stroke;
+        if (keysym == NoSymbol) {
+            continue;
+        }
+        if (!impl_->lookup(keysym, stroke) && !impl_->remap(display, keysym, stroke)) {
+            continue;
+        }
+
+        if (stroke.shift != shiftDown) {
+            XTestFakeKeyEvent(display, impl_->shiftKeycode, stroke.shift, CurrentTime);
+            shiftDown = stroke.shift;
+        }
+
+        XTestFakeKeyEvent(display, stroke.keycode, True, CurrentTime);
+        XTestFakeKeyEvent(display, stroke.keycode, False, CurrentTime);
+        batched++;
+
+        if (IsWordBoundary(keysym) || batched >= kMaxBatchChars) {
+            if (shiftDown) {
+                XTestFakeKeyEvent(display, impl_->shiftKeycode, False, CurrentTime);
+                shiftDown = false;
+            }
+            impl_->flushBatch(display, pos < text.size());
+            batched = 0;
+        }
+    }
+
+    if (shiftDown) {
+        XTestFakeKeyEvent(display, impl_->shiftKeycode, False, CurrentTime);
+    }
+    if (batched > 0) {
+        impl_->flushBatch(display, false);
+    }
+
+    return true;
+}
+
+}
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef UINPUT_KEYBOARD_H
+#define UINPUT_KEYBOARD_H
+
+#ifdef __linux__
+
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+
+namespace speechly {
+
+// USB id of the virtual keyboard, so EvdevReactor can recognise and skip it.
+const uint16_t kUinputVendorId = 0x1209;
+const uint16_t kUinputProductId = 0x5350;
+
+// A virtual keyboard created through /dev/uinput, the evdev backend's
+// replacement for XTest. The device is created on first use and kept, since
+// compositors take a moment to pick up a new keyboard. Each key is written
+// as press, release and SYN_REPORT, and a whole word goes to the kernel in
+// one write().
+//
+// Kernel key codes are physical keys, so text is mapped through a US layout
+// (evdev_keys.h). canType() is false for text that table cannot produce and
+// for any text unless the layout is known to be US; type() refuses such
+// text before sending anything, and the Auto strategy pastes it instead.
+class UinputKeyboard {
+public:
+    static UinputKeyboard& instance();
+
+    bool isAvailable();
+    bool canType(const std::string& text) const;
+    bool type(const std::string& text, const std::atomic<bool>* cancelled = nullptr);
+
+    // Presses the keys in order and releases them in reverse, e.g. a paste.
+    bool pressChord(std::initializer_list<uint16_t> keys);
+
+private:
+    UinputKeyboard();
+    ~UinputKeyboard();
+
+    bool ensureDevice();
+
+    std::mutex mutex_;
+    int fd_;
+};
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,195 @@
+#ifdef __linux__
+
+#include "uinput_keyboard.h"
+#include "evdev_keys.h"
+#include "utf8.h"
+#include <linux/uinput.h>
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace speechly {
+
+// A new input device is announced asynchronously; keys sent before the
+// compositor has opened it are lost.
+static const std::chrono::milliseconds kDeviceSettleTime(200);
+
+// The kernel takes a word in one write, but some clients drop keys that
+// arrive faster than they repaint, so words are spaced slightly.
+static const std::chrono::microseconds kWordGap(2000);
+
+static void AppendEvent(std::vector<input_event>& events, uint16_t type, uint16_t code, int32_t value) {
+    input_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.type = type;
+    event.code = code;
+    event.value = value;
+    events.push_back(event);
+}
+
+static void AppendKey(std::vector<input_event>& events, uint16_t code, bool shift) {
+    if (shift) {
+        AppendEvent(events, EV_KEY, KEY_LEFTSHIFT, 1);
+    }
+    AppendEvent(events, EV_KEY, code, 1);
+    AppendEvent(events, EV_SYN, SYN_REPORT, 0);
+    AppendEvent(events, EV_KEY, code, 0);
+    if (shift) {
+        AppendEvent(events, EV_KEY, KEY_LEFTSHIFT, 0);
+    }
+    AppendEvent(events, EV_SYN, SYN_REPORT, 0);
+}
+
+static bool WriteEvents(int fd, const std::vector<input_event>& events) {
+    const char* data = reinterpret_cast<const char*>(events.data());
+    size_t remaining = events.size() * sizeof(input_event);
+
+    while (remaining > 0) {
+        ssize_t written = write(fd, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        remaining -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+UinputKeyboard& UinputKeyboard::instance() {
+    static UinputKeyboard* keyboard = new UinputKeyboard();
+    return *keyboard;
+}
+
+UinputKeyboard::UinputKeyboard() : fd_(-1) {}
+
+UinputKeyboard::~UinputKeyboard() {
+    if (fd_ >= 0) {
+        ioctl(fd_, UI_DEV_DESTROY);
+        close(fd_);
+    }
+}
+
+bool UinputKeyboard::ensureDevice() {
+    if (fd_ >= 0) {
+        return true;
+    }
+
+    int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    bool configured = ioctl(fd, UI_SET_EVBIT, EV_KEY) == 0 && ioctl(fd, UI_SET_EVBIT, EV_SYN) == 0;
+    for (int code = 1; configured && code < 256; code++) {
+        configured = ioctl(fd, UI_SET_KEYBIT, code) == 0;
+    }
+
+    uinput_setup setup;
+    std::memset(&setup, 0, sizeof(setup));
+    setup.id.bustype = BUS_VIRTUAL;
+    setup.id.vendor = kUinputVendorId;
+    setup.id.product = kUinputProductId;
+    setup.id.version = 1;
+    std::strncpy(setup.name, "Speechly virtual keyboard", UINPUT_MAX_NAME_SIZE - 1);
+
+    if (!configured || ioctl(fd, UI_DEV_SETUP, &setup) < 0 || ioctl(fd, UI_DEV_CREATE) < 0) {
+        close(fd);
+        return false;
+    }
+
+    std::this_thread::sleep_for(kDeviceSettleTime);
+    fd_ = fd;
+    return true;
+}
+
+bool UinputKeyboard::isAvailable() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ensureDevice();
+}
+
+bool UinputKeyboard::canType(const std::string& text) const {
+    if (!EvdevLayoutIsUs()) {
+        return false;
+    }
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        uint16_t code;
+        bool shift;
+        if (!EvdevKeyForCharacter(DecodeUtf8(text.data(), text.size(), pos), code, shift)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool UinputKeyboard::type(const std::string& text, const std::atomic<bool>* cancelled) {
+    if (!canType(text)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ensureDevice()) {
+        return false;
+    }
+
+    std::vector<input_event> events;
+    size_t pos = 0;
+
+    while (pos < text.size()) {
+        if (cancelled && *cancelled) {
+            return false;
+        }
+
+        events.clear();
+        uint32_t codepoint;
+        do {
+            codepoint = DecodeUtf8(text.data(), text.size(), pos);
+            uint16_t code;
+            bool shift;
+            EvdevKeyForCharacter(codepoint, code, shift);
+            AppendKey(events, code, shift);
+        } while (pos < text.size() && codepoint != ' ' && codepoint != '\n');
+
+        if (!WriteEvents(fd_, events)) {
+            return false;
+        }
+        if (pos < text.size()) {
+            std::this_thread::sleep_for(kWordGap);
+        }
+    }
+
+    return true;
+}
+
+bool UinputKeyboard::pressChord(std::initializer_list<uint16_t> keys) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ensureDevice()) {
+        return false;
+    }
+
+    std::vector<input_event> events;
+    for (uint16_t code : keys) {
+        AppendEvent(events, EV_KEY, code, 1);
+        AppendEvent(events, EV_SYN, SYN_REPORT, 0);
+    }
+    for (auto it = keys.end(); it != keys.begin();) {
+        --it;
+        AppendEvent(events, EV_KEY, *it, 0);
+        AppendEvent(events, EV_SYN, SYN_REPORT, 0);
+    }
+
+    return WriteEvents(fd_, events);
+}
+
+}
+
+#endif
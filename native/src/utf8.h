@@ -0,0 +1,91 @@
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace speechly {
+
+const uint32_t kReplacementCodepoint = 0xFFFD;
+
+// Decodes the code point starting at text[pos] and advances pos past it.
+// Malformed, overlong and surrogate sequences consume a single byte and
+// yield U+FFFD, so callers always make progress.
+inline uint32_t DecodeUtf8(const char* text, size_t length, size_t& pos) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(text);
+    unsigned char lead = bytes[pos];
+
+    if (lead < 0x80) {
+        pos++;
+        return lead;
+    }
+
+    size_t extra;
+    uint32_t codepoint;
+    uint32_t minimum;
+    if ((lead & 0xE0) == 0xC0) {
+        extra = 1;
+        codepoint = lead & 0x1F;
+        minimum = 0x80;
+    } else if ((lead & 0xF0) == 0xE0) {
+        extra = 2;
+        codepoint = lead & 0x0F;
+        minimum = 0x800;
+    } else if ((lead & 0xF8) == 0xF0) {
+        extra = 3;
+        codepoint = lead & 0x07;
+        minimum = 0x10000;
+    } else {
+        pos++;
+        return kReplacementCodepoint;
+    }
+
+    if (length - pos <= extra) {
+        pos++;
+        return kReplacementCodepoint;
+    }
+
+    for (size_t i = 1; i <= extra; i++) {
+        unsigned char next = bytes[pos + i];
+        if ((next & 0xC0) != 0x80) {
+            pos++;
+            return kReplacementCodepoint;
+        }
+        codepoint = (codepoint << 6) | (next & 0x3F);
+    }
+
+    if (codepoint < minimum || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+        pos++;
+        return kReplacementCodepoint;
+    }
+
+    pos += extra + 1;
+    return codepoint;
+}
+
+inline uint32_t DecodeUtf8(const std::string& text, size_t& pos) {
+    return DecodeUtf8(text.data(), text.size(), pos);
+}
+
+inline void AppendUtf8(std::string& out, uint32_t codepoint) {
+    if (codepoint < 0x80) {
+        out += static_cast<char>(codepoint);
+    } else if (codepoint < 0x800) {
+        out += static_cast<char>(0xC0 | (codepoint >> 6));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else if (codepoint < 0x10000) {
+        out += static_cast<char>(0xE0 | (codepoint >> 12));
+        out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (codepoint >> 18));
+        out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+}
+
+}
+
+#endif
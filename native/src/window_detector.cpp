@@ -21,7 +21,7 @@ ActiveWindowInfo WindowDetector::getActiveWindow() {
     return info;
 }
 
-bool WindowDetector::startWatching(WindowChangeCallback callback) {
+bool WindowDetector::startWatching(WindowChangeCallback callback, TitleChangeCallback titleCallback) {
     return false;
 }
 
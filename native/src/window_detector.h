@@ -19,6 +19,7 @@ struct ActiveWindowInfo {
 };
 
 using WindowChangeCallback = std::function<void(const ActiveWindowInfo&)>;
+using TitleChangeCallback = std::function<void(const std::string&)>;
 
 class WindowDetector {
 public:
@@ -26,7 +27,7 @@ public:
     ~WindowDetector();
 
     ActiveWindowInfo getActiveWindow();
-    bool startWatching(WindowChangeCallback callback);
+    bool startWatching(WindowChangeCallback callback, TitleChangeCallback titleCallback = nullptr);
     void stopWatching();
     bool isWatching() const;
 
@@ -1,58 +1,211 @@
 #ifdef __linux__
 
 #include "window_detector.h"
+#include "display_pool.h"
+#include "input_reactor.h"
+#include "latency_metrics.h"
 #include <X11/Xlib.h>
 #include <X11/Xatom.h>
 #include <X11/Xutil.h>
 #include <cstring>
-#include <fstream>
-#include <sstream>
-#include <thread>
+#include <cstdlib>
 #include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <fcntl.h>
 #include <unistd.h>
 
 namespace speechly {
 
+namespace {
+
+const uint32_t kTitleCoalesceMs = 150;
+
+struct WindowAtoms {
+    Atom activeWindow;
+    Atom wmName;
+    Atom utf8String;
+    Atom wmPid;
+};
+
+// Atoms are server-wide, so one lookup serves every pooled connection.
+const WindowAtoms& Atoms(Display* display) {
+    static WindowAtoms atoms{None, None, None, None};
+    static std::once_flag once;
+    std::call_once(once, [display]() {
+        char* names[] = {
+            const_cast<char*>("_NET_ACTIVE_WINDOW"),
+            const_cast<char*>("_NET_WM_NAME"),
+            const_cast<char*>("UTF8_STRING"),
+            const_cast<char*>("_NET_WM_PID")
+        };
+        Atom values[4] = {None, None, None, None};
+        XInternAtoms(display, names, 4, False, values);
+        atoms = WindowAtoms{values[0], values[1], values[2], values[3]};
+    });
+    return atoms;
+}
+
+bool ReadSmallFile(const std::string& path, char* buffer, size_t size, size_t& length) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    ssize_t count = read(fd, buffer, size - 1);
+    close(fd);
+    if (count <= 0) {
+        return false;
+    }
+    length = static_cast<size_t>(count);
+    buffer[length] = '\0';
+    return true;
+}
+
+// Field 22 of /proc/<pid>/stat, in clock ticks since boot. Together with the
+// pid it identifies a process even after the pid has been reused.
+uint64_t ReadProcessStartTime(pid_t pid) {
+    char buffer[1024];
+    size_t length = 0;
+    if (!ReadSmallFile("/proc/" + std::to_string(pid) + "/stat", buffer, sizeof(buffer), length)) {
+        return 0;
+    }
+
+    const char* cursor = strrchr(buffer, ')');
+    if (!cursor) {
+        return 0;
+    }
+
+    for (int field = 2; field < 22 && cursor; field++) {
+        cursor = strchr(cursor + 1, ' ');
+    }
+    return cursor ? strtoull(cursor + 1, nullptr, 10) : 0;
+}
+
+struct ProcessEntry {
+    uint64_t startTime;
+    std::string processName;
+    std::string executablePath;
+    uint64_t lastUsed;
+};
+
+class ProcessCache {
+public:
+    void lookup(pid_t pid, std::string& processName, std::string& executablePath);
+
+private:
+    static const size_t kMaxEntries = 64;
+
+    std::mutex mutex_;
+    std::unordered_map<pid_t, ProcessEntry> entries_;
+    uint64_t clock_{0};
+};
+
+struct ActiveWindowState {
+    std::mutex mutex;
+    ActiveWindowInfo info;
+    bool tracking{false};
+};
+
+ProcessCache& Processes() {
+    static ProcessCache* cache = new ProcessCache();
+    return *cache;
+}
+
+ActiveWindowState& ActiveState() {
+    static ActiveWindowState* state = new ActiveWindowState();
+    return *state;
+}
+
+}
+
 class WindowDetector::Impl {
 public:
     std::atomic<bool> isWatching{false};
-    std::thread watcherThread;
     WindowChangeCallback callback;
-    Display* display{nullptr};
+    TitleChangeCallback titleCallback;
     Window lastActiveWindow{0};
+    int32_t handlerId{-1};
+    int32_t titleTimerId{-1};
+    bool titlePending{false};
+    std::string lastEmittedTitle;
+    
+    void onEvent(Display* display, XEvent& event);
+    void trackWindow(Display* display, Window window);
+    void flushTitle();
 };
 
-WindowDetector::WindowDetector() : impl_(new Impl()) {
-    impl_->display = XOpenDisplay(nullptr);
-}
+WindowDetector::WindowDetector() : impl_(new Impl()) {}
 
 WindowDetector::~WindowDetector() {
     stopWatching();
-    if (impl_->display) {
-        XCloseDisplay(impl_->display);
-    }
     delete impl_;
 }
 
+void ProcessCache::lookup(pid_t pid, std::string& processName, std::string& executablePath) {
+    uint64_t startTime = ReadProcessStartTime(pid);
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(pid);
+        if (it != entries_.end() && it->second.startTime == startTime) {
+            it->second.lastUsed = ++clock_;
+            processName = it->second.processName;
+            executablePath = it->second.executablePath;
+            return;
+        }
+    }
+    
+    std::string procDir = "/proc/" + std::to_string(pid);
+    
+    char buffer[4096];
+    size_t length = 0;
+    processName.clear();
+    if (ReadSmallFile(procDir + "/comm", buffer, sizeof(buffer), length)) {
+        if (length > 0 && buffer[length - 1] == '\n') {
+            length--;
+        }
+        processName.assign(buffer, length);
+    }
+    
+    executablePath.clear();
+    ssize_t linkLength = readlink((procDir + "/exe").c_str(), buffer, sizeof(buffer) - 1);
+    if (linkLength > 0) {
+        executablePath.assign(buffer, static_cast<size_t>(linkLength));
+    }
+    
+    if (startTime == 0) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entries_.size() >= kMaxEntries && entries_.find(pid) == entries_.end()) {
+        auto oldest = entries_.begin();
+        for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+            if (it->second.lastUsed < oldest->second.lastUsed) {
+                oldest = it;
+            }
+        }
+        entries_.erase(oldest);
+    }
+    entries_[pid] = ProcessEntry{startTime, processName, executablePath, ++clock_};
+}
+
 static std::string GetWindowName(Display* display, Window window) {
     if (!display || !window) return "";
     
-    Atom netWmName = XInternAtom(display, "_NET_WM_NAME", True);
-    Atom utf8String = XInternAtom(display, "UTF8_STRING", True);
+    const WindowAtoms& atoms = Atoms(display);
     
-    if (netWmName != None) {
-        Atom actualType;
-        int actualFormat;
-        unsigned long nItems, bytesAfter;
-        unsigned char* prop = nullptr;
-        
-        if (XGetWindowProperty(display, window, netWmName, 0, 1024, False,
-                              utf8String, &actualType, &actualFormat, &nItems,
-                              &bytesAfter, &prop) == Success && prop) {
-            std::string name(reinterpret_cast<char*>(prop));
-            XFree(prop);
-            return name;
-        }
+    Atom actualType;
+    int actualFormat;
+    unsigned long nItems, bytesAfter;
+    unsigned char* prop = nullptr;
+    
+    if (XGetWindowProperty(display, window, atoms.wmName, 0, 1024, False,
+                          atoms.utf8String, &actualType, &actualFormat, &nItems,
+                          &bytesAfter, &prop) == Success && prop) {
+        std::string name(reinterpret_cast<char*>(prop), nItems);
+        XFree(prop);
+        return name;
     }
     
     char* wmName = nullptr;
@@ -68,18 +221,15 @@ static std::string GetWindowName(Display* display, Window window) {
 static pid_t GetWindowPid(Display* display, Window window) {
     if (!display || !window) return 0;
     
-    Atom pidAtom = XInternAtom(display, "_NET_WM_PID", True);
-    if (pidAtom == None) return 0;
-    
     Atom actualType;
     int actualFormat;
     unsigned long nItems, bytesAfter;
     unsigned char* prop = nullptr;
     
-    if (XGetWindowProperty(display, window, pidAtom, 0, 1, False,
+    if (XGetWindowProperty(display, window, Atoms(display).wmPid, 0, 1, False,
                           XA_CARDINAL, &actualType, &actualFormat, &nItems,
                           &bytesAfter, &prop) == Success && prop) {
-        pid_t pid = *reinterpret_cast<pid_t*>(prop);
+        pid_t pid = nItems > 0 ? static_cast<pid_t>(*reinterpret_cast<unsigned long*>(prop)) : 0;
         XFree(prop);
         return pid;
     }
@@ -87,51 +237,20 @@ static pid_t GetWindowPid(Display* display, Window window) {
     return 0;
 }
 
-static std::string GetProcessName(pid_t pid) {
-    if (pid <= 0) return "";
-    
-    std::string commPath = "/proc/" + std::to_string(pid) + "/comm";
-    std::ifstream commFile(commPath);
-    if (commFile.is_open()) {
-        std::string name;
-        std::getline(commFile, name);
-        return name;
-    }
-    
-    return "";
-}
-
-static std::string GetExecutablePath(pid_t pid) {
-    if (pid <= 0) return "";
-    
-    std::string exePath = "/proc/" + std::to_string(pid) + "/exe";
-    char buffer[4096];
-    ssize_t len = readlink(exePath.c_str(), buffer, sizeof(buffer) - 1);
-    if (len > 0) {
-        buffer[len] = '\0';
-        return std::string(buffer);
-    }
-    
-    return "";
-}
-
 static Window GetActiveWindow(Display* display) {
     if (!display) return 0;
     
     Window root = DefaultRootWindow(display);
-    Atom activeWindowAtom = XInternAtom(display, "_NET_ACTIVE_WINDOW", True);
-    
-    if (activeWindowAtom == None) return 0;
     
     Atom actualType;
     int actualFormat;
     unsigned long nItems, bytesAfter;
     unsigned char* prop = nullptr;
     
-    if (XGetWindowProperty(display, root, activeWindowAtom, 0, 1, False,
+    if (XGetWindowProperty(display, root, Atoms(display).activeWindow, 0, 1, False,
                           XA_WINDOW, &actualType, &actualFormat, &nItems,
                           &bytesAfter, &prop) == Success && prop) {
-        Window window = *reinterpret_cast<Window*>(prop);
+        Window window = nItems > 0 ? *reinterpret_cast<Window*>(prop) : 0;
         XFree(prop);
         return window;
     }
@@ -139,57 +258,152 @@ static Window GetActiveWindow(Display* display) {
     return 0;
 }
 
+static ActiveWindowInfo ResolveWindowInfo(Display* display, Window window) {
+    ScopedLatency latency(LatencyStage::WindowInfo);
+    ActiveWindowInfo info;
+    info.isValid = false;
+    
+    if (!window) {
+        return info;
+    }
+    
+    info.title = GetWindowName(display, window);
+    info.pid = static_cast<int64_t>(GetWindowPid(display, window));
+    
+    if (info.pid > 0) {
+        Processes().lookup(static_cast<pid_t>(info.pid), info.processName, info.executablePath);
+    }
+    
+    info.isValid = true;
+    
+    return info;
+}
+
 ActiveWindowInfo WindowDetector::getActiveWindow() {
     return GetActiveWindowInfo();
 }
 
-bool WindowDetector::startWatching(WindowChangeCallback callback) {
-    if (impl_->isWatching || !impl_->display) {
-        return false;
+// Follows property changes on the focused window so its title stays current
+// without re-resolving the whole window on every read.
+void WindowDetector::Impl::trackWindow(Display* display, Window window) {
+    InputReactor& reactor = InputReactor::instance();
+    if (lastActiveWindow) {
+        reactor.releasePropertyChanges(display, lastActiveWindow);
+    }
+    if (window) {
+        reactor.selectPropertyChanges(display, window);
     }
+    lastActiveWindow = window;
     
-    impl_->callback = callback;
-    impl_->isWatching = true;
+    ActiveWindowInfo info = ResolveWindowInfo(display, window);
+    
+    ActiveWindowState& state = ActiveState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.info = info;
+}
+
+void WindowDetector::Impl::onEvent(Display* display, XEvent& event) {
+    if (event.type != PropertyNotify) {
+        return;
+    }
+    
+    const WindowAtoms& atoms = Atoms(display);
     
-    impl_->watcherThread = std::thread([this]() {
-        Display* display = XOpenDisplay(nullptr);
-        if (!display) {
-            impl_->isWatching = false;
+    if (event.xproperty.window == DefaultRootWindow(display)) {
+        if (event.xproperty.atom != atoms.activeWindow) {
             return;
         }
         
-        Window root = DefaultRootWindow(display);
-        XSelectInput(display, root, PropertyChangeMask);
-        
-        Atom activeWindowAtom = XInternAtom(display, "_NET_ACTIVE_WINDOW", True);
-        Window lastWindow = 0;
-        
-        while (impl_->isWatching) {
-            while (XPending(display) > 0) {
-                XEvent event;
-                XNextEvent(display, &event);
-                
-                if (event.type == PropertyNotify) {
-                    XPropertyEvent* propEvent = &event.xproperty;
-                    if (propEvent->atom == activeWindowAtom) {
-                        Window currentWindow = GetActiveWindow(display);
-                        if (currentWindow != lastWindow) {
-                            lastWindow = currentWindow;
-                            if (impl_->callback) {
-                                ActiveWindowInfo info = GetActiveWindowInfo();
-                                impl_->callback(info);
-                            }
-                        }
-                    }
-                }
-            }
+        Window currentWindow = GetActiveWindow(display);
+        if (currentWindow != lastActiveWindow) {
+            trackWindow(display, currentWindow);
             
-            usleep(50000);
+            ActiveWindowInfo info = GetActiveWindowInfo();
+            lastEmittedTitle = info.title;
+            if (callback) {
+                callback(info);
+            }
+        }
+        return;
+    }
+    
+    if (event.xproperty.window == lastActiveWindow &&
+        (event.xproperty.atom == atoms.wmName || event.xproperty.atom == XA_WM_NAME)) {
+        std::string title = GetWindowName(display, lastActiveWindow);
+        
+        {
+            ActiveWindowState& state = ActiveState();
+            std::lock_guard<std::mutex> lock(state.mutex);
+            state.info.title = title;
         }
         
-        XCloseDisplay(display);
+        // Pages that animate their title would otherwise flood JS; report
+        // at most one title per window of kTitleCoalesceMs, with the latest
+        // value.
+        if (titleCallback && !titlePending && titleTimerId >= 0) {
+            titlePending = true;
+            InputReactor::instance().armTimer(titleTimerId, kTitleCoalesceMs);
+        }
+    }
+}
+
+void WindowDetector::Impl::flushTitle() {
+    titlePending = false;
+    
+    std::string title;
+    {
+        ActiveWindowState& state = ActiveState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        title = state.info.title;
+    }
+    
+    if (title != lastEmittedTitle) {
+        lastEmittedTitle = title;
+        if (titleCallback) {
+            titleCallback(title);
+        }
+    }
+}
+
+bool WindowDetector::startWatching(WindowChangeCallback callback, TitleChangeCallback titleCallback) {
+    if (impl_->isWatching) {
+        return false;
+    }
+    
+    InputReactor& reactor = InputReactor::instance();
+    if (!reactor.retain()) {
+        return false;
+    }
+    
+    impl_->callback = callback;
+    impl_->titleCallback = titleCallback;
+    impl_->titlePending = false;
+    impl_->isWatching = true;
+    
+    Impl* impl = impl_;
+    if (titleCallback) {
+        impl_->titleTimerId = reactor.addTimer([impl](Display*) {
+            impl->flushTitle();
+        });
+    }
+    impl_->handlerId = reactor.addXEventHandler(PropertyChangeMask, [impl](Display* display, XEvent& event) {
+        impl->onEvent(display, event);
     });
     
+    {
+        DisplayLease display = AcquireDisplay(DisplayAffinity::Reactor);
+        if (display) {
+            impl_->lastActiveWindow = 0;
+            impl_->trackWindow(display.get(), GetActiveWindow(display.get()));
+            
+            ActiveWindowState& state = ActiveState();
+            std::lock_guard<std::mutex> lock(state.mutex);
+            state.tracking = true;
+            impl_->lastEmittedTitle = state.info.title;
+        }
+    }
+    reactor.wake();
+    
     return true;
 }
 
@@ -198,11 +412,29 @@ void WindowDetector::stopWatching() {
         return;
     }
     
+    InputReactor& reactor = InputReactor::instance();
+    reactor.removeXEventHandler(impl_->handlerId);
+    impl_->handlerId = -1;
+    if (impl_->titleTimerId >= 0) {
+        reactor.removeTimer(impl_->titleTimerId);
+        impl_->titleTimerId = -1;
+    }
     impl_->isWatching = false;
     
-    if (impl_->watcherThread.joinable()) {
-        impl_->watcherThread.join();
+    {
+        DisplayLease display = AcquireDisplay(DisplayAffinity::Reactor);
+        if (display && impl_->lastActiveWindow) {
+            reactor.releasePropertyChanges(display.get(), impl_->lastActiveWindow);
+            XFlush(display.get());
+        }
+        impl_->lastActiveWindow = 0;
+        
+        ActiveWindowState& state = ActiveState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.tracking = false;
     }
+    
+    reactor.release();
 }
 
 bool WindowDetector::isWatching() const {
@@ -210,32 +442,22 @@ bool WindowDetector::isWatching() const {
 }
 
 ActiveWindowInfo GetActiveWindowInfo() {
-    ActiveWindowInfo info;
-    info.isValid = false;
-    
-    Display* display = XOpenDisplay(nullptr);
-    if (!display) {
-        return info;
+    {
+        ActiveWindowState& state = ActiveState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (state.tracking) {
+            return state.info;
+        }
     }
     
-    Window activeWindow = GetActiveWindow(display);
-    if (!activeWindow) {
-        XCloseDisplay(display);
+    DisplayLease display = AcquireDisplay(DisplayAffinity::Shared);
+    if (!display) {
+        ActiveWindowInfo info;
+        info.isValid = false;
         return info;
     }
     
-    info.title = GetWindowName(display, activeWindow);
-    info.pid = static_cast<int64_t>(GetWindowPid(display, activeWindow));
-    
-    if (info.pid > 0) {
-        info.processName = GetProcessName(static_cast<pid_t>(info.pid));
-        info.executablePath = GetExecutablePath(static_cast<pid_t>(info.pid));
-    }
-    
-    info.isValid = true;
-    
-    XCloseDisplay(display);
-    return info;
+    return ResolveWindowInfo(display.get(), GetActiveWindow(display.get()));
 }
 
 }
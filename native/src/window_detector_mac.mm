@@ -1,6 +1,7 @@
 #ifdef __APPLE__
 
 #include "window_detector.h"
+#include "latency_metrics.h"
 #import <Cocoa/Cocoa.h>
 #import <AppKit/AppKit.h>
 #import <ApplicationServices/ApplicationServices.h>
@@ -28,7 +29,7 @@ ActiveWindowInfo WindowDetector::getActiveWindow() {
     return GetActiveWindowInfo();
 }
 
-bool WindowDetector::startWatching(WindowChangeCallback callback) {
+bool WindowDetector::startWatching(WindowChangeCallback callback, TitleChangeCallback titleCallback) {
     if (impl_->isWatching) {
         return false;
     }
@@ -70,6 +71,7 @@ bool WindowDetector::isWatching() const {
 }
 
 ActiveWindowInfo GetActiveWindowInfo() {
+    ScopedLatency latency(LatencyStage::WindowInfo);
     ActiveWindowInfo info;
     info.isValid = false;
     
@@ -1,6 +1,7 @@
 #ifdef _WIN32
 
 #include "window_detector.h"
+#include "latency_metrics.h"
 #include <windows.h>
 #include <psapi.h>
 #include <string>
@@ -65,7 +66,7 @@ ActiveWindowInfo WindowDetector::getActiveWindow() {
     return GetActiveWindowInfo();
 }
 
-bool WindowDetector::startWatching(WindowChangeCallback callback) {
+bool WindowDetector::startWatching(WindowChangeCallback callback, TitleChangeCallback titleCallback) {
     if (impl_->isWatching) {
         return false;
     }
@@ -125,6 +126,7 @@ bool WindowDetector::isWatching() const {
 }
 
 ActiveWindowInfo GetActiveWindowInfo() {
+    ScopedLatency latency(LatencyStage::WindowInfo);
     ActiveWindowInfo info;
     info.isValid = false;
     
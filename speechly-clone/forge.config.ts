@@ -1,3 +1,4 @@
+import fs from 'fs';
 import type { ForgeConfig } from '@electron-forge/shared-types';
 import { MakerSquirrel } from '@electron-forge/maker-squirrel';
 import { MakerZIP } from '@electron-forge/maker-zip';
@@ -17,7 +18,8 @@ const config: ForgeConfig = {
     appCategoryType: 'public.app-category.productivity',
     name: 'Speechly Clone',
     executableName: 'speechly-clone',
-    extraResource: ['./resources/icons'],
+    // Language profiles are built from a corpus and may be absent.
+    extraResource: ['./resources/icons', ...(fs.existsSync('./resources/language') ? ['./resources/language'] : [])],
     icon: './resources/icons/icon',
     osxSign: process.env.APPLE_ID ? {} : undefined,
     osxNotarize: process.env.APPLE_ID ? {
@@ -0,0 +1,244 @@
+// Builds the character-trigram language profiles the native addon maps at
+// startup (native/src/language_model.h describes the format).
+//
+//   node scripts/build-language-profiles.js <corpus-dir> [output] [--buckets=32768]
+//
+// The corpus directory holds one UTF-8 text file per language, named after
+// its code in src/data/languages.json (fr-FR.txt, en-US.txt, ...). A tenth
+// of each file's lines is held out to fit the confidence temperature.
+
+const fs = require('fs');
+const path = require('path');
+
+const MAGIC = 'SLNG';
+const VERSION = 1;
+const HEADER_SIZE = 32;
+const CODE_SIZE = 16;
+const MAX_WEIGHT = 255;
+const HELD_OUT_EVERY = 10;
+const HELD_OUT_MAX_LENGTH = 200;
+
+// Must match FoldCase in native/src/case_fold.h.
+function foldCase(cp) {
+  if (cp < 0x80) return cp >= 0x41 && cp <= 0x5a ? cp + 0x20 : cp;
+  if (cp >= 0xc0 && cp <= 0xde && cp !== 0xd7) return cp + 0x20;
+  if ((cp >= 0x100 && cp <= 0x137 && cp !== 0x130) || (cp >= 0x14a && cp <= 0x177)) return cp | 1;
+  if ((cp >= 0x139 && cp <= 0x148) || (cp >= 0x179 && cp <= 0x17e)) return cp & 1 ? cp + 1 : cp;
+  if (cp === 0x178) return 0xff;
+  if (cp >= 0x391 && cp <= 0x3ab && cp !== 0x3a2) return cp + 0x20;
+  if (cp >= 0x400 && cp <= 0x40f) return cp + 0x50;
+  if (cp >= 0x410 && cp <= 0x42f) return cp + 0x20;
+  return cp;
+}
+
+// Must match IsLetterCodepoint in native/src/language_model.cpp.
+function isLetter(cp) {
+  if (cp < 0x80) return (cp >= 0x61 && cp <= 0x7a) || (cp >= 0x41 && cp <= 0x5a);
+  if (cp < 0xc0 || cp === 0xd7 || cp === 0xf7) return false;
+  if ((cp >= 0x2000 && cp <= 0x2bff) || (cp >= 0x3000 && cp <= 0x303f)) return false;
+  return cp < 0x1f000 && cp !== 0xfffd;
+}
+
+function hashTrigram(a, b, c) {
+  let hash = 2166136261;
+  hash = Math.imul(hash ^ a, 16777619);
+  hash = Math.imul(hash ^ b, 16777619);
+  hash = Math.imul(hash ^ c, 16777619);
+  return hash >>> 0;
+}
+
+function forEachTrigram(text, visit) {
+  let previous0 = 0x20;
+  let previous1 = 0x20;
+  let inWord = false;
+
+  for (const char of text) {
+    let cp = char.codePointAt(0);
+    if (!isLetter(cp)) {
+      if (inWord) {
+        visit(hashTrigram(previous0, previous1, 0x20));
+        inWord = false;
+      }
+      continue;
+    }
+
+    cp = foldCase(cp);
+    if (!inWord) {
+      previous0 = 0x20;
+      previous1 = 0x20;
+      inWord = true;
+    } else {
+      visit(hashTrigram(previous0, previous1, cp));
+    }
+    previous0 = previous1;
+    previous1 = cp;
+  }
+  if (inWord) {
+    visit(hashTrigram(previous0, previous1, 0x20));
+  }
+}
+
+function parseArgs(argv) {
+  const positional = argv.filter((arg) => !arg.startsWith('--'));
+  const bucketsArg = argv.find((arg) => arg.startsWith('--buckets='));
+  const buckets = bucketsArg ? Number(bucketsArg.split('=')[1]) : 32768;
+
+  if (positional.length < 1 || !Number.isInteger(buckets) || buckets <= 0 || (buckets & (buckets - 1)) !== 0) {
+    console.error('Usage: node scripts/build-language-profiles.js <corpus-dir> [output] [--buckets=<power of two>]');
+    process.exit(1);
+  }
+
+  return {
+    corpusDir: positional[0],
+    output: positional[1] || path.join(__dirname, '../resources/language/language-profiles.bin'),
+    buckets,
+  };
+}
+
+function loadCorpus(corpusDir) {
+  const known = new Set(
+    require('../src/data/languages.json').languages.map((language) => language.code)
+  );
+  const corpus = [];
+
+  for (const file of fs.readdirSync(corpusDir).sort()) {
+    if (!file.endsWith('.txt')) continue;
+    const code = file.slice(0, -4);
+    if (!known.has(code)) {
+      console.warn(`Skipping ${file}: ${code} is not in languages.json`);
+      continue;
+    }
+    if (Buffer.byteLength(code) >= CODE_SIZE) {
+      console.warn(`Skipping ${file}: code is too long`);
+      continue;
+    }
+
+    const lines = fs.readFileSync(path.join(corpusDir, file), 'utf8').split(/\r?\n/).filter((line) => line.trim());
+    const training = [];
+    const heldOut = [];
+    lines.forEach((line, i) => {
+      if (i % HELD_OUT_EVERY === HELD_OUT_EVERY - 1) {
+        heldOut.push(line.slice(0, HELD_OUT_MAX_LENGTH));
+      } else {
+        training.push(line);
+      }
+    });
+    corpus.push({ code, training, heldOut });
+  }
+
+  return corpus;
+}
+
+// Add-one smoothed -log P(bucket | language) for every bucket.
+function buildCosts(corpus, buckets) {
+  return corpus.map(({ training }) => {
+    const counts = new Float64Array(buckets);
+    let total = 0;
+    for (const line of training) {
+      forEachTrigram(line, (hash) => {
+        counts[hash & (buckets - 1)]++;
+        total++;
+      });
+    }
+
+    const costs = new Float64Array(buckets);
+    const denominator = total + buckets;
+    for (let bucket = 0; bucket < buckets; bucket++) {
+      costs[bucket] = -Math.log((counts[bucket] + 1) / denominator);
+    }
+    return costs;
+  });
+}
+
+function quantize(costs, buckets) {
+  let maxCost = 0;
+  for (const languageCosts of costs) {
+    for (const cost of languageCosts) maxCost = Math.max(maxCost, cost);
+  }
+  const scale = maxCost / MAX_WEIGHT;
+
+  const languageCount = costs.length;
+  const weights = new Uint8Array(buckets * languageCount);
+  for (let bucket = 0; bucket < buckets; bucket++) {
+    for (let language = 0; language < languageCount; language++) {
+      const weight = Math.round(costs[language][bucket] / scale);
+      weights[bucket * languageCount + language] = Math.min(MAX_WEIGHT, weight);
+    }
+  }
+  return { scale, weights };
+}
+
+// The temperature minimizing the held-out negative log-likelihood of the
+// right language, searched on a log grid.
+function fitTemperature(corpus, weights, scale, buckets) {
+  const languageCount = corpus.length;
+  const samples = [];
+  corpus.forEach(({ heldOut }, language) => {
+    for (const line of heldOut) {
+      const totals = new Float64Array(languageCount);
+      let trigrams = 0;
+      forEachTrigram(line, (hash) => {
+        const row = (hash & (buckets - 1)) * languageCount;
+        for (let i = 0; i < languageCount; i++) totals[i] += weights[row + i];
+        trigrams++;
+      });
+      if (trigrams > 0) samples.push({ language, logLikelihoods: totals.map((total) => -total * scale) });
+    }
+  });
+
+  if (samples.length === 0) {
+    console.warn('No held-out lines; using temperature 1');
+    return 1;
+  }
+
+  let best = { temperature: 1, loss: Infinity };
+  for (let step = -20; step <= 40; step++) {
+    const temperature = Math.pow(10, step / 20);
+    let loss = 0;
+    for (const { language, logLikelihoods } of samples) {
+      const max = Math.max(...logLikelihoods);
+      let sum = 0;
+      for (const value of logLikelihoods) sum += Math.exp((value - max) / temperature);
+      loss -= (logLikelihoods[language] - max) / temperature - Math.log(sum);
+    }
+    if (loss < best.loss) best = { temperature, loss };
+  }
+
+  console.log(`Fitted temperature ${best.temperature.toFixed(3)} on ${samples.length} held-out lines`);
+  return best.temperature;
+}
+
+function writeProfiles(output, corpus, buckets, scale, temperature, weights) {
+  const languageCount = corpus.length;
+  const buffer = Buffer.alloc(HEADER_SIZE + languageCount * CODE_SIZE + weights.length);
+
+  buffer.write(MAGIC, 0, 'ascii');
+  buffer.writeUInt32LE(VERSION, 4);
+  buffer.writeUInt32LE(languageCount, 8);
+  buffer.writeUInt32LE(buckets, 12);
+  buffer.writeFloatLE(scale, 16);
+  buffer.writeFloatLE(temperature, 20);
+
+  corpus.forEach(({ code }, i) => buffer.write(code, HEADER_SIZE + i * CODE_SIZE, 'utf8'));
+  Buffer.from(weights.buffer).copy(buffer, HEADER_SIZE + languageCount * CODE_SIZE);
+
+  fs.mkdirSync(path.dirname(output), { recursive: true });
+  fs.writeFileSync(output, buffer);
+  console.log(`Wrote ${languageCount} languages, ${buckets} buckets to ${output} (${buffer.length} bytes)`);
+}
+
+function main() {
+  const { corpusDir, output, buckets } = parseArgs(process.argv.slice(2));
+  const corpus = loadCorpus(corpusDir);
+  if (corpus.length === 0) {
+    console.error(`No <language-code>.txt files found in ${corpusDir}`);
+    process.exit(1);
+  }
+
+  const costs = buildCosts(corpus, buckets);
+  const { scale, weights } = quantize(costs, buckets);
+  const temperature = fitTemperature(corpus, weights, scale, buckets);
+  writeProfiles(output, corpus, buckets, scale, temperature, weights);
+}
+
+main();
@@ -5,6 +5,12 @@ import { Settings, TranscriptHistory, CustomDictionary, GeminiModel, Snippet, Sn
 import { DEFAULT_TRANSLATION_SETTINGS, DEFAULT_RECORDING_SETTINGS } from '../shared/constants';
 import { CONTEXT_NAMES } from '../shared/constants';
 import { analyticsService } from './services/analytics-service';
+import {
+  applySnippetMatches,
+  invalidateSnippetMatcher,
+  matchSnippetsNative,
+  previewSnippetsNative,
+} from './services/snippet-matcher';
 
 interface DatabaseData {
   settings: Settings | null;
@@ -62,6 +68,7 @@ function loadData(): void {
         nextHistoryId: loaded.nextHistoryId || 1,
         nextDictionaryId: loaded.nextDictionaryId || 1,
       };
+      invalidateSnippetMatcher();
     }
   } catch (e) {
     console.error('Failed to load data:', e);
@@ -115,6 +122,7 @@ function initDefaultSnippets(): void {
     createdAt: now,
     updatedAt: now,
   }));
+  invalidateSnippetMatcher();
   saveData();
 }
 
@@ -299,6 +307,7 @@ export function saveSnippet(snippet: Snippet): void {
   } else {
     data.snippets.push({ ...snippet, createdAt: Date.now(), updatedAt: Date.now() });
   }
+  invalidateSnippetMatcher();
   saveData();
 }
 
@@ -306,12 +315,14 @@ export function updateSnippet(id: string, updates: Partial<Snippet>): void {
   const index = data.snippets.findIndex(s => s.id === id);
   if (index !== -1) {
     data.snippets[index] = { ...data.snippets[index], ...updates, updatedAt: Date.now() };
+    invalidateSnippetMatcher();
     saveData();
   }
 }
 
 export function deleteSnippet(id: string): void {
   data.snippets = data.snippets.filter(s => s.id !== id);
+  invalidateSnippetMatcher();
   saveData();
 }
 
@@ -345,6 +356,15 @@ export function incrementSnippetUsage(id: string): void {
 }
 
 export function processSnippets(text: string): SnippetProcessResult {
+  const matches = matchSnippetsNative(data.snippets, text);
+  if (matches) {
+    const result = applySnippetMatches(text, matches, resolveProfileVariables);
+    for (const replacement of result.replacements) {
+      incrementSnippetUsage(replacement.snippetId);
+    }
+    return result;
+  }
+  
   let processedText = text;
   const replacements: { trigger: string; value: string; snippetId: string }[] = [];
   const lowerText = text.toLowerCase();
@@ -376,6 +396,16 @@ export function processSnippets(text: string): SnippetProcessResult {
   return { processedText, replacements };
 }
 
+// Snippet replacements for an interim transcript, for display only: usage
+// counts are left alone. Without the native module there is no preview.
+export function previewSnippets(text: string): SnippetProcessResult {
+  const matches = previewSnippetsNative(data.snippets, text);
+  if (!matches) {
+    return { processedText: text, replacements: [] };
+  }
+  return applySnippetMatches(text, matches, resolveProfileVariables);
+}
+
 function escapeRegex(str: string): string {
   return str.replace(/[.*+?^${}()|[\]\\]/g, '\\$&');
 }
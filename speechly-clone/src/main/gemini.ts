@@ -7,6 +7,19 @@ import { getModePrompt } from './services/mode-prompts';
 import contextDictionaries from '../data/context-dictionaries.json';
 import { getStyleLearner } from './services/style-learner';
 
+interface NativeModule {
+  setContextDictionary: (contextId: string, replacements: Record<string, string>) => number;
+  rewriteWithDictionary: (contextId: string, text: string) => string | null;
+}
+
+let native: NativeModule | null = null;
+
+try {
+  native = require('../../native') as NativeModule;
+} catch (e) {
+  console.warn('Native module not available, dictionaries will be applied in JS');
+}
+
 let genAI: GoogleGenerativeAI | null = null;
 
 export function getGeminiClient(): GoogleGenerativeAI | null {
@@ -43,6 +56,9 @@ function applyDictionaryPreprocessing(
   ];
   if (!dictionary?.replacements) return text;
 
+  const rewritten = rewriteWithNativeDictionary(contextType, dictionary.replacements, text);
+  if (rewritten !== null) return rewritten;
+
   let processed = text;
   const replacements = dictionary.replacements;
 
@@ -58,6 +74,30 @@ function applyDictionaryPreprocessing(
   return processed;
 }
 
+// Contexts whose replacements are already compiled in the native module.
+// The dictionaries ship with the app, so each is compiled once per run.
+const compiledDictionaries = new Set<string>();
+
+function rewriteWithNativeDictionary(
+  contextType: ContextType,
+  replacements: Record<string, string>,
+  text: string
+): string | null {
+  if (!native) return null;
+
+  try {
+    if (!compiledDictionaries.has(contextType)) {
+      if (native.setContextDictionary(contextType, replacements) < 0) return null;
+      compiledDictionaries.add(contextType);
+    }
+    return native.rewriteWithDictionary(contextType, text);
+  } catch (e) {
+    console.error('Native dictionary rewrite failed:', e);
+    native = null;
+    return null;
+  }
+}
+
 function escapeRegex(string: string): string {
   return string.replace(/[.*+?^${}()|[\]\\]/g, '\\$&');
 }
@@ -121,8 +121,8 @@ function initRecordingTrigger(): void {
   const recordingSettings: RecordingSettings = settings?.recording || DEFAULT_RECORDING_SETTINGS;
 
   recordingTrigger = createRecordingTriggerService(
-    () => {
-      mainWindow?.webContents.send('recording:start');
+    (info) => {
+      mainWindow?.webContents.send('recording:start', info);
       trayManager?.setRecordingState(true);
     },
     () => {
@@ -19,6 +19,7 @@ import {
   findSnippetByTrigger,
   incrementSnippetUsage,
   processSnippets,
+  previewSnippets,
   getUserProfile,
   saveUserProfile,
   updateUserProfile,
@@ -292,6 +293,10 @@ export function registerIpcHandlers(): void {
     return processSnippets(text);
   });
 
+  ipcMain.handle('snippets:preview', async (_, text: string) => {
+    return previewSnippets(text);
+  });
+
   ipcMain.handle('profile:get', async () => {
     return getUserProfile();
   });
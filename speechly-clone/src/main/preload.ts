@@ -5,6 +5,7 @@ import {
   CleanupResult,
   TranscriptHistory,
   ActiveWindowInfo,
+  RecordingStartInfo,
   DetectedContext,
   ContextCleanupResult,
   CustomDictionary,
@@ -89,6 +90,9 @@ contextBridge.exposeInMainWorld('electronAPI', {
   processSnippets: (text: string): Promise<SnippetProcessResult> =>
     ipcRenderer.invoke('snippets:process', text),
 
+  previewSnippets: (text: string): Promise<SnippetProcessResult> =>
+    ipcRenderer.invoke('snippets:preview', text),
+
   copyToClipboard: (text: string): Promise<void> =>
     ipcRenderer.invoke('clipboard:copy', text),
 
@@ -201,8 +205,8 @@ contextBridge.exposeInMainWorld('electronAPI', {
   detectLanguage: (text: string): Promise<{ language: string; confidence: number }> =>
     ipcRenderer.invoke('translate:detect', text),
 
-  onRecordingStart: (callback: () => void): void => {
-    ipcRenderer.on('recording:start', callback);
+  onRecordingStart: (callback: (info?: RecordingStartInfo) => void): void => {
+    ipcRenderer.on('recording:start', (_event, info?: RecordingStartInfo) => callback(info));
   },
 
   removeRecordingStartListener: (): void => {
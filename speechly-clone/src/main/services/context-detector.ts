@@ -12,6 +12,13 @@ export type ContextType =
   | 'terminal'
   | 'general';
 
+export interface NativeContextMatch {
+  ruleIndex: number;
+  context: string;
+  appName: string;
+  confidence: 'high' | 'medium' | 'low';
+}
+
 export interface ActiveWindowInfo {
   title: string;
   processName: string;
@@ -19,6 +26,7 @@ export interface ActiveWindowInfo {
   executablePath: string;
   pid: number;
   isValid: boolean;
+  context?: NativeContextMatch;
 }
 
 export interface DetectedContext {
@@ -50,6 +58,28 @@ interface ContextDefinition {
 
 type ContextsMap = Record<string, ContextDefinition>;
 
+interface NativeContextRule {
+  kind: 'process' | 'bundle' | 'web' | 'browserProcess' | 'browserBundle';
+  context: string;
+  appName: string;
+  pattern: string;
+}
+
+interface NativeModule {
+  setAppContexts: (rules: NativeContextRule[]) => number;
+  matchAppContext: (
+    info: Pick<ActiveWindowInfo, 'title' | 'processName' | 'bundleId'>
+  ) => NativeContextMatch | null;
+}
+
+let native: NativeModule | null = null;
+
+try {
+  native = require('../../../native') as NativeModule;
+} catch (e) {
+  console.warn('Native module not available, context detection will run in JS');
+}
+
 export class ContextDetector {
   private platform: 'windows' | 'macos' | 'linux';
   private contexts: ContextsMap;
@@ -58,6 +88,7 @@ export class ContextDetector {
   private cachedContext: DetectedContext | null = null;
   private cacheTimestamp: number = 0;
   private readonly CACHE_TTL_MS = 500;
+  private nativeMatcherReady = false;
 
   constructor() {
     this.platform = this.detectPlatform();
@@ -65,6 +96,7 @@ export class ContextDetector {
     this.browserProcessNames = new Set<string>();
     this.browserBundleIds = new Set<string>();
     this.initBrowserCache();
+    this.initNativeMatcher();
   }
 
   private detectPlatform(): 'windows' | 'macos' | 'linux' {
@@ -93,6 +125,93 @@ export class ContextDetector {
     });
   }
 
+  // Flattens app-contexts.json into the rule list the native matcher
+  // compiles. Order follows the JSON, so the first matching entry wins there
+  // as it does in the JS loops below.
+  private initNativeMatcher(): void {
+    if (!native) return;
+
+    const platformKey = this.platform === 'linux' ? 'windows' : this.platform;
+    const rules: NativeContextRule[] = [];
+
+    for (const [contextType, contextData] of Object.entries(this.contexts)) {
+      if (contextType === 'browser') {
+        for (const app of contextData.apps.windows || []) {
+          if (app.process) {
+            rules.push({ kind: 'browserProcess', context: contextType, appName: app.name, pattern: app.process });
+          }
+        }
+        for (const app of contextData.apps.macos || []) {
+          if (app.bundleId) {
+            rules.push({ kind: 'browserBundle', context: contextType, appName: app.name, pattern: app.bundleId });
+          }
+        }
+        continue;
+      }
+
+      for (const app of contextData.apps[platformKey] || []) {
+        if (app.bundleId) {
+          rules.push({ kind: 'bundle', context: contextType, appName: app.name, pattern: app.bundleId });
+        }
+        if (app.process) {
+          rules.push({ kind: 'process', context: contextType, appName: app.name, pattern: app.process });
+        }
+      }
+
+      for (const app of contextData.apps.web || []) {
+        if (app.urlPattern) {
+          rules.push({ kind: 'web', context: contextType, appName: app.name, pattern: app.urlPattern });
+        }
+      }
+    }
+
+    try {
+      this.nativeMatcherReady = native.setAppContexts(rules) >= 0;
+    } catch (error) {
+      console.warn('Failed to compile native context rules:', error);
+      this.nativeMatcherReady = false;
+    }
+  }
+
+  private detectWithNativeMatcher(windowInfo: ActiveWindowInfo): DetectedContext | null {
+    if (!native || !this.nativeMatcherReady) return null;
+
+    const match = windowInfo.context ?? native.matchAppContext(windowInfo);
+    if (!match) return null;
+
+    if (match.context === 'general') {
+      return {
+        type: 'general',
+        name: 'Général',
+        icon: 'edit',
+        appName: match.appName,
+        confidence: 'low',
+      };
+    }
+
+    if (match.context === 'browser') {
+      return {
+        type: 'browser',
+        name: 'Navigateur',
+        icon: 'globe',
+        appName: match.appName,
+        confidence: 'low',
+      };
+    }
+
+    const contextData = this.contexts[match.context];
+    if (!contextData) return null;
+
+    return {
+      type: match.context as ContextType,
+      name: contextData.name,
+      icon: contextData.icon,
+      appName: match.appName,
+      confidence: match.confidence,
+      subContext: this.detectSubContext(windowInfo, match.context),
+    };
+  }
+
   detectContext(windowInfo: ActiveWindowInfo): DetectedContext {
     const now = Date.now();
     if (
@@ -106,11 +225,16 @@ export class ContextDetector {
     const startTime = performance.now();
     let result: DetectedContext;
 
-    const browserContext = this.detectBrowserContext(windowInfo);
-    if (browserContext) {
-      result = browserContext;
+    const nativeContext = this.detectWithNativeMatcher(windowInfo);
+    if (nativeContext) {
+      result = nativeContext;
     } else {
-      result = this.detectNativeAppContext(windowInfo);
+      const browserContext = this.detectBrowserContext(windowInfo);
+      if (browserContext) {
+        result = browserContext;
+      } else {
+        result = this.detectNativeAppContext(windowInfo);
+      }
     }
 
     const elapsed = performance.now() - startTime;
@@ -2,6 +2,8 @@ import { LanguageDetectionResult, GeminiModel } from '../../shared/types';
 import { languageService } from './language-service';
 import { getGeminiClient } from '../gemini';
 import { getSettings } from '../database';
+import { app } from 'electron';
+import path from 'path';
 
 interface ScriptPattern {
   name: string;
@@ -37,43 +39,154 @@ const SCRIPT_PATTERNS: ScriptPattern[] = [
   { name: 'odia', regex: /[\u0B00-\u0B7F]/, languages: ['or-IN'] },
 ];
 
-const LATIN_LANGUAGE_HINTS: { pattern: RegExp; language: string; weight: number }[] = [
-  { pattern: /\b(le|la|les|de|des|du|au|aux|un|une|et|est|sont|que|qui|dans|pour|avec|sur|pas|par|mais|ou|donc)\b/gi, language: 'fr-FR', weight: 2 },
-  { pattern: /\b(the|and|is|are|that|this|with|for|from|have|has|was|were|been|will|would|could|should)\b/gi, language: 'en-US', weight: 2 },
-  { pattern: /\b(el|la|los|las|de|del|en|que|es|son|para|por|con|una|uno|está|están|como|más)\b/gi, language: 'es-ES', weight: 2 },
-  { pattern: /\b(der|die|das|und|ist|sind|ein|eine|für|mit|auf|den|dem|sich|nicht|auch|nach)\b/gi, language: 'de-DE', weight: 2 },
-  { pattern: /\b(il|la|le|di|che|è|sono|per|con|un|una|del|della|dei|degli|non|come|più)\b/gi, language: 'it-IT', weight: 2 },
-  { pattern: /\b(o|a|os|as|de|do|da|dos|das|em|no|na|que|é|são|para|por|com|um|uma)\b/gi, language: 'pt-BR', weight: 2 },
-  { pattern: /\b(de|het|en|van|een|is|zijn|voor|met|op|dat|die|aan|ook|te|naar|als|bij)\b/gi, language: 'nl-NL', weight: 2 },
-  { pattern: /\b(i|og|er|det|en|at|på|for|med|til|av|som|har|de|var|kan|om|vi|fra)\b/gi, language: 'nb-NO', weight: 2 },
-  { pattern: /\b(och|är|det|en|att|på|för|med|till|av|som|har|de|kan|om|vi|från|den)\b/gi, language: 'sv-SE', weight: 2 },
-  { pattern: /\b(og|er|det|en|at|på|for|med|til|af|som|har|de|kan|om|vi|fra|den)\b/gi, language: 'da-DK', weight: 2 },
-  { pattern: /\b(ja|on|ei|että|se|oli|kun|niin|voi|olla|jos|sitten|kuin|tai|mutta|jo|vain)\b/gi, language: 'fi-FI', weight: 2 },
-  { pattern: /\b(i|w|z|na|do|że|to|jest|się|nie|co|jak|od|za|po|ale|czy|tak|może)\b/gi, language: 'pl-PL', weight: 2 },
-  { pattern: /\b(ve|bir|bu|için|ile|de|da|den|olan|gibi|daha|sonra|var|ancak|ama|çok)\b/gi, language: 'tr-TR', weight: 2 },
-  { pattern: /\b(și|în|de|la|cu|pe|că|este|sunt|pentru|din|care|mai|sau|dar|nu|fost)\b/gi, language: 'ro-RO', weight: 2 },
-  { pattern: /\b(és|a|az|van|nem|hogy|egy|meg|ki|be|is|de|mint|még|csak|már|lesz)\b/gi, language: 'hu-HU', weight: 2 },
-  { pattern: /\b(a|je|v|na|že|se|z|do|to|jako|být|mít|který|ale|nebo|jen|tak|když)\b/gi, language: 'cs-CZ', weight: 2 },
-  { pattern: /\b(a|je|v|na|že|sa|z|do|to|ako|byť|mať|ktorý|ale|alebo|len|tak|keď)\b/gi, language: 'sk-SK', weight: 2 },
+interface LanguageHint {
+  words: string[];
+  language: string;
+  weight: number;
+}
+
+const LATIN_LANGUAGE_HINTS: LanguageHint[] = [
+  { words: ['le', 'la', 'les', 'de', 'des', 'du', 'au', 'aux', 'un', 'une', 'et', 'est', 'sont', 'que', 'qui', 'dans', 'pour', 'avec', 'sur', 'pas', 'par', 'mais', 'ou', 'donc'], language: 'fr-FR', weight: 2 },
+  { words: ['the', 'and', 'is', 'are', 'that', 'this', 'with', 'for', 'from', 'have', 'has', 'was', 'were', 'been', 'will', 'would', 'could', 'should'], language: 'en-US', weight: 2 },
+  { words: ['el', 'la', 'los', 'las', 'de', 'del', 'en', 'que', 'es', 'son', 'para', 'por', 'con', 'una', 'uno', 'está', 'están', 'como', 'más'], language: 'es-ES', weight: 2 },
+  { words: ['der', 'die', 'das', 'und', 'ist', 'sind', 'ein', 'eine', 'für', 'mit', 'auf', 'den', 'dem', 'sich', 'nicht', 'auch', 'nach'], language: 'de-DE', weight: 2 },
+  { words: ['il', 'la', 'le', 'di', 'che', 'è', 'sono', 'per', 'con', 'un', 'una', 'del', 'della', 'dei', 'degli', 'non', 'come', 'più'], language: 'it-IT', weight: 2 },
+  { words: ['o', 'a', 'os', 'as', 'de', 'do', 'da', 'dos', 'das', 'em', 'no', 'na', 'que', 'é', 'são', 'para', 'por', 'com', 'um', 'uma'], language: 'pt-BR', weight: 2 },
+  { words: ['de', 'het', 'en', 'van', 'een', 'is', 'zijn', 'voor', 'met', 'op', 'dat', 'die', 'aan', 'ook', 'te', 'naar', 'als', 'bij'], language: 'nl-NL', weight: 2 },
+  { words: ['i', 'og', 'er', 'det', 'en', 'at', 'på', 'for', 'med', 'til', 'av', 'som', 'har', 'de', 'var', 'kan', 'om', 'vi', 'fra'], language: 'nb-NO', weight: 2 },
+  { words: ['och', 'är', 'det', 'en', 'att', 'på', 'för', 'med', 'till', 'av', 'som', 'har', 'de', 'kan', 'om', 'vi', 'från', 'den'], language: 'sv-SE', weight: 2 },
+  { words: ['og', 'er', 'det', 'en', 'at', 'på', 'for', 'med', 'til', 'af', 'som', 'har', 'de', 'kan', 'om', 'vi', 'fra', 'den'], language: 'da-DK', weight: 2 },
+  { words: ['ja', 'on', 'ei', 'että', 'se', 'oli', 'kun', 'niin', 'voi', 'olla', 'jos', 'sitten', 'kuin', 'tai', 'mutta', 'jo', 'vain'], language: 'fi-FI', weight: 2 },
+  { words: ['i', 'w', 'z', 'na', 'do', 'że', 'to', 'jest', 'się', 'nie', 'co', 'jak', 'od', 'za', 'po', 'ale', 'czy', 'tak', 'może'], language: 'pl-PL', weight: 2 },
+  { words: ['ve', 'bir', 'bu', 'için', 'ile', 'de', 'da', 'den', 'olan', 'gibi', 'daha', 'sonra', 'var', 'ancak', 'ama', 'çok'], language: 'tr-TR', weight: 2 },
+  { words: ['și', 'în', 'de', 'la', 'cu', 'pe', 'că', 'este', 'sunt', 'pentru', 'din', 'care', 'mai', 'sau', 'dar', 'nu', 'fost'], language: 'ro-RO', weight: 2 },
+  { words: ['és', 'a', 'az', 'van', 'nem', 'hogy', 'egy', 'meg', 'ki', 'be', 'is', 'de', 'mint', 'még', 'csak', 'már', 'lesz'], language: 'hu-HU', weight: 2 },
+  { words: ['a', 'je', 'v', 'na', 'že', 'se', 'z', 'do', 'to', 'jako', 'být', 'mít', 'který', 'ale', 'nebo', 'jen', 'tak', 'když'], language: 'cs-CZ', weight: 2 },
+  { words: ['a', 'je', 'v', 'na', 'že', 'sa', 'z', 'do', 'to', 'ako', 'byť', 'mať', 'ktorý', 'ale', 'alebo', 'len', 'tak', 'keď'], language: 'sk-SK', weight: 2 },
 ];
 
+const HINT_PATTERNS: RegExp[] = LATIN_LANGUAGE_HINTS.map(
+  (hint) => new RegExp(`\\b(${hint.words.join('|')})\\b`, 'gi')
+);
+
+interface NativeScriptHistogram {
+  scripts: number[];
+  hintScores: number[];
+}
+
+interface NativeModule {
+  setLanguageHints: (hints: LanguageHint[]) => number;
+  detectScripts: (text: string) => NativeScriptHistogram;
+  getScriptNames: () => string[];
+  loadLanguageModel: (path: string) => { loaded: boolean; languages: number; error?: string };
+  identifyLanguage: (text: string, maxResults?: number) => { language: string; confidence: number }[];
+}
+
+let native: NativeModule | null = null;
+// Index of each SCRIPT_PATTERNS entry in the native script counts.
+let nativeScriptIndexes: number[] = [];
+
+try {
+  native = require('../../../native') as NativeModule;
+  const names = native.getScriptNames();
+  nativeScriptIndexes = SCRIPT_PATTERNS.map((pattern) => names.indexOf(pattern.name));
+  native.setLanguageHints(LATIN_LANGUAGE_HINTS);
+} catch (e) {
+  native = null;
+  console.warn('Native module not available, language hints will be scanned in JS');
+}
+
+interface TextAnalysis {
+  // Scripts present in the text, in SCRIPT_PATTERNS order.
+  scripts: ScriptPattern[];
+  // Weighted hint word count for each LATIN_LANGUAGE_HINTS entry.
+  hintScores: number[];
+}
+
+// One native pass counts scripts and hint words together; without the
+// addon every pattern is run separately.
+function analyzeText(text: string): TextAnalysis {
+  if (native) {
+    try {
+      const histogram = native.detectScripts(text);
+      return {
+        scripts: SCRIPT_PATTERNS.filter((_, i) => (histogram.scripts[nativeScriptIndexes[i]] || 0) > 0),
+        hintScores: histogram.hintScores,
+      };
+    } catch (e) {
+      console.error('Native script detection failed:', e);
+      native = null;
+    }
+  }
+
+  return {
+    scripts: SCRIPT_PATTERNS.filter((pattern) => pattern.regex.test(text)),
+    hintScores: HINT_PATTERNS.map(
+      (pattern, i) => (text.match(pattern)?.length || 0) * LATIN_LANGUAGE_HINTS[i].weight
+    ),
+  };
+}
+
+// Below this the trigram model defers to the stop-word hints and Gemini.
+const MODEL_MIN_CONFIDENCE = 0.85;
+
+let languageModelState: 'unloaded' | 'loaded' | 'unavailable' = 'unloaded';
+
+function languageModelPath(): string {
+  return app.isPackaged
+    ? path.join(process.resourcesPath, 'language', 'language-profiles.bin')
+    : path.join(__dirname, '../../resources/language/language-profiles.bin');
+}
+
+// The profile file is mapped on first use; without it, or without the
+// addon, detection keeps its previous behavior.
+function ensureLanguageModel(): boolean {
+  if (!native) return false;
+  if (languageModelState === 'unloaded') {
+    const status = native.loadLanguageModel(languageModelPath());
+    languageModelState = status.loaded ? 'loaded' : 'unavailable';
+    if (!status.loaded) {
+      console.warn('Language profiles not loaded, detection will use hints and Gemini:', status.error);
+    }
+  }
+  return languageModelState === 'loaded';
+}
+
 class LanguageDetector {
+  // Offline trigram identification; cheap enough for every interim result.
+  identify(text: string): LanguageDetectionResult | null {
+    try {
+      if (!ensureLanguageModel() || !native) return null;
+      const guesses = native.identifyLanguage(text, 4);
+      if (guesses.length === 0) return null;
+
+      return {
+        detectedLanguage: guesses[0].language,
+        confidence: guesses[0].confidence,
+        alternatives: guesses.slice(1).map((guess) => ({ code: guess.language, confidence: guess.confidence })),
+      };
+    } catch (e) {
+      console.error('Native language identification failed:', e);
+      languageModelState = 'unavailable';
+      return null;
+    }
+  }
+
   quickDetect(text: string): string | null {
     if (!text || text.trim().length < 3) return null;
 
-    for (const pattern of SCRIPT_PATTERNS) {
-      if (pattern.regex.test(text)) {
-        return pattern.languages[0];
-      }
+    const analysis = analyzeText(text);
+    if (analysis.scripts.length > 0) {
+      return analysis.scripts[0].languages[0];
     }
 
     const scores: Record<string, number> = {};
-    for (const hint of LATIN_LANGUAGE_HINTS) {
-      const matches = text.match(hint.pattern);
-      if (matches && matches.length > 0) {
-        scores[hint.language] = (scores[hint.language] || 0) + (matches.length * hint.weight);
+    LATIN_LANGUAGE_HINTS.forEach((hint, i) => {
+      const score = analysis.hintScores[i] || 0;
+      if (score > 0) {
+        scores[hint.language] = (scores[hint.language] || 0) + score;
       }
-    }
+    });
 
     const entries = Object.entries(scores);
     if (entries.length === 0) return null;
@@ -90,15 +203,25 @@ class LanguageDetector {
   }
 
   getScriptInfo(text: string): { script: string; languages: string[] } | null {
-    for (const pattern of SCRIPT_PATTERNS) {
-      if (pattern.regex.test(text)) {
-        return { script: pattern.name, languages: pattern.languages };
-      }
-    }
-    return null;
+    return this.scriptInfoFrom(analyzeText(text));
+  }
+
+  private scriptInfoFrom(analysis: TextAnalysis): { script: string; languages: string[] } | null {
+    const pattern = analysis.scripts[0];
+    return pattern ? { script: pattern.name, languages: pattern.languages } : null;
   }
 
   async detectLanguage(text: string): Promise<LanguageDetectionResult> {
+    const modelResult = this.identify(text);
+    if (modelResult && modelResult.confidence >= MODEL_MIN_CONFIDENCE) {
+      // A model without profiles for the text's script can still be
+      // confident about the wrong one, so the script has the last word.
+      const scriptInfo = this.getScriptInfo(text);
+      if (!scriptInfo || scriptInfo.languages.includes(modelResult.detectedLanguage)) {
+        return modelResult;
+      }
+    }
+
     const quickResult = this.quickDetect(text);
     
     if (quickResult && text.length < 50) {
@@ -197,32 +320,27 @@ Text to analyze: "${text.substring(0, 500)}"`;
     if (!lang) return 0;
 
     let score = 0;
+    const analysis = analyzeText(text);
 
     if (lang.rtl) {
-      const rtlScripts = SCRIPT_PATTERNS.filter(p => 
+      const rtlScripts = analysis.scripts.filter(p => 
         ['arabic', 'hebrew'].includes(p.name) && p.languages.includes(languageCode)
       );
-      for (const script of rtlScripts) {
-        if (script.regex.test(text)) {
-          score += 50;
-          break;
-        }
+      if (rtlScripts.length > 0) {
+        score += 50;
       }
     }
 
-    const scriptInfo = this.getScriptInfo(text);
+    const scriptInfo = this.scriptInfoFrom(analysis);
     if (scriptInfo && scriptInfo.languages.includes(languageCode)) {
       score += 30;
     }
 
-    for (const hint of LATIN_LANGUAGE_HINTS) {
+    LATIN_LANGUAGE_HINTS.forEach((hint, i) => {
       if (hint.language === languageCode) {
-        const matches = text.match(hint.pattern);
-        if (matches) {
-          score += matches.length * 5;
-        }
+        score += ((analysis.hintScores[i] || 0) / hint.weight) * 5;
       }
-    }
+    });
 
     return Math.min(100, score);
   }
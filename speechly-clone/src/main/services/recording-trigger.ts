@@ -1,10 +1,23 @@
-import { RecordingTriggerMode, RecordingSettings, TriggerKey } from '../../shared/types';
+import { RecordingTriggerMode, RecordingSettings, RecordingStartInfo, TriggerKey } from '../../shared/types';
+import { DEFAULT_RECORDING_SETTINGS } from '../../shared/constants';
 
 interface NativeModule {
-  registerDoubleTapListener: (key: TriggerKey, threshold: number, callback: (event: string) => void) => number;
+  registerDoubleTapListener: (
+    key: TriggerKey,
+    threshold: number,
+    callback: (event: string, timestamp: number) => void
+  ) => number;
   unregisterDoubleTapListener: (id: number) => void;
-  registerHoldListener: (key: TriggerKey, callback: (event: string, duration: number) => void) => number;
+  registerHoldListener: (
+    key: TriggerKey,
+    callback: (event: string, duration: number, timestamp: number) => void
+  ) => number;
   unregisterHoldListener: (id: number) => void;
+  registerGestureListener?: (
+    spec: string,
+    callback: (event: string, duration: number, timestamp: number) => void
+  ) => number;
+  unregisterGestureListener?: (id: number) => void;
 }
 
 let native: NativeModule | null = null;
@@ -15,16 +28,24 @@ try {
   console.warn('Native module not available, recording triggers will be disabled');
 }
 
+// Native key timestamps share the process.hrtime() clock, so the age is the
+// delay between the key press and this callback running.
+function startInfoFromKey(timestamp: number): RecordingStartInfo {
+  const nowMs = Number(process.hrtime.bigint()) / 1e6;
+  return { keyTimestamp: timestamp, keyAgeMs: Math.max(0, nowMs - timestamp) };
+}
+
 export class RecordingTriggerService {
   private mode: RecordingTriggerMode = 'double-tap';
   private doubleTapListenerId: number | null = null;
   private holdListenerId: number | null = null;
+  private gestureListenerId: number | null = null;
   private isRecording: boolean = false;
-  private onRecordingStart: () => void;
+  private onRecordingStart: (info?: RecordingStartInfo) => void;
   private onRecordingStop: () => void;
   private settings: RecordingSettings | null = null;
 
-  constructor(onStart: () => void, onStop: () => void) {
+  constructor(onStart: (info?: RecordingStartInfo) => void, onStop: () => void) {
     this.onRecordingStart = onStart;
     this.onRecordingStop = onStop;
   }
@@ -47,6 +68,9 @@ export class RecordingTriggerService {
       case 'hold':
         this.setupHold(settings);
         break;
+      case 'gesture':
+        this.setupGesture(settings);
+        break;
       case 'toggle':
         break;
     }
@@ -58,11 +82,11 @@ export class RecordingTriggerService {
     this.doubleTapListenerId = native.registerDoubleTapListener(
       settings.doubleTapKey,
       settings.doubleTapThreshold,
-      (event: string) => {
+      (event: string, timestamp: number) => {
         if (event === 'double-tap') {
           if (!this.isRecording) {
             this.isRecording = true;
-            this.onRecordingStart();
+            this.onRecordingStart(startInfoFromKey(timestamp));
           } else {
             this.isRecording = false;
             this.onRecordingStop();
@@ -77,11 +101,11 @@ export class RecordingTriggerService {
 
     this.holdListenerId = native.registerHoldListener(
       settings.holdKey,
-      (event: string, duration: number) => {
+      (event: string, duration: number, timestamp: number) => {
         if (event === 'hold-start') {
           if (!this.isRecording) {
             this.isRecording = true;
-            this.onRecordingStart();
+            this.onRecordingStart(startInfoFromKey(timestamp));
           }
         } else if (event === 'hold-end') {
           if (this.isRecording) {
@@ -93,6 +117,44 @@ export class RecordingTriggerService {
     );
   }
 
+  // One native listener per gesture spec: a gesture ending in a tap toggles
+  // recording, one ending in a hold records while the keys stay down.
+  private setupGesture(settings: RecordingSettings): void {
+    if (!native || !native.registerGestureListener) return;
+
+    const spec = settings.gesture || DEFAULT_RECORDING_SETTINGS.gesture;
+    const id = native.registerGestureListener(
+      spec,
+      (event: string, duration: number, timestamp: number) => {
+        if (event === 'gesture') {
+          if (!this.isRecording) {
+            this.isRecording = true;
+            this.onRecordingStart(startInfoFromKey(timestamp));
+          } else {
+            this.isRecording = false;
+            this.onRecordingStop();
+          }
+        } else if (event === 'hold-start') {
+          if (!this.isRecording) {
+            this.isRecording = true;
+            this.onRecordingStart(startInfoFromKey(timestamp));
+          }
+        } else if (event === 'hold-end') {
+          if (this.isRecording) {
+            this.isRecording = false;
+            this.onRecordingStop();
+          }
+        }
+      }
+    );
+
+    if (id < 0) {
+      console.warn(`Invalid recording gesture: ${spec}`);
+      return;
+    }
+    this.gestureListenerId = id;
+  }
+
   toggle(): void {
     if (!this.isRecording) {
       this.isRecording = true;
@@ -132,6 +194,10 @@ export class RecordingTriggerService {
       native.unregisterHoldListener(this.holdListenerId);
       this.holdListenerId = null;
     }
+    if (this.gestureListenerId !== null && native.unregisterGestureListener) {
+      native.unregisterGestureListener(this.gestureListenerId);
+      this.gestureListenerId = null;
+    }
   }
 
   updateSettings(settings: RecordingSettings): void {
@@ -146,7 +212,7 @@ export function getRecordingTriggerService(): RecordingTriggerService | null {
 }
 
 export function createRecordingTriggerService(
-  onStart: () => void,
+  onStart: (info?: RecordingStartInfo) => void,
   onStop: () => void
 ): RecordingTriggerService {
   if (recordingTriggerInstance) {
@@ -0,0 +1,131 @@
+import { Snippet, SnippetProcessResult, SnippetReplacement } from '../../shared/types';
+
+interface NativeSnippetMatch {
+  id: string;
+  value: string;
+  start: number;
+  end: number;
+}
+
+interface NativeSnippetStreamResult {
+  committed: NativeSnippetMatch[];
+  pending: NativeSnippetMatch[];
+  length: number;
+}
+
+interface NativeModule {
+  compileSnippets: (snippets: { id: string; triggers: string[]; value: string }[]) => number;
+  matchSnippets: (text: string) => NativeSnippetMatch[];
+  createSnippetStream: () => number;
+  snippetStreamAppend: (stream: number, delta: string, final?: boolean) => NativeSnippetStreamResult;
+  snippetStreamReset: (stream: number) => boolean;
+}
+
+let native: NativeModule | null = null;
+
+try {
+  native = require('../../../native') as NativeModule;
+} catch (e) {
+  console.warn('Native module not available, snippets will be matched in JS');
+}
+
+let compiled = false;
+
+// Live preview state: the text already fed to the native stream and the
+// matches it has committed for that text.
+let previewStream: number | null = null;
+let previewText = '';
+let previewCommitted: NativeSnippetMatch[] = [];
+
+function resetPreview(): void {
+  if (native && previewStream !== null) {
+    native.snippetStreamReset(previewStream);
+  }
+  previewText = '';
+  previewCommitted = [];
+}
+
+function ensureCompiled(snippets: Snippet[]): boolean {
+  if (!native) return false;
+  if (compiled) return true;
+
+  const definitions = snippets
+    .filter((snippet) => snippet.isActive && snippet.content)
+    .map((snippet) => ({
+      id: snippet.id,
+      triggers: [snippet.triggerPhrase, ...snippet.triggerVariants],
+      value: snippet.content,
+    }));
+
+  try {
+    compiled = native.compileSnippets(definitions) >= 0;
+  } catch (e) {
+    console.error('Failed to compile snippets natively:', e);
+    native = null;
+    return false;
+  }
+
+  // The stream keeps matching against the set it started with until reset.
+  resetPreview();
+  return compiled;
+}
+
+export function invalidateSnippetMatcher(): void {
+  compiled = false;
+}
+
+export function matchSnippetsNative(snippets: Snippet[], text: string): NativeSnippetMatch[] | null {
+  if (!ensureCompiled(snippets) || !native) return null;
+  return native.matchSnippets(text);
+}
+
+// Matches for a transcript that is still being dictated. Only the text
+// appended since the previous call is scanned; if the recognizer revised
+// earlier words, the stream starts over from the new text.
+export function previewSnippetsNative(snippets: Snippet[], text: string): NativeSnippetMatch[] | null {
+  if (!ensureCompiled(snippets) || !native) return null;
+
+  if (previewStream === null) {
+    previewStream = native.createSnippetStream();
+  }
+  if (!text.startsWith(previewText)) {
+    resetPreview();
+  }
+
+  const result = native.snippetStreamAppend(previewStream, text.slice(previewText.length));
+  previewText = text;
+  previewCommitted = previewCommitted.concat(result.committed);
+  return previewCommitted.concat(result.pending);
+}
+
+// Builds the output in one pass over non-overlapping matches in text order.
+// Each snippet is reported once, for its first occurrence.
+export function applySnippetMatches(
+  text: string,
+  matches: NativeSnippetMatch[],
+  resolveValue: (value: string) => string
+): SnippetProcessResult {
+  const parts: string[] = [];
+  const replacements: SnippetReplacement[] = [];
+  const resolved = new Map<string, string>();
+  let cursor = 0;
+
+  for (const match of matches) {
+    let value = resolved.get(match.id);
+    if (value === undefined) {
+      value = resolveValue(match.value);
+      resolved.set(match.id, value);
+      replacements.push({
+        trigger: text.slice(match.start, match.end),
+        value,
+        snippetId: match.id,
+      });
+    }
+
+    parts.push(text.slice(cursor, match.start), value);
+    cursor = match.end;
+  }
+  parts.push(text.slice(cursor));
+
+  return { processedText: parts.join(''), replacements };
+}
@@ -31,39 +31,117 @@ const ENGLISH_STOP_WORDS = new Set([
   'same', 'so', 'than', 'too', 'very', 'just', 'also', 'now', 'here', 'there',
 ]);
 
-const GREETING_PATTERNS_FR = [
-  /^(salut|bonjour|hello|hey|coucou|hi|bonsoir|bjr|slt)\b/i,
-  /^(cher|chère|chers|chères)\b/i,
-  /^(madame|monsieur|mesdames|messieurs)\b/i,
+// Each list is one alternation, tried in order at every position. Spaces
+// in a phrase match any run of whitespace.
+const GREETING_PHRASES_FR = [
+  ['salut', 'bonjour', 'hello', 'hey', 'coucou', 'hi', 'bonsoir', 'bjr', 'slt'],
+  ['cher', 'chère', 'chers', 'chères'],
+  ['madame', 'monsieur', 'mesdames', 'messieurs'],
 ];
 
-const GREETING_PATTERNS_EN = [
-  /^(hi|hello|hey|dear|good\s*morning|good\s*afternoon|good\s*evening)\b/i,
+const GREETING_PHRASES_EN = [
+  ['hi', 'hello', 'hey', 'dear', 'good morning', 'goodmorning', 'good afternoon', 'goodafternoon', 'good evening', 'goodevening'],
 ];
 
-const CLOSING_PATTERNS_FR = [
-  /(cordialement|à bientôt|à\+|a\+|bien à vous|amicalement|sincèrement)/i,
-  /(bonne (journée|soirée|continuation)|merci d'avance)/i,
-  /(à (très\s+)?bientôt|au revoir|bisous|bises)/i,
+const CLOSING_PHRASES_FR = [
+  ['cordialement', 'à bientôt', 'à+', 'a+', 'bien à vous', 'amicalement', 'sincèrement'],
+  ['bonne journée', 'bonne soirée', 'bonne continuation', "merci d'avance"],
+  ['à très bientôt', 'à bientôt', 'au revoir', 'bisous', 'bises'],
 ];
 
-const CLOSING_PATTERNS_EN = [
-  /(best|regards|sincerely|cheers|thanks|thank you|best wishes)/i,
-  /(kind regards|warm regards|yours truly|take care)/i,
+const CLOSING_PHRASES_EN = [
+  ['best', 'regards', 'sincerely', 'cheers', 'thanks', 'thank you', 'best wishes'],
+  ['kind regards', 'warm regards', 'yours truly', 'take care'],
 ];
 
-const TRANSITION_PATTERNS_FR = [
-  /\b(du coup|donc|par ailleurs|en effet|d'ailleurs|sinon|par contre)\b/gi,
-  /\b(effectivement|clairement|notamment|en fait|de plus|ainsi|cependant)\b/gi,
-  /\b(toutefois|néanmoins|en revanche|en outre|de même|également)\b/gi,
+const TRANSITION_PHRASES_FR = [
+  ['du coup', 'donc', 'par ailleurs', 'en effet', "d'ailleurs", 'sinon', 'par contre'],
+  ['effectivement', 'clairement', 'notamment', 'en fait', 'de plus', 'ainsi', 'cependant'],
+  ['toutefois', 'néanmoins', 'en revanche', 'en outre', 'de même', 'également'],
 ];
 
-const TRANSITION_PATTERNS_EN = [
-  /\b(therefore|however|moreover|furthermore|additionally|consequently)\b/gi,
-  /\b(meanwhile|nevertheless|although|besides|hence|thus|accordingly)\b/gi,
-  /\b(in fact|actually|basically|essentially|specifically|particularly)\b/gi,
+const TRANSITION_PHRASES_EN = [
+  ['therefore', 'however', 'moreover', 'furthermore', 'additionally', 'consequently'],
+  ['meanwhile', 'nevertheless', 'although', 'besides', 'hence', 'thus', 'accordingly'],
+  ['in fact', 'actually', 'basically', 'essentially', 'specifically', 'particularly'],
 ];
 
+type PatternMode = 'start' | 'first' | 'words';
+
+interface StylePatternGroup {
+  category: keyof StyleProfilePatterns;
+  // 'start': the phrase the text begins with; 'first': the leftmost
+  // occurrence; 'words': every whole-word occurrence.
+  mode: PatternMode;
+  phrases: string[];
+}
+
+const PATTERN_GROUPS: StylePatternGroup[] = [
+  ...[...GREETING_PHRASES_FR, ...GREETING_PHRASES_EN].map(
+    (phrases): StylePatternGroup => ({ category: 'greetings', mode: 'start', phrases })
+  ),
+  ...[...CLOSING_PHRASES_FR, ...CLOSING_PHRASES_EN].map(
+    (phrases): StylePatternGroup => ({ category: 'closings', mode: 'first', phrases })
+  ),
+  ...[...TRANSITION_PHRASES_FR, ...TRANSITION_PHRASES_EN].map(
+    (phrases): StylePatternGroup => ({ category: 'transitions', mode: 'words', phrases })
+  ),
+];
+
+function patternRegex({ mode, phrases }: StylePatternGroup): RegExp {
+  const alternatives = phrases
+    .map((phrase) => phrase.replace(/[.*+?^${}()|[\]\\]/g, '\\$&').replace(/ /g, '\\s+'))
+    .join('|');
+  switch (mode) {
+    case 'start':
+      return new RegExp(`^(${alternatives})\\b`, 'i');
+    case 'first':
+      return new RegExp(`(${alternatives})`, 'i');
+    case 'words':
+      return new RegExp(`\\b(${alternatives})\\b`, 'gi');
+  }
+}
+
+const PATTERN_REGEXES = PATTERN_GROUPS.map(patternRegex);
+
+function matchPatterns(text: string): string[][] {
+  return PATTERN_REGEXES.map((pattern) => {
+    const matches = text.match(pattern);
+    if (!matches) return [];
+    return pattern.global ? [...matches] : [matches[0]];
+  });
+}
+
+interface NativeTextMetrics {
+  sentenceCount: number;
+  wordCount: number;
+  averageSentenceLength: number;
+  uniqueWordCount: number;
+  punctuationUsage: TextMetrics['punctuationUsage'];
+  patternMatches: string[][];
+}
+
+interface NativeModule {
+  setTextPatterns: (groups: { mode: PatternMode; phrases: string[] }[]) => number;
+  analyzeTextMetrics: (text: string) => NativeTextMetrics;
+}
+
+let native: NativeModule | null = null;
+
+try {
+  native = require('../../../native') as NativeModule;
+  native.setTextPatterns(PATTERN_GROUPS.map(({ mode, phrases }) => ({ mode, phrases })));
+} catch (e) {
+  native = null;
+  console.warn('Native module not available, style samples will be measured in JS');
+}
+
+interface SampleAnalysis {
+  metrics: TextMetrics;
+  // What each PATTERN_GROUPS entry matched, as written.
+  patternMatches: string[][];
+}
+
 const MAX_SAMPLES = 100;
 const MAX_FREQUENT_WORDS = 100;
 const MAX_PATTERNS_PER_CATEGORY = 20;
@@ -80,13 +158,35 @@ export class StyleLearner {
   }
 
   analyzeText(text: string): TextMetrics {
+    return this.analyzeSample(text).metrics;
+  }
+
+  // One native pass counts sentences, words and punctuation and matches
+  // every pattern group; without the addon each is a separate regex scan.
+  private analyzeSample(text: string): SampleAnalysis {
+    if (native) {
+      try {
+        const { patternMatches, ...counts } = native.analyzeTextMetrics(text);
+        return {
+          metrics: { ...counts, formalityIndicators: this.detectFormality(text) },
+          patternMatches,
+        };
+      } catch (e) {
+        console.error('Native text metrics failed:', e);
+        native = null;
+      }
+    }
+
     return {
-      sentenceCount: this.countSentences(text),
-      wordCount: this.countWords(text),
-      averageSentenceLength: this.calculateAvgSentenceLength(text),
-      uniqueWords: this.getUniqueWords(text),
-      punctuationUsage: this.analyzePunctuation(text),
-      formalityIndicators: this.detectFormality(text),
+      metrics: {
+        sentenceCount: this.countSentences(text),
+        wordCount: this.countWords(text),
+        averageSentenceLength: this.calculateAvgSentenceLength(text),
+        uniqueWordCount: this.getUniqueWords(text).size,
+        punctuationUsage: this.analyzePunctuation(text),
+        formalityIndicators: this.detectFormality(text),
+      },
+      patternMatches: matchPatterns(text),
     };
   }
 
@@ -188,10 +288,10 @@ export class StyleLearner {
   async learnFromSample(text: string, context: string): Promise<void> {
     if (!text || text.trim().length < 20) return;
 
-    const metrics = this.analyzeText(text);
+    const { metrics, patternMatches } = this.analyzeSample(text);
 
     this.updateMetrics(metrics);
-    this.extractPatterns(text);
+    this.extractPatterns(patternMatches);
     this.updateVocabulary(text);
     this.addSampleText(text, context);
     this.updateConfidenceScore();
@@ -231,9 +331,8 @@ export class StyleLearner {
       this.profile.metrics.averageSentenceLength * existingWeight +
       metrics.averageSentenceLength * weight;
 
-    const uniqueWordsCount = metrics.uniqueWords.size;
     const wordCount = metrics.wordCount || 1;
-    const newVocabRichness = uniqueWordsCount / wordCount;
+    const newVocabRichness = metrics.uniqueWordCount / wordCount;
     this.profile.metrics.vocabularyRichness =
       this.profile.metrics.vocabularyRichness * existingWeight +
       newVocabRichness * weight;
@@ -255,29 +354,12 @@ export class StyleLearner {
       metrics.punctuationUsage.ellipsisUsage * weight;
   }
 
-  private extractPatterns(text: string): void {
-    for (const pattern of [...GREETING_PATTERNS_FR, ...GREETING_PATTERNS_EN]) {
-      const match = text.match(pattern);
-      if (match) {
-        this.addToPatterns('greetings', match[0]);
-      }
-    }
-
-    for (const pattern of [...CLOSING_PATTERNS_FR, ...CLOSING_PATTERNS_EN]) {
-      const match = text.match(pattern);
-      if (match) {
-        this.addToPatterns('closings', match[0]);
+  private extractPatterns(patternMatches: string[][]): void {
+    PATTERN_GROUPS.forEach(({ category }, i) => {
+      for (const match of patternMatches[i] || []) {
+        this.addToPatterns(category, match);
       }
-    }
-
-    for (const pattern of [...TRANSITION_PATTERNS_FR, ...TRANSITION_PATTERNS_EN]) {
-      const matches = text.match(pattern);
-      if (matches) {
-        for (const match of matches) {
-          this.addToPatterns('transitions', match);
-        }
-      }
-    }
+    });
   }
 
   private addToPatterns(
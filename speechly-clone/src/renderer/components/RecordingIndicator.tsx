@@ -14,6 +14,7 @@ const MODE_LABELS: Record<RecordingTriggerMode, string> = {
   'double-tap': 'Double-tap pour arrêter',
   'hold': 'Relâchez pour arrêter',
   'toggle': 'Appuyez pour arrêter',
+  'gesture': 'Répétez le geste pour arrêter',
 };
 
 export const RecordingIndicator: React.FC<RecordingIndicatorProps> = ({
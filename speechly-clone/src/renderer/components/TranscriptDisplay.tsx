@@ -4,12 +4,14 @@ interface TranscriptDisplayProps {
   transcript: string;
   interimTranscript: string;
   isListening: boolean;
+  snippetPreview?: string | null;
 }
 
 export const TranscriptDisplay: React.FC<TranscriptDisplayProps> = ({
   transcript,
   interimTranscript,
   isListening,
+  snippetPreview,
 }) => {
   const hasContent = transcript || interimTranscript;
 
@@ -44,6 +46,11 @@ export const TranscriptDisplay: React.FC<TranscriptDisplayProps> = ({
               : 'Click the microphone to start dictating.'}
           </p>
         )}
+        {hasContent && snippetPreview && (
+          <p className="mt-3 pt-3 border-t border-bg-tertiary text-sm text-text-secondary leading-relaxed whitespace-pre-wrap">
+            {snippetPreview}
+          </p>
+        )}
       </div>
     </div>
   );
@@ -20,6 +20,7 @@ export const Home: React.FC = () => {
   const [manualContext, setManualContext] = useState<DetectedContext | null>(null);
   const [snippetReplacements, setSnippetReplacements] = useState<SnippetReplacement[]>([]);
   const [showSnippetNotification, setShowSnippetNotification] = useState(false);
+  const [snippetPreview, setSnippetPreview] = useState<string | null>(null);
   const [translatedText, setTranslatedText] = useState('');
   const [isTranslating, setIsTranslating] = useState(false);
   const [translationError, setTranslationError] = useState<string | null>(null);
@@ -71,6 +72,30 @@ export const Home: React.FC = () => {
     }
   }, [settings?.defaultDictationMode, settings?.alwaysUseAutoMode, setCurrentMode]);
 
+  // Interim results only append to what the main process has already
+  // scanned, so previewing on every result stays cheap.
+  useEffect(() => {
+    const liveText = transcript + interimTranscript;
+    if (!isListening || !liveText) {
+      setSnippetPreview(null);
+      return;
+    }
+
+    let cancelled = false;
+    window.electronAPI
+      .previewSnippets(liveText)
+      .then((result) => {
+        if (!cancelled) {
+          setSnippetPreview(result.replacements.length > 0 ? result.processedText : null);
+        }
+      })
+      .catch((error) => console.error('Snippet preview error:', error));
+
+    return () => {
+      cancelled = true;
+    };
+  }, [transcript, interimTranscript, isListening]);
+
   const detectContextBeforeDictation = useCallback(async () => {
     setIsDetectingContext(true);
     try {
@@ -517,6 +542,7 @@ export const Home: React.FC = () => {
             transcript={transcript}
             interimTranscript={interimTranscript}
             isListening={isListening}
+            snippetPreview={snippetPreview}
           />
           <CleanupPreview
             cleanedText={cleanedText}
@@ -460,6 +460,42 @@ export const Settings: React.FC = () => {
             </div>
           )}
 
+          {settings.recording?.triggerMode === 'gesture' && (
+            <div>
+              <label className="block text-sm font-medium text-text-primary mb-2">
+                Geste
+              </label>
+              <input
+                type="text"
+                value={settings.recording?.gesture ?? DEFAULT_RECORDING_SETTINGS.gesture}
+                onChange={(e) => {
+                  updateSettings({
+                    recording: {
+                      ...DEFAULT_RECORDING_SETTINGS,
+                      ...settings.recording,
+                      gesture: e.target.value,
+                    },
+                  });
+                }}
+                onBlur={(e) => {
+                  const newRecording = {
+                    ...DEFAULT_RECORDING_SETTINGS,
+                    ...settings.recording,
+                    gesture: e.target.value,
+                  };
+                  window.electronAPI.updateRecordingSettings(newRecording);
+                }}
+                className="w-full bg-bg-tertiary text-text-primary border border-bg-tertiary rounded-lg px-4 py-3
+                          focus:border-accent-purple focus:outline-none"
+              />
+              <p className="text-xs text-text-secondary mt-1">
+                Étapes séparées par « , » ou « then », touches d'un accord jointes par « + », suffixe tap/hold
+                (ex. « Ctrl,Ctrl », « Alt+Shift hold », « Ctrl then Space within 200ms »). Un geste finissant par
+                hold enregistre tant que les touches sont maintenues.
+              </p>
+            </div>
+          )}
+
           <div className="border-t border-bg-tertiary pt-4 mt-4">
             <div className="flex items-center justify-between">
               <div>
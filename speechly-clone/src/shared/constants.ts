@@ -244,6 +244,7 @@ export const DEFAULT_RECORDING_SETTINGS: RecordingSettings = {
   doubleTapKey: 'ctrl' as TriggerKey,
   doubleTapThreshold: 300,
   holdKey: 'ctrl' as TriggerKey,
+  gesture: 'Ctrl tap-tap-hold',
   toggleHotkey: 'CommandOrControl+Shift+Space',
   autoStopAfterSilence: false,
   silenceThreshold: 3,
@@ -253,6 +254,7 @@ export const RECORDING_TRIGGER_MODES: { value: RecordingTriggerMode; label: stri
   { value: 'double-tap', label: 'Double-tap (recommandé)', description: 'Appuyez deux fois rapidement pour démarrer/arrêter' },
   { value: 'hold', label: 'Maintenir une touche', description: 'Maintenez la touche pour enregistrer' },
   { value: 'toggle', label: 'Raccourci clavier', description: 'Utilisez un raccourci pour basculer' },
+  { value: 'gesture', label: 'Geste personnalisé', description: 'Combinez taps, accords et maintien (ex. Ctrl tap-tap-hold)' },
 ];
 
 export const TRIGGER_KEY_OPTIONS: { value: TriggerKey; label: string }[] = [
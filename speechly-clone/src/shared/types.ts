@@ -59,7 +59,7 @@ export interface TextMetrics {
   sentenceCount: number;
   wordCount: number;
   averageSentenceLength: number;
-  uniqueWords: Set<string>;
+  uniqueWordCount: number;
   punctuationUsage: {
     semicolonUsage: number;
     exclamationUsage: number;
@@ -112,7 +112,7 @@ export const DEFAULT_STYLE_LEARNING_SETTINGS: StyleLearningSettings = {
   contextSpecificLearning: false,
 };
 
-export type RecordingTriggerMode = 'double-tap' | 'hold' | 'toggle';
+export type RecordingTriggerMode = 'double-tap' | 'hold' | 'toggle' | 'gesture';
 
 export type TriggerKey = 'ctrl' | 'alt' | 'shift' | 'capslock' | 'fn';
 
@@ -121,11 +121,21 @@ export interface RecordingSettings {
   doubleTapKey: TriggerKey;
   doubleTapThreshold: number;
   holdKey: TriggerKey;
+  // Native gesture spec, e.g. "Ctrl,Ctrl", "Alt+Shift hold",
+  // "Ctrl tap-tap-hold" or "Ctrl then Space within 200ms".
+  gesture: string;
   toggleHotkey: string;
   autoStopAfterSilence: boolean;
   silenceThreshold: number;
 }
 
+// When the triggering key was physically pressed, on the process.hrtime()
+// clock in ms, and how long the event took to reach the main process.
+export interface RecordingStartInfo {
+  keyTimestamp: number;
+  keyAgeMs: number;
+}
+
 export type FormalityLevel = 'formal' | 'neutral' | 'informal';
 
 export interface TranslationSettings {
@@ -483,6 +493,7 @@ export interface ElectronAPI {
   findSnippetByTrigger: (text: string) => Promise<Snippet | null>;
   incrementSnippetUsage: (id: string) => Promise<void>;
   processSnippets: (text: string) => Promise<SnippetProcessResult>;
+  previewSnippets: (text: string) => Promise<SnippetProcessResult>;
   copyToClipboard: (text: string) => Promise<void>;
   getVersion: () => Promise<string>;
   cleanupTranscript: (text: string, options: CleanupOptions) => Promise<CleanupResult>;
@@ -501,7 +512,7 @@ export interface ElectronAPI {
   removeNavigateListener: () => void;
   onToggleDictation: (callback: () => void) => void;
   removeToggleDictationListener: () => void;
-  onRecordingStart: (callback: () => void) => void;
+  onRecordingStart: (callback: (info?: RecordingStartInfo) => void) => void;
   removeRecordingStartListener: () => void;
   onRecordingStop: (callback: () => void) => void;
   removeRecordingStopListener: () => void;
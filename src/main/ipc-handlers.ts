@@ -1,10 +1,14 @@
 import { ipcMain, BrowserWindow, globalShortcut, app } from 'electron';
+import { join } from 'path';
 import {
   getActiveWindow,
   startWindowWatcher,
   stopWindowWatcher,
-  injectText,
-  injectTextWithDelay,
+  injectTextAsync,
+  injectTextWithDelayAsync,
+  cancelAllInjections,
+  setInjectionStatsPath,
+  getInjectionStats,
   pasteFromClipboard,
   setClipboardText,
   getClipboardText,
@@ -14,8 +18,9 @@ import {
   parseAccelerator,
   getPlatform,
   isNativeModuleAvailable,
-  ActiveWindowInfo,
+  AppContextMatch,
   InjectionMethod,
+  WatchedWindowInfo,
 } from './native-bridge';
 
 let mainWindow: BrowserWindow | null = null;
@@ -27,6 +32,10 @@ export function setMainWindow(window: BrowserWindow): void {
 }
 
 export function initializeIpcHandlers(): void {
+  if (isNativeModuleAvailable()) {
+    setInjectionStatsPath(join(app.getPath('userData'), 'injection-stats.tsv'));
+  }
+
   ipcMain.handle('native:isAvailable', () => {
     return isNativeModuleAvailable();
   });
@@ -44,11 +53,18 @@ export function initializeIpcHandlers(): void {
       return true;
     }
 
-    const success = startWindowWatcher((info: ActiveWindowInfo) => {
-      if (mainWindow && !mainWindow.isDestroyed()) {
-        mainWindow.webContents.send('native:windowChanged', info);
+    const success = startWindowWatcher(
+      (info: WatchedWindowInfo) => {
+        if (mainWindow && !mainWindow.isDestroyed()) {
+          mainWindow.webContents.send('native:windowChanged', info);
+        }
+      },
+      (title: string, context?: AppContextMatch) => {
+        if (mainWindow && !mainWindow.isDestroyed()) {
+          mainWindow.webContents.send('native:windowTitleChanged', title, context);
+        }
       }
-    });
+    );
 
     windowWatcherActive = success;
     return success;
@@ -64,17 +80,25 @@ export function initializeIpcHandlers(): void {
   ipcMain.handle(
     'native:injectText',
     (event, text: string, method?: InjectionMethod) => {
-      return injectText(text, method);
+      return injectTextAsync(text, method);
     }
   );
 
   ipcMain.handle(
     'native:injectTextWithDelay',
     (event, text: string, delayMs: number) => {
-      return injectTextWithDelay(text, delayMs);
+      return injectTextWithDelayAsync(text, delayMs);
     }
   );
 
+  ipcMain.handle('native:cancelInjections', () => {
+    return cancelAllInjections();
+  });
+
+  ipcMain.handle('native:getInjectionStats', () => {
+    return getInjectionStats();
+  });
+
   ipcMain.handle('native:pasteFromClipboard', () => {
     return pasteFromClipboard();
   });
@@ -10,27 +10,188 @@ export interface ActiveWindowInfo {
   isValid: boolean;
 }
 
+export type AppContextRuleKind =
+  | 'process'
+  | 'bundle'
+  | 'web'
+  | 'browserProcess'
+  | 'browserBundle';
+
+export interface AppContextRule {
+  kind: AppContextRuleKind;
+  context: string;
+  appName: string;
+  pattern: string;
+}
+
+export interface AppContextMatch {
+  ruleIndex: number;
+  context: string;
+  appName: string;
+  confidence: 'high' | 'medium' | 'low';
+}
+
+export interface SnippetDefinition {
+  id: string;
+  triggers: string[];
+  value: string;
+}
+
+/** A trigger occurrence; start and end are JS string offsets. */
+export interface SnippetMatch {
+  id: string;
+  value: string;
+  start: number;
+  end: number;
+}
+
+export interface SnippetStreamResult {
+  /** Matches decided since the previous append; they never change again. */
+  committed: SnippetMatch[];
+  /** How the undecided tail resolves if the text ended here. */
+  pending: SnippetMatch[];
+  /** Total text length fed so far. */
+  length: number;
+}
+
+export interface LanguageHint {
+  language: string;
+  words: string[];
+  weight: number;
+}
+
+export interface ScriptHistogram {
+  /** Characters per script, indexed like getScriptNames(). */
+  scripts: number[];
+  /** Summed weight of each hint's words, indexed like the hints last set. */
+  hintScores: number[];
+}
+
+export interface LanguageModelStatus {
+  loaded: boolean;
+  languages: number;
+  error?: string;
+}
+
+export interface LanguageGuess {
+  language: string;
+  confidence: number;
+}
+
+export interface TextPatternGroup {
+  mode: 'start' | 'first' | 'words';
+  phrases: string[];
+}
+
+export interface TextMetricsResult {
+  sentenceCount: number;
+  wordCount: number;
+  averageSentenceLength: number;
+  uniqueWordCount: number;
+  punctuationUsage: {
+    semicolonUsage: number;
+    exclamationUsage: number;
+    ellipsisUsage: number;
+  };
+  patternMatches: string[][];
+}
+
+export interface WatchedWindowInfo extends ActiveWindowInfo {
+  context?: AppContextMatch;
+}
+
 export interface InjectionResult {
   success: boolean;
   error: string;
 }
 
+export interface InjectionPromise extends Promise<InjectionResult> {
+  injectionId: number;
+}
+
+export interface InjectionAppStats {
+  processName: string;
+  clipboardSamples: number;
+  clipboardLatencyMs: number;
+  clipboardSuccessRate: number;
+  directSamples: number;
+  directPerCharMs: number;
+  directSuccessRate: number;
+}
+
 export interface HotkeyInfo {
   modifiers: number;
   keyCode: number;
   accelerator: string;
 }
 
+export interface DisplayPoolStats {
+  opened: number;
+  acquired: number;
+  avoidedOpens: number;
+  live: number;
+}
+
+export type NativeLatencyStage =
+  | 'eventReceipt'
+  | 'detectorDecision'
+  | 'tsfEnqueue'
+  | 'injectionEnqueue'
+  | 'jsDispatch'
+  | 'clipboardWrite'
+  | 'pasteSimulate'
+  | 'windowInfo';
+
+/** Percentiles and max are in microseconds. */
+export interface LatencySummary {
+  count: number;
+  p50: number;
+  p95: number;
+  p99: number;
+  max: number;
+}
+
+export interface NativeMetrics {
+  stages: Record<NativeLatencyStage, LatencySummary>;
+  droppedEvents: number;
+}
+
+export type InputBackendName = 'x11' | 'evdev' | 'auto';
+
 export type InjectionMethod = 'clipboard' | 'direct' | 'auto';
-export type WindowChangeCallback = (info: ActiveWindowInfo) => void;
-export type HotkeyCallback = () => void;
+export type WindowChangeCallback = (info: WatchedWindowInfo) => void;
+export type WindowTitleCallback = (title: string, context?: AppContextMatch) => void;
+// Event timestamps are milliseconds on the monotonic clock behind
+// process.hrtime(), taken from the OS input event rather than delivery time.
+export type HotkeyCallback = (timestamp: number) => void;
+export type DoubleTapEvent = 'double-tap';
+export type HoldEvent = 'hold-start' | 'hold-end';
+export type GestureEvent = 'gesture' | 'hold-start' | 'hold-end';
+export type NativeEvent =
+  | { type: 'hotkey'; id: number; timestamp: number }
+  | { type: 'double-tap'; id: number; event: DoubleTapEvent; timestamp: number }
+  | { type: 'hold'; id: number; event: HoldEvent; duration: number; timestamp: number }
+  | { type: 'gesture'; id: number; event: GestureEvent; duration: number; timestamp: number }
+  | { type: 'window-change'; info: WatchedWindowInfo }
+  | { type: 'window-title'; title: string; context?: AppContextMatch };
+
+export type NativeEventsCallback = (batch: NativeEvent[]) => void;
 
 interface NativeModule {
   getActiveWindow(): ActiveWindowInfo;
-  startWindowWatcher(callback: WindowChangeCallback): boolean;
+  startWindowWatcher(
+    callback: WindowChangeCallback,
+    onTitleChange?: WindowTitleCallback
+  ): boolean;
   stopWindowWatcher(): void;
   injectText(text: string, method?: InjectionMethod): InjectionResult;
   injectTextWithDelay(text: string, delayMs: number): InjectionResult;
+  injectTextAsync(text: string, method?: InjectionMethod): InjectionPromise;
+  injectTextWithDelayAsync(text: string, delayMs: number): InjectionPromise;
+  cancelInjection(id: number): boolean;
+  cancelAllInjections(): number;
+  setInjectionStatsPath(path: string): boolean;
+  getInjectionStats(): InjectionAppStats[];
   pasteFromClipboard(): InjectionResult;
   setClipboardText(text: string): boolean;
   getClipboardText(): string;
@@ -39,7 +200,32 @@ interface NativeModule {
   unregisterHotkey(id: number): boolean;
   unregisterAllHotkeys(): void;
   parseAccelerator(accelerator: string): HotkeyInfo;
+  onNativeEvents(callback: NativeEventsCallback | null): void;
+  setAppContexts(rules: AppContextRule[]): number;
+  compileSnippets(snippets: SnippetDefinition[]): number;
+  matchSnippets(text: string): SnippetMatch[];
+  createSnippetStream(): number;
+  snippetStreamAppend(stream: number, delta: string, final?: boolean): SnippetStreamResult;
+  snippetStreamReset(stream: number): boolean;
+  closeSnippetStream(stream: number): boolean;
+  setContextDictionary(contextId: string, replacements: Record<string, string>): number;
+  rewriteWithDictionary(contextId: string, text: string): string | null;
+  setLanguageHints(hints: LanguageHint[]): number;
+  detectScripts(text: string): ScriptHistogram;
+  getScriptNames(): string[];
+  loadLanguageModel(path: string): LanguageModelStatus;
+  identifyLanguage(text: string, maxResults?: number): LanguageGuess[];
+  setTextPatterns(groups: TextPatternGroup[]): number;
+  analyzeTextMetrics(text: string): TextMetricsResult;
+  matchAppContext(
+    info: Pick<ActiveWindowInfo, 'title' | 'processName' | 'bundleId'>
+  ): AppContextMatch | null;
   getPlatform(): 'win32' | 'darwin' | 'linux' | 'unknown';
+  setInputBackend(name: InputBackendName): boolean;
+  getInputBackend(): 'x11' | 'evdev' | 'native';
+  getDisplayPoolStats(): DisplayPoolStats;
+  getNativeMetrics(): NativeMetrics;
+  resetNativeMetrics(): void;
 }
 
 let nativeModule: NativeModule | null = null;
@@ -122,10 +308,15 @@ export function getActiveWindow(): ActiveWindowInfo | null {
   }
 }
 
-export function startWindowWatcher(callback: WindowChangeCallback): boolean {
+export function startWindowWatcher(
+  callback: WindowChangeCallback,
+  onTitleChange?: WindowTitleCallback
+): boolean {
   try {
     const native = loadNativeModule();
-    return native.startWindowWatcher(callback);
+    return onTitleChange
+      ? native.startWindowWatcher(callback, onTitleChange)
+      : native.startWindowWatcher(callback);
   } catch (error) {
     console.error('Failed to start window watcher:', error);
     return false;
@@ -171,6 +362,76 @@ export function injectTextWithDelay(
   }
 }
 
+export function injectTextAsync(
+  text: string,
+  method: InjectionMethod = 'auto'
+): Promise<InjectionResult> {
+  try {
+    const native = loadNativeModule();
+    return native.injectTextAsync(text, method);
+  } catch (error) {
+    return Promise.resolve({
+      success: false,
+      error: error instanceof Error ? error.message : String(error),
+    });
+  }
+}
+
+export function injectTextWithDelayAsync(
+  text: string,
+  delayMs: number
+): Promise<InjectionResult> {
+  try {
+    const native = loadNativeModule();
+    return native.injectTextWithDelayAsync(text, delayMs);
+  } catch (error) {
+    return Promise.resolve({
+      success: false,
+      error: error instanceof Error ? error.message : String(error),
+    });
+  }
+}
+
+export function cancelInjection(id: number): boolean {
+  try {
+    const native = loadNativeModule();
+    return native.cancelInjection(id);
+  } catch (error) {
+    console.error('Failed to cancel injection:', error);
+    return false;
+  }
+}
+
+export function cancelAllInjections(): number {
+  try {
+    const native = loadNativeModule();
+    return native.cancelAllInjections();
+  } catch (error) {
+    console.error('Failed to cancel injections:', error);
+    return 0;
+  }
+}
+
+export function setInjectionStatsPath(path: string): boolean {
+  try {
+    const native = loadNativeModule();
+    return native.setInjectionStatsPath(path);
+  } catch (error) {
+    console.error('Failed to set injection stats path:', error);
+    return false;
+  }
+}
+
+export function getInjectionStats(): InjectionAppStats[] {
+  try {
+    const native = loadNativeModule();
+    return native.getInjectionStats();
+  } catch (error) {
+    console.error('Failed to get injection stats:', error);
+    return [];
+  }
+}
+
 export function pasteFromClipboard(): InjectionResult {
   try {
     const native = loadNativeModule();
@@ -257,6 +518,187 @@ export function parseAccelerator(accelerator: string): HotkeyInfo {
   }
 }
 
+export function onNativeEvents(callback: NativeEventsCallback | null): boolean {
+  try {
+    const native = loadNativeModule();
+    native.onNativeEvents(callback);
+    return true;
+  } catch (error) {
+    console.error('Failed to set native event handler:', error);
+    return false;
+  }
+}
+
+export function setAppContexts(rules: AppContextRule[]): number {
+  try {
+    const native = loadNativeModule();
+    return native.setAppContexts(rules);
+  } catch (error) {
+    console.error('Failed to compile app contexts:', error);
+    return -1;
+  }
+}
+
+export function matchAppContext(
+  info: Pick<ActiveWindowInfo, 'title' | 'processName' | 'bundleId'>
+): AppContextMatch | null {
+  try {
+    const native = loadNativeModule();
+    return native.matchAppContext(info);
+  } catch {
+    return null;
+  }
+}
+
+export function compileSnippets(snippets: SnippetDefinition[]): number {
+  try {
+    const native = loadNativeModule();
+    return native.compileSnippets(snippets);
+  } catch (error) {
+    console.error('Failed to compile snippets:', error);
+    return -1;
+  }
+}
+
+export function matchSnippets(text: string): SnippetMatch[] | null {
+  try {
+    const native = loadNativeModule();
+    return native.matchSnippets(text);
+  } catch {
+    return null;
+  }
+}
+
+export function setContextDictionary(contextId: string, replacements: Record<string, string>): number {
+  try {
+    const native = loadNativeModule();
+    return native.setContextDictionary(contextId, replacements);
+  } catch (error) {
+    console.error('Failed to compile context dictionary:', error);
+    return -1;
+  }
+}
+
+export function rewriteWithDictionary(contextId: string, text: string): string | null {
+  try {
+    const native = loadNativeModule();
+    return native.rewriteWithDictionary(contextId, text);
+  } catch {
+    return null;
+  }
+}
+
+export function setLanguageHints(hints: LanguageHint[]): number {
+  try {
+    const native = loadNativeModule();
+    return native.setLanguageHints(hints);
+  } catch (error) {
+    console.error('Failed to set language hints:', error);
+    return -1;
+  }
+}
+
+export function detectScripts(text: string): ScriptHistogram | null {
+  try {
+    const native = loadNativeModule();
+    return native.detectScripts(text);
+  } catch {
+    return null;
+  }
+}
+
+export function getScriptNames(): string[] {
+  try {
+    const native = loadNativeModule();
+    return native.getScriptNames();
+  } catch {
+    return [];
+  }
+}
+
+export function loadLanguageModel(path: string): LanguageModelStatus {
+  try {
+    const native = loadNativeModule();
+    return native.loadLanguageModel(path);
+  } catch (error) {
+    return { loaded: false, languages: 0, error: String(error) };
+  }
+}
+
+export function identifyLanguage(text: string, maxResults = 3): LanguageGuess[] | null {
+  try {
+    const native = loadNativeModule();
+    return native.identifyLanguage(text, maxResults);
+  } catch {
+    return null;
+  }
+}
+
+export function setTextPatterns(groups: TextPatternGroup[]): number {
+  try {
+    const native = loadNativeModule();
+    return native.setTextPatterns(groups);
+  } catch {
+    return -1;
+  }
+}
+
+export function analyzeTextMetrics(text: string): TextMetricsResult | null {
+  try {
+    const native = loadNativeModule();
+    return native.analyzeTextMetrics(text);
+  } catch {
+    return null;
+  }
+}
+
+// Matches text that grows over time. Callers pass the whole current text;
+// only the part past what was already fed is sent to the native stream, and
+// the stream starts over when earlier text was revised.
+export class SnippetStream {
+  private handle: number | null = null;
+  private fed = '';
+  private committed: SnippetMatch[] = [];
+
+  update(text: string, final = false): SnippetMatch[] | null {
+    try {
+      const native = loadNativeModule();
+      if (this.handle === null) {
+        this.handle = native.createSnippetStream();
+      }
+
+      if (!text.startsWith(this.fed)) {
+        native.snippetStreamReset(this.handle);
+        this.fed = '';
+        this.committed = [];
+      }
+
+      const result = native.snippetStreamAppend(this.handle, text.slice(this.fed.length), final);
+      this.fed = final ? '' : text;
+      const matches = this.committed.concat(result.committed);
+      this.committed = final ? [] : matches;
+      if (final) {
+        native.snippetStreamReset(this.handle);
+      }
+      return matches.concat(result.pending);
+    } catch {
+      return null;
+    }
+  }
+
+  close(): void {
+    if (this.handle === null) return;
+    try {
+      loadNativeModule().closeSnippetStream(this.handle);
+    } catch {
+      // The module failed to load, so there is no stream to release.
+    }
+    this.handle = null;
+    this.fed = '';
+    this.committed = [];
+  }
+}
+
 export function getPlatform(): 'win32' | 'darwin' | 'linux' | 'unknown' {
   try {
     const native = loadNativeModule();
@@ -266,6 +708,51 @@ export function getPlatform(): 'win32' | 'darwin' | 'linux' | 'unknown' {
   }
 }
 
+export function setInputBackend(name: InputBackendName): boolean {
+  try {
+    const native = loadNativeModule();
+    return native.setInputBackend(name);
+  } catch {
+    return false;
+  }
+}
+
+export function getInputBackend(): 'x11' | 'evdev' | 'native' {
+  try {
+    const native = loadNativeModule();
+    return native.getInputBackend();
+  } catch {
+    return 'native';
+  }
+}
+
+export function getDisplayPoolStats(): DisplayPoolStats {
+  try {
+    const native = loadNativeModule();
+    return native.getDisplayPoolStats();
+  } catch {
+    return { opened: 0, acquired: 0, avoidedOpens: 0, live: 0 };
+  }
+}
+
+export function getNativeMetrics(): NativeMetrics | null {
+  try {
+    const native = loadNativeModule();
+    return native.getNativeMetrics();
+  } catch {
+    return null;
+  }
+}
+
+export function resetNativeMetrics(): void {
+  try {
+    const native = loadNativeModule();
+    native.resetNativeMetrics();
+  } catch (error) {
+    console.error('Failed to reset native metrics:', error);
+  }
+}
+
 export class WindowDetector {
   private callback: WindowChangeCallback | null = null;
   private watching = false;
@@ -274,13 +761,16 @@ export class WindowDetector {
     return getActiveWindow();
   }
 
-  onActiveWindowChange(callback: WindowChangeCallback): void {
+  onActiveWindowChange(
+    callback: WindowChangeCallback,
+    onTitleChange?: WindowTitleCallback
+  ): void {
     if (this.watching) {
       this.stopWatching();
     }
 
     this.callback = callback;
-    this.watching = startWindowWatcher(callback);
+    this.watching = startWindowWatcher(callback, onTitleChange);
   }
 
   stopWatching(): void {
@@ -297,18 +787,18 @@ export class WindowDetector {
 }
 
 export class TextInjector {
-  injectText(text: string): Promise<boolean> {
-    return new Promise((resolve) => {
-      const result = injectText(text);
-      resolve(result.success);
-    });
+  async injectText(text: string): Promise<boolean> {
+    const result = await injectTextAsync(text);
+    return result.success;
   }
 
-  injectTextWithDelay(text: string, delayMs: number): Promise<boolean> {
-    return new Promise((resolve) => {
-      const result = injectTextWithDelay(text, delayMs);
-      resolve(result.success);
-    });
+  async injectTextWithDelay(text: string, delayMs: number): Promise<boolean> {
+    const result = await injectTextWithDelayAsync(text, delayMs);
+    return result.success;
+  }
+
+  cancelAll(): number {
+    return cancelAllInjections();
   }
 
   pasteFromClipboard(): Promise<boolean> {
@@ -354,6 +844,12 @@ export default {
   stopWindowWatcher,
   injectText,
   injectTextWithDelay,
+  injectTextAsync,
+  injectTextWithDelayAsync,
+  cancelInjection,
+  cancelAllInjections,
+  setInjectionStatsPath,
+  getInjectionStats,
   pasteFromClipboard,
   setClipboardText,
   getClipboardText,
@@ -361,7 +857,27 @@ export default {
   unregisterHotkey,
   unregisterAllHotkeys,
   parseAccelerator,
+  onNativeEvents,
+  setAppContexts,
+  matchAppContext,
+  compileSnippets,
+  matchSnippets,
+  SnippetStream,
+  setContextDictionary,
+  rewriteWithDictionary,
+  setLanguageHints,
+  detectScripts,
+  getScriptNames,
+  loadLanguageModel,
+  identifyLanguage,
+  setTextPatterns,
+  analyzeTextMetrics,
   getPlatform,
+  setInputBackend,
+  getInputBackend,
+  getDisplayPoolStats,
+  getNativeMetrics,
+  resetNativeMetrics,
   isNativeModuleAvailable,
   loadNativeModule,
   Modifiers,
@@ -9,6 +9,17 @@ export interface ActiveWindowInfo {
   isValid: boolean;
 }
 
+export interface AppContextMatch {
+  ruleIndex: number;
+  context: string;
+  appName: string;
+  confidence: 'high' | 'medium' | 'low';
+}
+
+export interface WatchedWindowInfo extends ActiveWindowInfo {
+  context?: AppContextMatch;
+}
+
 export interface InjectionResult {
   success: boolean;
   error: string;
@@ -37,19 +48,34 @@ const nativeAPI = {
   stopWindowWatcher: (): Promise<void> =>
     ipcRenderer.invoke('native:stopWindowWatcher'),
 
-  onWindowChanged: (callback: (info: ActiveWindowInfo) => void): (() => void) => {
-    const handler = (_event: Electron.IpcRendererEvent, info: ActiveWindowInfo) =>
+  onWindowChanged: (callback: (info: WatchedWindowInfo) => void): (() => void) => {
+    const handler = (_event: Electron.IpcRendererEvent, info: WatchedWindowInfo) =>
       callback(info);
     ipcRenderer.on('native:windowChanged', handler);
     return () => ipcRenderer.removeListener('native:windowChanged', handler);
   },
 
+  onWindowTitleChanged: (
+    callback: (title: string, context?: AppContextMatch) => void
+  ): (() => void) => {
+    const handler = (
+      _event: Electron.IpcRendererEvent,
+      title: string,
+      context?: AppContextMatch
+    ) => callback(title, context);
+    ipcRenderer.on('native:windowTitleChanged', handler);
+    return () => ipcRenderer.removeListener('native:windowTitleChanged', handler);
+  },
+
   injectText: (text: string, method?: InjectionMethod): Promise<InjectionResult> =>
     ipcRenderer.invoke('native:injectText', text, method),
 
   injectTextWithDelay: (text: string, delayMs: number): Promise<InjectionResult> =>
     ipcRenderer.invoke('native:injectTextWithDelay', text, delayMs),
 
+  cancelInjections: (): Promise<number> =>
+    ipcRenderer.invoke('native:cancelInjections'),
+
   pasteFromClipboard: (): Promise<InjectionResult> =>
     ipcRenderer.invoke('native:pasteFromClipboard'),
 